@@ -0,0 +1,399 @@
+#define _GNU_SOURCE             // For sched_setaffinity().
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define DEFAULT_SIZES     "1000,100000"
+#define DEFAULT_REPS      11
+#define DEFAULT_WARMUP    2
+#define DEFAULT_THRESHOLD 10.0  // Percent slowdown flagged as a regression.
+
+#define MAX_SIZES         16
+#define MAX_BASELINE      4096
+#define KEY_SZ            192   // Fits "group/name/arg/size".
+
+enum format { BAD_FORMAT = -1, TEXT, CSV, JSON };
+
+struct result {
+	const struct bench *b;
+	size_t             size;
+	double             median;
+	double             max;
+	double             min;
+};
+
+/* A row of the baseline file. */
+struct baseline {
+	char   key[KEY_SZ];
+	double median;
+};
+
+static struct bench *groups[] = {
+	bench_rbtree, bench_fibheap, bench_radixheap, bench_hash, bench_hashfn,
+	bench_strmatch, bench_graph, bench_ulist, bench_concurrent, bench_topk,
+	bench_ohash, bench_art, bench_sarray, bench_sort, bench_extsort, NULL
+};
+
+static struct baseline baseline[MAX_BASELINE];
+static int nbaseline;
+
+static unsigned long long seed = 88172645463325252ULL;
+
+volatile unsigned long bench_sink;
+
+unsigned long bench_rand(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return (unsigned long) seed;
+}
+
+void bench_srand(unsigned long s)
+{
+	seed = s ? s : 88172645463325252ULL;
+}
+
+unsigned long *bench_keys(size_t n)
+{
+	unsigned long *keys = malloc(n * sizeof(unsigned long)), tmp;
+	size_t i, j;
+
+	for (i = 0; i < n; i++)
+		keys[i] = i + 1;
+
+	for (i = n; i > 1; i--) {
+		j           = bench_rand() % i;
+		tmp         = keys[i - 1];
+		keys[i - 1] = keys[j];
+		keys[j]     = tmp;
+	}
+
+	return keys;
+}
+
+char *bench_tmpfile(void)
+{
+	const char *dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+	char *path = malloc(strlen(dir) + sizeof("/algs-bench-XXXXXX"));
+	int fd;
+
+	sprintf(path, "%s/algs-bench-XXXXXX", dir);
+
+	if ((fd = mkstemp(path)) < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	close(fd);
+
+	return path;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *_a, const void *_b)
+{
+	double a = *(const double *) _a, b = *(const double *) _b;
+
+	return (a > b) - (a < b);
+}
+
+static void make_key(char *key, size_t sz, const struct bench *b, size_t size)
+{
+	snprintf(key, sz, "%s/%s/%d/%zu", b->group, b->name, b->arg, size);
+}
+
+/* Runs a benchmark for a single size. */
+static struct result measure(const struct bench *b, size_t size, int reps,
+			     int warmup)
+{
+	struct result r = { b, size, 0, 0, 0 };
+	double *t = malloc(reps * sizeof(double)), start;
+	void *ctx = NULL;
+	int i;
+
+	bench_srand(size);
+
+	if (b->reuse)
+		ctx = b->setup(size, b->arg);
+
+	for (i = -warmup; i < reps; i++) {
+		if (!b->reuse)
+			ctx = b->setup(size, b->arg);
+
+		start = now_ns();
+		b->run(ctx);
+
+		if (i >= 0)
+			t[i] = now_ns() - start;
+
+		if (!b->reuse)
+			b->teardown(ctx);
+	}
+
+	if (b->reuse)
+		b->teardown(ctx);
+
+	qsort(t, reps, sizeof(double), cmp_double);
+
+	/* The slowest run rather than a high percentile, which it would be
+	 * anyway with fewer than a hundred repetitions. */
+	r.median = t[reps / 2];
+	r.max    = t[reps - 1];
+	r.min    = t[0];
+
+	free(t);
+
+	return r;
+}
+
+static double gb_per_s(const struct result *r)
+{
+	return r->b->bytes ? r->b->bytes * r->size / r->median : 0;
+}
+
+static void print_result(const struct result *r, enum format fmt, int first)
+{
+	const struct bench *b = r->b;
+	double per_elem = r->median / r->size;
+
+	switch (fmt) {
+	case CSV:
+		printf("%s,%s,%d,%zu,%.0f,%.0f,%.0f,%.3f,%.3f\n", b->group,
+		       b->name, b->arg, r->size, r->median, r->max, r->min,
+		       per_elem, gb_per_s(r));
+		break;
+	case JSON:
+		printf("%s\n  {\"group\": \"%s\", \"name\": \"%s\", "
+		       "\"arg\": %d, \"size\": %zu, \"median_ns\": %.0f, "
+		       "\"max_ns\": %.0f, \"min_ns\": %.0f, "
+		       "\"ns_per_elem\": %.3f, \"gb_per_s\": %.3f}",
+		       first ? "" : ",", b->group, b->name, b->arg, r->size,
+		       r->median, r->max, r->min, per_elem, gb_per_s(r));
+		break;
+	default:
+		printf("%-10s %-20s %4d %10zu %14.0f %14.0f %10.2f", b->group,
+		       b->name, b->arg, r->size, r->median, r->max, per_elem);
+
+		if (b->bytes)
+			printf(" %8.2f GB/s", gb_per_s(r));
+
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+/* Reads the rows of a CSV file written with --format csv. */
+static int load_baseline(const char *path)
+{
+	char line[512], group[64], name[64];
+	unsigned long size;
+	double median;
+	int arg;
+	FILE *f = fopen(path, "r");
+
+	if (!f)
+		return -1;
+
+	while (fgets(line, sizeof(line), f) && nbaseline < MAX_BASELINE) {
+		if (sscanf(line, "%63[^,],%63[^,],%d,%lu,%lf", group, name, &arg,
+			   &size, &median) != 5)
+			continue;  // Header.
+
+		snprintf(baseline[nbaseline].key, sizeof(baseline[0].key),
+			 "%s/%s/%d/%lu", group, name, arg, size);
+		baseline[nbaseline++].median = median;
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+/* Returns non-zero if the result is slower than its baseline by more than the
+ * threshold (in percent.) */
+static int compare(const struct result *r, double threshold)
+{
+	char key[KEY_SZ];
+	double delta;
+	int i;
+
+	make_key(key, sizeof(key), r->b, r->size);
+
+	for (i = 0; i < nbaseline; i++) {
+		if (strcmp(key, baseline[i].key))
+			continue;
+
+		delta = 100 * (r->median - baseline[i].median) /
+			baseline[i].median;
+
+		if (delta > threshold) {
+			fprintf(stderr, "REGRESSION %s: %.0f ns -> %.0f ns "
+				"(%+.1f%%)\n", key, baseline[i].median,
+				r->median, delta);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	return 0;
+}
+
+static int pin(int cpu)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	return sched_setaffinity(0, sizeof(set), &set);
+}
+
+static enum format parse_format(const char *s)
+{
+	if (!strcmp(s, "text"))
+		return TEXT;
+	if (!strcmp(s, "csv"))
+		return CSV;
+	if (!strcmp(s, "json"))
+		return JSON;
+
+	return BAD_FORMAT;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"\n"
+		"  --sizes N,N,...   Input sizes (default " DEFAULT_SIZES ").\n"
+		"  --reps N          Timed repetitions (default %d).\n"
+		"  --warmup N        Untimed repetitions (default %d).\n"
+		"  --cpu N           Pins the benchmarks to CPU N, threads and "
+		"all:\n"
+		"                    multithreaded ones then share it.\n"
+		"  --filter STR      Runs only benchmarks whose group/name "
+		"contain STR.\n"
+		"  --format FMT      One of text, csv or json.\n"
+		"  --compare FILE    Flags regressions against a CSV baseline.\n"
+		"  --threshold PCT   Slowdown flagged as regression "
+		"(default %.0f).\n",
+		prog, DEFAULT_REPS, DEFAULT_WARMUP, DEFAULT_THRESHOLD);
+}
+
+int main(int argc, char **argv)
+{
+	const char *sizes_arg = DEFAULT_SIZES, *filter = NULL, *cmp = NULL;
+	size_t sizes[MAX_SIZES];
+	int i, j, nsizes = 0, reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+	int cpu = -1, first = 1, regressions = 0;
+	double threshold = DEFAULT_THRESHOLD;
+	enum format fmt = TEXT;
+	char key[KEY_SZ], *end;
+	struct bench *b;
+	struct result r;
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc) {
+			usage(argv[0]);
+			return 2;
+		}
+
+		if (!strcmp(argv[i], "--sizes"))
+			sizes_arg = argv[++i];
+		else if (!strcmp(argv[i], "--reps"))
+			reps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--warmup"))
+			warmup = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--cpu"))
+			cpu = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--filter"))
+			filter = argv[++i];
+		else if (!strcmp(argv[i], "--compare"))
+			cmp = argv[++i];
+		else if (!strcmp(argv[i], "--threshold"))
+			threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--format"))
+			fmt = parse_format(argv[++i]);
+		else
+			fmt = BAD_FORMAT;
+
+		if (fmt == BAD_FORMAT) {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	for (; nsizes < MAX_SIZES && *sizes_arg; sizes_arg = end) {
+		sizes[nsizes++] = strtoul(sizes_arg, &end, 10);
+
+		if (*end == ',')
+			end++;
+		else if (*end)
+			break;
+	}
+
+	if (reps < 1 || warmup < 0 || !nsizes) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	if (cpu >= 0 && pin(cpu))
+		perror("sched_setaffinity");
+
+	if (cmp && load_baseline(cmp)) {
+		perror(cmp);
+		return 2;
+	}
+
+	if (fmt == CSV)
+		printf("group,name,arg,size,median_ns,max_ns,min_ns,"
+		       "ns_per_elem,gb_per_s\n");
+	else if (fmt == JSON)
+		printf("[");
+	else
+		printf("%-10s %-20s %4s %10s %14s %14s %10s\n", "group", "name",
+		       "arg", "size", "median (ns)", "max (ns)", "ns/elem");
+
+	for (i = 0; groups[i]; i++) {
+		for (b = groups[i]; b->name; b++) {
+			make_key(key, sizeof(key), b, 0);
+
+			if (filter && !strstr(key, filter))
+				continue;
+
+			for (j = 0; j < nsizes; j++) {
+				r = measure(b, sizes[j], reps, warmup);
+				print_result(&r, fmt, first);
+				first = 0;
+
+				if (cmp)
+					regressions += compare(&r, threshold);
+			}
+		}
+	}
+
+	if (fmt == JSON)
+		printf("\n]\n");
+
+	if (regressions)
+		fprintf(stderr, "%d regression(s) found.\n", regressions);
+
+	return regressions ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * bench.h: Harness for benchmarking the algorithms and data structures in the
+ *          library, meant for catching performance regressions.
+ *
+ *          A benchmark is a _run_ function, timed as a whole, operating on a
+ *          context built by an untimed _setup_ function for a given input size
+ *          (and argument, such as a thread count or a pattern length.) Each
+ *          benchmark is warmed up, then repeated a number of times, and the
+ *          median, maximum and minimum of the repetitions reported, along
+ *          with the time per element and, where it applies, throughput.
+ *
+ *          Results can be printed as text, CSV or JSON. A CSV file produced
+ *          by an earlier run can be given as a baseline, in which case every
+ *          benchmark whose median got slower than the threshold is flagged as
+ *          a regression.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stddef.h>             // For size_t.
+
+/* Builds the context for input size n and argument arg. */
+typedef void *(*bench_setup)(size_t, int);
+
+typedef void (*bench_run)(void *);
+
+typedef void (*bench_teardown)(void *);
+
+struct bench {
+	const char     *group;
+	const char     *name;
+	int            arg;
+
+	bench_setup    setup;
+	bench_run      run;
+	bench_teardown teardown;
+
+	/* If set, the context is built once per size rather than once per
+	 * repetition, as run() leaves it as it was. */
+	int            reuse;
+
+	/* If set, bytes processed per element, for reporting throughput. */
+	size_t         bytes;
+};
+
+/* Benchmarks are grouped in arrays, terminated by an entry with no name. */
+#define BENCH_END { NULL, NULL, 0, NULL, NULL, NULL, 0, 0 }
+
+/* Shared by benchmarks for generating inputs deterministically. */
+unsigned long bench_rand(void);
+
+void bench_srand(unsigned long);
+
+/* Shuffled array holding 1..n, for use as keys. */
+unsigned long *bench_keys(size_t);
+
+/* Creates an empty scratch file, and returns its path. Callers remove the file
+ * and free the path. */
+char *bench_tmpfile(void);
+
+/* Keeps the compiler from optimizing away results. */
+extern volatile unsigned long bench_sink;
+
+extern struct bench bench_rbtree[];
+extern struct bench bench_fibheap[];
+extern struct bench bench_radixheap[];
+extern struct bench bench_hash[];
+extern struct bench bench_hashfn[];
+extern struct bench bench_strmatch[];
+extern struct bench bench_graph[];
+extern struct bench bench_ulist[];
+extern struct bench bench_concurrent[];
+extern struct bench bench_topk[];
+extern struct bench bench_ohash[];
+extern struct bench bench_art[];
+extern struct bench bench_sarray[];
+extern struct bench bench_sort[];
+extern struct bench bench_extsort[];
+
+#endif // BENCH_H_
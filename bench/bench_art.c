@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "art.h"
+#include "bench.h"
+#include "hash.h"
+#include "rbtree.h"
+
+/* Words are spelled out of syllables, one per base-16 digit of a distinct
+ * number, so that they share prefixes as real words do. */
+#define WORD_SZ 32
+
+static const char *syllables[16] = {
+	"a", "de", "con", "re", "in", "ter", "pro", "ta",
+	"ment", "tion", "es", "mo", "li", "qu", "ra", "ble"
+};
+
+/* The argument picks the structure: ART, red-black tree (comparing with
+ * strcmp()) or hash table. */
+enum { ART = 0, RBTREE, HASH };
+
+struct word {
+	struct list_head list;
+	char             str[WORD_SZ];
+	size_t           len;
+};
+
+struct ctx {
+	struct word       *words;
+	size_t            n;
+	int               kind;
+
+	struct art        *art;
+	struct rbtree     *t;
+	struct hash_table *ht;
+};
+
+static void spell(struct word *w, unsigned long x)
+{
+	char *p = w->str;
+
+	do {
+		p  += strlen(strcpy(p, syllables[x & 15]));
+		x >>= 4;
+	} while (x);
+
+	w->len = p - w->str;
+}
+
+static int rbtree_strcmp(const void *a, const void *b)
+{
+	return strcmp(a, b);
+}
+
+static int hash_strcmp(struct list_head *x, const void *word)
+{
+	return !strcmp(list_entry(x, struct word, list)->str, word);
+}
+
+static void insert(void *_c)
+{
+	struct ctx *c = _c;
+	struct word *w;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		w = &c->words[i];
+
+		if (c->kind == ART)
+			art_insert(c->art, w->str, w->len, w);
+		else if (c->kind == RBTREE)
+			rbtree_insert(c->t, make_rbtree_node(w->str));
+		else
+			hash_insert(c->ht, &w->list, w->str);
+	}
+}
+
+static void *setup(size_t n, int kind)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+	unsigned long *keys = bench_keys(n);
+	size_t i, sz = 1;
+
+	c->words = malloc(n * sizeof(struct word));
+	c->n     = n;
+	c->kind  = kind;
+
+	for (i = 0; i < n; i++)
+		spell(&c->words[i], keys[i]);
+
+	while (sz < n)
+		sz <<= 1;
+
+	if (kind == ART)
+		c->art = make_art();
+	else if (kind == RBTREE)
+		c->t = make_rbtree(rbtree_strcmp);
+	else
+		c->ht = make_hash_table(sz, hash_fn_string, hash_strcmp);
+
+	free(keys);
+
+	return c;
+}
+
+static void *setup_filled(size_t n, int kind)
+{
+	struct ctx *c = setup(n, kind);
+
+	insert(c);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	if (c->art)
+		art_destroy(c->art);
+
+	if (c->t)
+		rbtree_destroy(c->t);
+
+	if (c->ht) {
+		free(c->ht->table);
+		free(c->ht);
+	}
+
+	free(c->words);
+	free(c);
+}
+
+static void search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	struct word *w;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		w = &c->words[i];
+
+		if (c->kind == ART)
+			sum += (uintptr_t) art_search(c->art, w->str, w->len);
+		else if (c->kind == RBTREE)
+			sum += (uintptr_t) rbtree_search(c->t, w->str)->value;
+		else
+			sum += (uintptr_t) hash_search(c->ht, w->str);
+	}
+
+	bench_sink = sum;
+}
+
+static int count(struct art_leaf *l, void *sum)
+{
+	*(unsigned long *) sum += l->len;
+
+	return 0;
+}
+
+/* Visits the words starting with each of the 256 two-syllable prefixes. */
+static void prefix(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	struct word w;
+	unsigned long x;
+
+	for (x = 0; x < 256; x++) {
+		spell(&w, x | 256);
+		art_prefix_walk(c->art, w.str,
+				w.len - strlen(syllables[1]), count, &sum);
+	}
+
+	bench_sink = sum;
+}
+
+struct bench bench_art[] = {
+	{ "art", "insert", ART,    setup,        insert, teardown, 0, 0 },
+	{ "art", "insert", RBTREE, setup,        insert, teardown, 0, 0 },
+	{ "art", "insert", HASH,   setup,        insert, teardown, 0, 0 },
+	{ "art", "search", ART,    setup_filled, search, teardown, 1, 0 },
+	{ "art", "search", RBTREE, setup_filled, search, teardown, 1, 0 },
+	{ "art", "search", HASH,   setup_filled, search, teardown, 1, 0 },
+	{ "art", "prefix", ART,    setup_filled, prefix, teardown, 1, 0 },
+	BENCH_END
+};
@@ -0,0 +1,437 @@
+#define _POSIX_C_SOURCE 200809L // For pthreads.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "ebr.h"
+#include "lfqueue.h"
+#include "mqueue.h"
+#include "prbtree.h"
+#include "rbtree.h"
+#include "skiplist.h"
+
+#define MPMC_SZ 1024
+
+/* The argument of every benchmark here is the number of threads, each doing an
+ * equal share of the n ops. */
+struct ctx {
+	size_t           n;
+	int              nthreads;
+
+	struct mqueue    *mq;
+
+	struct skiplist  *sl;
+	struct rbtree    *t;
+	pthread_mutex_t  lock;
+
+	struct prbtree   *pt;
+	int              readers;  // Readers still running.
+
+	struct mpsc_queue *mpsc;
+	struct mpsc_node  *nodes;
+	struct mpmc_queue *mpmc;
+	size_t            consumed;
+};
+
+struct worker {
+	struct ctx *c;
+	int        id;
+};
+
+static int cmp(const void *a, const void *b)
+{
+	uintptr_t x = (uintptr_t) a, y = (uintptr_t) b;
+
+	return (x > y) - (x < y);
+}
+
+/* bench_rand() isn't thread-safe, so each thread draws from its own. */
+static unsigned long next_rand(unsigned long *s)
+{
+	*s ^= *s << 13;
+	*s ^= *s >> 7;
+	*s ^= *s << 17;
+
+	return *s;
+}
+
+/* Runs fn on k threads, and waits for all of them. */
+static void spawn(struct ctx *c, int k, void *(*fn)(void *))
+{
+	pthread_t *threads = malloc(k * sizeof(pthread_t));
+	struct worker *w = malloc(k * sizeof(struct worker));
+	int i;
+
+	for (i = 0; i < k; i++) {
+		w[i] = (struct worker) { c, i };
+		pthread_create(&threads[i], NULL, fn, &w[i]);
+	}
+
+	for (i = 0; i < k; i++)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+	free(w);
+}
+
+static struct ctx *make_ctx(size_t n, int nthreads)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+
+	c->n        = n;
+	c->nthreads = nthreads;
+
+	return c;
+}
+
+/* --- MultiQueues: relaxed (2 queues per thread) vs. strict (one queue) --- */
+
+static void *setup_relaxed(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+
+	c->mq = make_mqueue(2 * nthreads);
+
+	return c;
+}
+
+static void *setup_strict(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+
+	c->mq = make_mqueue(1);
+
+	return c;
+}
+
+static void teardown_mqueue(void *_c)
+{
+	struct ctx *c = _c;
+
+	mqueue_destroy(c->mq);
+	free(c);
+}
+
+/* Inserts a share of the keys, then extracts as many elements. */
+static void *mqueue_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+	unsigned long s = w->id + 1, key;
+	void *value;
+
+	for (i = 0; i < share; i++)
+		mqueue_insert(c->mq, next_rand(&s) % c->n, NULL);
+
+	for (i = 0; i < share; )
+		if (mqueue_try_extract_min(c->mq, &key, &value))
+			i++;
+
+	return NULL;
+}
+
+static void run_mqueue(void *_c)
+{
+	struct ctx *c = _c;
+
+	spawn(c, c->nthreads, mqueue_worker);
+}
+
+/* --- Ordered sets: lock-free skip list vs. mutex-protected rbtree --- */
+
+/* Half the key range is in the set to begin with. Workers then search 80% of
+ * the time, and insert or delete 10% of the time each, at random keys. */
+static void *setup_sets(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+	unsigned long *keys = bench_keys(n);
+	size_t i;
+
+	c->sl = make_skiplist(cmp);
+	c->t  = make_rbtree(cmp);
+	pthread_mutex_init(&c->lock, NULL);
+
+	for (i = 0; i < n / 2; i++) {
+		skiplist_insert(c->sl, (void *) (uintptr_t) keys[i]);
+		rbtree_insert(c->t, make_rbtree_node((void *) (uintptr_t) keys[i]));
+	}
+
+	free(keys);
+
+	return c;
+}
+
+static void teardown_sets(void *_c)
+{
+	struct ctx *c = _c;
+
+	skiplist_destroy(c->sl);
+	rbtree_destroy(c->t);
+	pthread_mutex_destroy(&c->lock);
+	free(c);
+}
+
+static void *skiplist_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+	unsigned long s = w->id + 1, r, found = 0;
+	void *key;
+
+	for (i = 0; i < share; i++) {
+		r   = next_rand(&s);
+		key = (void *) (uintptr_t) (1 + (r >> 4) % c->n);
+
+		if (r % 10 < 8)
+			found += !!skiplist_search(c->sl, key);
+		else if (r % 10 == 8)
+			skiplist_insert(c->sl, key);
+		else
+			skiplist_delete(c->sl, key);
+	}
+
+	bench_sink = found;
+	ebr_unregister();
+
+	return NULL;
+}
+
+static void *rbtree_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+	unsigned long s = w->id + 1, r, found = 0;
+	struct rbtree_node *x;
+	void *key;
+
+	for (i = 0; i < share; i++) {
+		r   = next_rand(&s);
+		key = (void *) (uintptr_t) (1 + (r >> 4) % c->n);
+
+		pthread_mutex_lock(&c->lock);
+		x = rbtree_search(c->t, key);
+
+		if (r % 10 < 8) {
+			found += x != c->t->nil;
+		} else if (r % 10 == 8) {
+			if (x == c->t->nil)
+				rbtree_insert(c->t, make_rbtree_node(key));
+		} else if (x != c->t->nil) {
+			rbtree_delete(c->t, x);
+			free(x);
+		}
+		pthread_mutex_unlock(&c->lock);
+	}
+
+	bench_sink = found;
+
+	return NULL;
+}
+
+static void run_skiplist(void *_c)
+{
+	struct ctx *c = _c;
+
+	spawn(c, c->nthreads, skiplist_worker);
+}
+
+static void run_rbtree(void *_c)
+{
+	struct ctx *c = _c;
+
+	spawn(c, c->nthreads, rbtree_worker);
+}
+
+/* --- Persistent rbtree: readers scaling under a concurrent writer --- */
+
+static void *setup_prbtree(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+	unsigned long *keys = bench_keys(n);
+	size_t i;
+
+	c->pt = make_prbtree(cmp);
+
+	for (i = 0; i < n; i++)
+		prbtree_insert(c->pt, (void *) (uintptr_t) keys[i]);
+
+	free(keys);
+
+	return c;
+}
+
+static void teardown_prbtree(void *_c)
+{
+	struct ctx *c = _c;
+
+	prbtree_destroy(c->pt);
+	free(c);
+}
+
+/* Worker 0 writes keys past the initial ones until all readers are done. */
+static void *prbtree_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+	unsigned long s = w->id + 1, found = 0;
+	void *key;
+
+	if (!w->id) {
+		for (i = 0; __atomic_load_n(&c->readers, __ATOMIC_ACQUIRE); i++) {
+			key = (void *) (uintptr_t) (c->n + 1 + i % 64);
+
+			if (!prbtree_insert(c->pt, key))
+				prbtree_delete(c->pt, key);
+		}
+	} else {
+		for (i = 0; i < share; i++)
+			found += !!prbtree_search(c->pt,
+				(void *) (uintptr_t) (1 + next_rand(&s) % c->n));
+
+		bench_sink = found;
+		__atomic_sub_fetch(&c->readers, 1, __ATOMIC_RELEASE);
+	}
+
+	ebr_unregister();
+
+	return NULL;
+}
+
+static void run_prbtree(void *_c)
+{
+	struct ctx *c = _c;
+
+	c->readers = c->nthreads;
+	spawn(c, c->nthreads + 1, prbtree_worker);
+}
+
+/* --- Queues: many producers to one (MPSC) or as many consumers (MPMC) --- */
+
+static void *setup_mpsc(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+
+	c->mpsc  = make_mpsc();
+	c->nodes = malloc(n * sizeof(struct mpsc_node));
+
+	return c;
+}
+
+static void teardown_mpsc(void *_c)
+{
+	struct ctx *c = _c;
+
+	free(c->mpsc);
+	free(c->nodes);
+	free(c);
+}
+
+/* Worker 0 is the consumer. */
+static void *mpsc_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+	struct mpsc_node *x = c->nodes + (w->id - 1) * share;
+
+	if (!w->id) {
+		for (i = 0; i < share * c->nthreads; )
+			if (mpsc_pop(c->mpsc))
+				i++;
+			else
+				sched_yield();
+	} else {
+		for (i = 0; i < share; i++)
+			mpsc_push(c->mpsc, &x[i]);
+	}
+
+	return NULL;
+}
+
+static void run_mpsc(void *_c)
+{
+	struct ctx *c = _c;
+
+	spawn(c, c->nthreads + 1, mpsc_worker);
+}
+
+static void *setup_mpmc(size_t n, int nthreads)
+{
+	struct ctx *c = make_ctx(n, nthreads);
+
+	c->mpmc = make_mpmc(MPMC_SZ);
+
+	return c;
+}
+
+static void teardown_mpmc(void *_c)
+{
+	struct ctx *c = _c;
+
+	mpmc_destroy(c->mpmc);
+	free(c);
+}
+
+/* Even workers produce, odd ones consume. */
+static void *mpmc_worker(void *_w)
+{
+	struct worker *w = _w;
+	struct ctx *c = w->c;
+	size_t i, share = c->n / c->nthreads;
+
+	if (w->id % 2) {
+		while (__atomic_load_n(&c->consumed, __ATOMIC_RELAXED) <
+		       share * c->nthreads)
+			if (mpmc_dequeue(c->mpmc))
+				__atomic_add_fetch(&c->consumed, 1,
+						   __ATOMIC_RELAXED);
+			else
+				sched_yield();
+	} else {
+		for (i = 0; i < share; i++)
+			while (!mpmc_enqueue(c->mpmc, (void *) (uintptr_t) (i + 1)))
+				sched_yield();
+	}
+
+	return NULL;
+}
+
+static void run_mpmc(void *_c)
+{
+	struct ctx *c = _c;
+
+	c->consumed = 0;
+	spawn(c, 2 * c->nthreads, mpmc_worker);
+}
+
+#define BENCH_THREADS(k)                                                        \
+	{ "concurrent", "mqueue_relaxed", k, setup_relaxed, run_mqueue,         \
+	  teardown_mqueue, 0, 0 },                                              \
+	{ "concurrent", "mqueue_strict",  k, setup_strict,  run_mqueue,         \
+	  teardown_mqueue, 0, 0 },                                              \
+	{ "concurrent", "skiplist_mixed", k, setup_sets,    run_skiplist,       \
+	  teardown_sets,   0, 0 },                                              \
+	{ "concurrent", "rbtree_mixed",   k, setup_sets,    run_rbtree,         \
+	  teardown_sets,   0, 0 },                                              \
+	{ "concurrent", "prbtree_read",   k, setup_prbtree, run_prbtree,        \
+	  teardown_prbtree, 1, 0 },                                             \
+	{ "concurrent", "mpsc",           k, setup_mpsc,    run_mpsc,           \
+	  teardown_mpsc,   0, 0 },                                              \
+	{ "concurrent", "mpmc",           k, setup_mpmc,    run_mpmc,           \
+	  teardown_mpmc,   0, 0 }
+
+struct bench bench_concurrent[] = {
+	BENCH_THREADS(1),
+	BENCH_THREADS(2),
+	BENCH_THREADS(4),
+	BENCH_THREADS(8),
+	BENCH_THREADS(16),
+	BENCH_END
+};
@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "extsort.h"
+
+/* Records are a key and a payload, 16 bytes in all. The argument is how many
+ * times the data outgrows the memory limit; at 1, it's sorted in memory. */
+struct rec {
+	uint64_t key;
+	uint64_t payload;
+};
+
+struct ctx {
+	struct rec     *recs;
+	size_t         n;
+	struct extsort *x;
+};
+
+static int rec_cmp(const void *_a, const void *_b)
+{
+	const struct rec *a = _a, *b = _b;
+
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+static int visit(const void *rec, void *arg __attribute__ ((unused)))
+{
+	bench_sink += ((const struct rec *) rec)->payload;
+
+	return 0;
+}
+
+static void *setup(size_t n, int ratio)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	size_t i, mem = 2 * n * sizeof(struct rec) / ratio;
+
+	c->recs = malloc(n * sizeof(struct rec));
+	c->n    = n;
+
+	for (i = 0; i < n; i++) {
+		c->recs[i].key     = (uint64_t) bench_rand() << 32 ^ bench_rand();
+		c->recs[i].payload = i;
+	}
+
+	if (mem < 8 * sizeof(struct rec))
+		mem = 8 * sizeof(struct rec);
+
+	c->x = make_extsort(sizeof(struct rec), rec_cmp, mem);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	extsort_destroy(c->x);
+	free(c->recs);
+	free(c);
+}
+
+static void sort(void *_c)
+{
+	struct ctx *c = _c;
+
+	extsort_add(c->x, c->recs, c->n);
+	extsort_finish(c->x, visit, NULL);
+}
+
+/* Throughput is that of the records sorted, not of the I/O, which is the
+ * larger the more merge passes there are. */
+struct bench bench_extsort[] = {
+	{ "extsort", "sort", 1,  setup, sort, teardown, 0, sizeof(struct rec) },
+	{ "extsort", "sort", 8,  setup, sort, teardown, 0, sizeof(struct rec) },
+	{ "extsort", "sort", 64, setup, sort, teardown, 0, sizeof(struct rec) },
+	BENCH_END
+};
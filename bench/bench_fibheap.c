@@ -0,0 +1,96 @@
+#include <stdlib.h>
+
+#include "bench.h"
+#include "fibheap.h"
+
+struct ctx {
+	struct fibheap      *h;
+	struct fibheap_node **nodes;
+	unsigned long       *keys;
+	size_t              n;
+};
+
+static int cmp(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *) a;
+	unsigned long y = *(const unsigned long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Keys are offset by n so that decrease() can lower all of them below the
+ * original minimum. */
+static void *setup(size_t n, int fill)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	size_t i;
+
+	c->h     = make_fibheap(cmp);
+	c->keys  = bench_keys(n);
+	c->nodes = malloc(n * sizeof(struct fibheap_node *));
+	c->n     = n;
+
+	for (i = 0; i < n; i++) {
+		c->keys[i] += n;
+		c->nodes[i] = make_fibheap_node(&c->keys[i]);
+
+		if (fill)
+			fibheap_insert(c->h, c->nodes[i]);
+	}
+
+	/* Consolidates the root list into a forest of trees, otherwise there'd
+	 * be no parents for decrease() to cut the nodes from. */
+	if (fill > 1)
+		fibheap_extract_min(c->h);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		free(c->nodes[i]);
+
+	free(c->nodes);
+	free(c->keys);
+	free(c->h);
+	free(c);
+}
+
+static void insert(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		fibheap_insert(c->h, c->nodes[i]);
+}
+
+static void extract(void *_c)
+{
+	struct ctx *c = _c;
+
+	while (!fibheap_is_empty(c->h))
+		fibheap_extract_min(c->h);
+}
+
+static void decrease(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		c->keys[i] -= c->n;
+		fibheap_decrease(c->h, c->nodes[i]);
+	}
+}
+
+struct bench bench_fibheap[] = {
+	{ "fibheap", "insert",      0, setup, insert,   teardown, 0, 0 },
+	{ "fibheap", "extract_min", 1, setup, extract,  teardown, 0, 0 },
+	{ "fibheap", "decrease",    2, setup, decrease, teardown, 0, 0 },
+	BENCH_END
+};
@@ -0,0 +1,141 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "graph.h"
+
+#define MAX_WEIGHT 1000
+#define ATTACH     4            // Edges added per vertex of a power-law graph.
+
+struct ctx {
+	struct graph  *g;
+	unsigned long *dist;
+	int           *pred;
+	enum graph_heap heap;
+};
+
+/* A road-like network: a square grid with 4-neighbour connectivity. */
+static struct graph *make_grid(size_t n)
+{
+	int side = (int) sqrt((double) n), m = 0, r, c, v;
+	struct graph_edge *e;
+	struct graph *g;
+
+	if (side < 2)
+		side = 2;
+
+	e = malloc(2 * side * side * sizeof(struct graph_edge));
+
+	for (r = 0; r < side; r++) {
+		for (c = 0; c < side; c++) {
+			v = r * side + c;
+
+			if (c + 1 < side)
+				e[m++] = (struct graph_edge) {
+					v, v + 1, 1 + bench_rand() % MAX_WEIGHT };
+			if (r + 1 < side)
+				e[m++] = (struct graph_edge) {
+					v, v + side, 1 + bench_rand() % MAX_WEIGHT };
+		}
+	}
+
+	g = make_graph(side * side, e, m, 1);
+	free(e);
+
+	return g;
+}
+
+/* Preferential attachment: picking the endpoint of a random earlier edge
+ * chooses a vertex with probability proportional to its degree. */
+static struct graph *make_powerlaw(size_t n)
+{
+	struct graph_edge *e;
+	struct graph *g;
+	int m = 0, v, k;
+
+	if (n < 2)
+		n = 2;
+
+	e = malloc(ATTACH * n * sizeof(struct graph_edge));
+	e[m++] = (struct graph_edge) { 0, 1, 1 + bench_rand() % MAX_WEIGHT };
+
+	for (v = 2; v < (int) n; v++) {
+		for (k = 0; k < ATTACH; k++) {
+			struct graph_edge *r = &e[bench_rand() % m];
+
+			e[m++] = (struct graph_edge) {
+				v, bench_rand() & 1 ? r->u : r->v,
+				1 + bench_rand() % MAX_WEIGHT };
+		}
+	}
+
+	g = make_graph(n, e, m, 1);
+	free(e);
+
+	return g;
+}
+
+static void *setup(size_t n, int heap, struct graph *(*make)(size_t))
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+
+	c->g    = make(n);
+	c->dist = malloc(c->g->n * sizeof(unsigned long));
+	c->pred = malloc(c->g->n * sizeof(int));
+	c->heap = heap;
+
+	return c;
+}
+
+static void *setup_grid(size_t n, int heap)
+{
+	return setup(n, heap, make_grid);
+}
+
+static void *setup_powerlaw(size_t n, int heap)
+{
+	return setup(n, heap, make_powerlaw);
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	graph_destroy(c->g);
+	free(c->dist);
+	free(c->pred);
+	free(c);
+}
+
+static void dijkstra(void *_c)
+{
+	struct ctx *c = _c;
+
+	graph_dijkstra(c->g, 0, c->heap, c->dist, c->pred);
+	bench_sink = c->dist[c->g->n - 1];
+}
+
+static void prim(void *_c)
+{
+	struct ctx *c = _c;
+
+	bench_sink = graph_prim(c->g, c->heap, c->pred);
+}
+
+#define BENCH_HEAP(heap)                                                        \
+	{ "graph", "dijkstra_grid",     heap, setup_grid,     dijkstra,         \
+	  teardown, 1, 0 },                                                     \
+	{ "graph", "dijkstra_powerlaw", heap, setup_powerlaw, dijkstra,         \
+	  teardown, 1, 0 },                                                     \
+	{ "graph", "prim_grid",         heap, setup_grid,     prim,             \
+	  teardown, 1, 0 },                                                     \
+	{ "graph", "prim_powerlaw",     heap, setup_powerlaw, prim,             \
+	  teardown, 1, 0 }
+
+/* The argument is the heap used, see enum graph_heap. */
+struct bench bench_graph[] = {
+	BENCH_HEAP(GRAPH_FIBHEAP),
+	BENCH_HEAP(GRAPH_BINHEAP),
+	BENCH_HEAP(GRAPH_RADIXHEAP),
+	BENCH_END
+};
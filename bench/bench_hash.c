@@ -0,0 +1,241 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "filter.h"
+#include "hash.h"
+#include "phash.h"
+
+struct entry {
+	struct list_head list;
+	unsigned long    key;
+};
+
+struct ctx {
+	struct hash_table *ht;
+	struct entry      *entries;
+	size_t            n;
+	size_t            sz;
+
+	struct phash      *frozen;
+	char              *path;    // Where it's saved, for loading.
+
+	struct filter     *filter;
+};
+
+/* hash_fn takes no table size, so it's shared through here. */
+static unsigned int shift;
+
+/* Fibonacci hashing, see Knuth's TAOCP vol. 3, section 6.4. */
+static unsigned int hash(const void *key)
+{
+	unsigned long k = *(const unsigned long *) key;
+
+	return (unsigned int) ((k * 11400714819323198485ull) >> shift);
+}
+
+static int cmp(struct list_head *x, const void *key)
+{
+	return list_entry(x, struct entry, list)->key ==
+	       *(const unsigned long *) key;
+}
+
+static void *setup(size_t n, int fill)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+	unsigned long *keys = bench_keys(n);
+	size_t i;
+
+	for (shift = 63, c->sz = 2; c->sz < n; c->sz <<= 1)
+		shift--;
+
+	c->ht      = make_hash_table(c->sz, hash, cmp);
+	c->entries = malloc(n * sizeof(struct entry));
+	c->n       = n;
+
+	for (i = 0; i < n; i++) {
+		c->entries[i].key = keys[i];
+
+		if (fill)
+			hash_insert(c->ht, &c->entries[i].list, &keys[i]);
+	}
+
+	free(keys);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	if (c->frozen)
+		phash_destroy(c->frozen);
+
+	if (c->filter)
+		filter_destroy(c->filter);
+
+	if (c->path) {
+		remove(c->path);
+		free(c->path);
+	}
+
+	free(c->ht->table);
+	free(c->ht);
+	free(c->entries);
+	free(c);
+}
+
+static void insert(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		hash_insert(c->ht, &c->entries[i].list, &c->entries[i].key);
+}
+
+static void search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0, miss;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		miss = c->n + 1 + i;  // Never inserted.
+		sum += !!hash_search(c->ht, &c->entries[i].key);
+		sum += !!hash_search(c->ht, &miss);
+	}
+
+	bench_sink = sum;
+}
+
+/* The argument picks the filter: none, Bloom (1%) or cuckoo. Filters need
+ * full hashes rather than indices, so the table is switched to hash_fn_u64()
+ * either way. */
+static void *setup_filtered(size_t n, int kind)
+{
+	struct ctx *c = setup(n, 0);
+
+	c->ht->fn = hash_fn_u64;
+
+	if (kind)
+		c->filter = kind == 1 ? make_bloom(n, 0.01) : make_cuckoo(n);
+
+	hash_attach_filter(c->ht, c->filter);
+	insert(c);
+
+	return c;
+}
+
+static void search_miss(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0, miss;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		miss = c->n + 1 + i;
+		sum += !!hash_search(c->ht, &miss);
+	}
+
+	bench_sink = sum;
+}
+
+static const void *frozen_key(struct list_head *x)
+{
+	return &list_entry(x, struct entry, list)->key;
+}
+
+static uint64_t frozen_hash(const void *key)
+{
+	return hash_mix64(*(const unsigned long *) key);
+}
+
+static size_t frozen_pack(struct list_head *x, void *rec)
+{
+	if (rec)
+		*(unsigned long *) rec = list_entry(x, struct entry, list)->key;
+
+	return sizeof(unsigned long);
+}
+
+static int frozen_cmp(const void *rec, const void *key)
+{
+	return *(const unsigned long *) rec == *(const unsigned long *) key;
+}
+
+/* Prints how much memory the table takes, chained vs. frozen. */
+static void *setup_frozen(size_t n, int fill)
+{
+	struct ctx *c = setup(n, fill);
+
+	c->frozen = hash_freeze(c->ht, frozen_key, frozen_hash, frozen_pack,
+				frozen_cmp);
+
+	fprintf(stderr, "hash memory: keys=%zu chained=%zu frozen=%zu\n", n,
+		c->sz * sizeof(struct list_head) + n * sizeof(struct entry),
+		phash_size(c->frozen));
+
+	return c;
+}
+
+static void search_frozen(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0, miss;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		miss = c->n + 1 + i;
+		sum += !!phash_search(c->frozen, &c->entries[i].key);
+		sum += !!phash_search(c->frozen, &miss);
+	}
+
+	bench_sink = sum;
+}
+
+static void *setup_saved(size_t n, int fill)
+{
+	struct ctx *c = setup_frozen(n, fill);
+
+	c->path = bench_tmpfile();
+
+	if (phash_save(c->frozen, c->path)) {
+		perror(c->path);
+		exit(1);
+	}
+
+	return c;
+}
+
+/* What a restart pays, instead of rebuilding the table: mapping it in, then
+ * looking up a key. */
+static void load_frozen(void *_c)
+{
+	struct ctx *c = _c;
+	struct phash *f = phash_load(c->path, frozen_hash, frozen_cmp, 0);
+
+	bench_sink = !!phash_search(f, &c->entries[0].key);
+
+	phash_destroy(f);
+}
+
+struct bench bench_hash[] = {
+	{ "hash", "insert",          0, setup,        insert,        teardown,
+	  0, 0 },
+	{ "hash", "search_hit_miss", 1, setup,        search,        teardown,
+	  1, 0 },
+	{ "hash", "search_miss",     0, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "hash", "search_miss",     1, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "hash", "search_miss",     2, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "hash", "frozen_hit_miss", 1, setup_frozen, search_frozen, teardown,
+	  1, 0 },
+	{ "hash", "frozen_load",     1, setup_saved,  load_frozen,   teardown,
+	  1, 0 },
+	BENCH_END
+};
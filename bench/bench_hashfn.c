@@ -0,0 +1,347 @@
+#define _POSIX_C_SOURCE 200809L // For opendir().
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "hash.h"
+#include "hashfn.h"
+
+#define MAX_WORD   64
+#define MIN_VOCAB  1000         // Below this, synthetic words are added.
+
+/* Vocabulary sources, in order of preference: $BENCH_WORDS, the system's word
+ * list, then the identifiers found in the library's own sources. */
+static const char *dict_paths[] = { "/usr/share/dict/words", NULL };
+static const char *src_dirs[]   = { "src", "include", "bench", NULL };
+
+struct word {
+	struct list_head list;
+	char             *str;
+};
+
+struct vocab {
+	struct hash_table *seen;
+	struct word       *words;
+	size_t            n;
+	size_t            cap;
+};
+
+static struct vocab vocab;
+
+/* The hash main.c used to have, for reference. */
+static unsigned int mod101(const void *key)
+{
+	const unsigned char *w = key;
+	unsigned int c, ret = 1;
+
+	while ((c = *w++))
+		ret = (ret * c) % 101;
+
+	return ret;
+}
+
+static int cmp(struct list_head *x, const void *key)
+{
+	return !strcmp(list_entry(x, struct word, list)->str, key);
+}
+
+static void add_word(const char *w)
+{
+	struct word *x;
+
+	if (hash_search(vocab.seen, w))
+		return;
+
+	if (vocab.n == vocab.cap) {
+		vocab.cap   = vocab.cap ? 2 * vocab.cap : 1024;
+		vocab.words = realloc(vocab.words,
+				      vocab.cap * sizeof(struct word));
+
+		/* Entries moved, so the table has to be rebuilt. */
+		free(vocab.seen->table);
+		free(vocab.seen);
+		vocab.seen = make_hash_table(2 * vocab.cap, hash_fn_string, cmp);
+
+		for (x = vocab.words; x < vocab.words + vocab.n; x++)
+			hash_insert(vocab.seen, &x->list, x->str);
+	}
+
+	x      = &vocab.words[vocab.n++];
+	x->str = strcpy(malloc(strlen(w) + 1), w);
+	hash_insert(vocab.seen, &x->list, x->str);
+}
+
+/* Splits a file into words: runs of letters, digits and underscores. */
+static void add_words(const char *path)
+{
+	char w[MAX_WORD + 1];
+	FILE *f = fopen(path, "r");
+	int c, len = 0;
+
+	if (!f)
+		return;
+
+	while ((c = fgetc(f)) != EOF) {
+		if (isalnum(c) || c == '_' || c >= 0x80) {
+			if (len < MAX_WORD)
+				w[len++] = c;
+		} else if (len) {
+			w[len] = '\0';
+			add_word(w);
+			len = 0;
+		}
+	}
+
+	fclose(f);
+}
+
+static void add_dir(const char *dir)
+{
+	char path[512];
+	struct dirent *e;
+	DIR *d = opendir(dir);
+
+	if (!d)
+		return;
+
+	while ((e = readdir(d))) {
+		if (e->d_name[0] == '.')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+		add_words(path);
+	}
+
+	closedir(d);
+}
+
+/* Word-like strings out of common English syllables. */
+static void add_synthetic(size_t n)
+{
+	static const char *syl[] = {
+		"a", "be", "con", "de", "ex", "in", "ing", "ion", "er", "re",
+		"pro", "ter", "ment", "al", "com", "ed", "ly", "tion", "un", "st"
+	};
+	char w[MAX_WORD + 1];
+	size_t i, k;
+
+	for (i = 0; vocab.n < n; i++) {
+		w[0] = '\0';
+
+		for (k = 1 + bench_rand() % 4; k; k--)
+			strcat(w, syl[bench_rand() % (sizeof(syl) / sizeof(*syl))]);
+
+		add_word(w);
+	}
+}
+
+static void load_vocab(void)
+{
+	const char **p, *env = getenv("BENCH_WORDS");
+
+	if (vocab.n)
+		return;
+
+	vocab.seen = make_hash_table(1, hash_fn_string, cmp);
+
+	if (env)
+		add_words(env);
+
+	for (p = dict_paths; !vocab.n && *p; p++)
+		add_words(*p);
+
+	for (p = src_dirs; vocab.n < MIN_VOCAB && *p; p++)
+		add_dir(*p);
+
+	if (vocab.n < MIN_VOCAB)
+		add_synthetic(MIN_VOCAB);
+}
+
+/* --- Throughput --- */
+
+struct ctx {
+	unsigned char     *buf;
+	size_t            n;
+	size_t            len;
+
+	struct hash_table *ht;
+	struct word       *entries;
+	size_t            nentries;
+};
+
+static void *setup_words(size_t n, int unused)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+
+	(void) unused;
+
+	load_vocab();
+	c->n = n;
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	free(c->buf);
+
+	if (c->ht) {
+		free(c->ht->table);
+		free(c->ht);
+	}
+
+	free(c->entries);
+	free(c);
+}
+
+static void string_words(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += hash_string(vocab.words[i % vocab.n].str);
+
+	bench_sink = sum;
+}
+
+static void mod101_words(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += mod101(vocab.words[i % vocab.n].str);
+
+	bench_sink = sum;
+}
+
+/* n bytes, hashed as keys of len bytes each (or as a single key, if shorter.) */
+static void *setup_bytes(size_t n, int len)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+	size_t i;
+
+	c->len = n < (size_t) len ? n : (size_t) len;
+	c->n   = n;
+	c->buf = malloc(n);
+
+	for (i = 0; i < c->n; i++)
+		c->buf[i] = bench_rand();
+
+	return c;
+}
+
+static void bytes(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i + c->len <= c->n; i += c->len)
+		sum += hash_bytes(c->buf + i, c->len, 0);
+
+	bench_sink = sum;
+}
+
+static void mix64(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += hash_mix64(i);
+
+	bench_sink = sum;
+}
+
+/* --- Distribution --- */
+
+/* Prints how evenly keys spread over buckets: the ratio of the probes needed
+ * to find every key to what a uniformly random hash would need in
+ * expectation, see "Compilers: Principles, Techniques, and Tools", by A. V.
+ * Aho, R. Sethi and J. D. Ullman, sec. 7.6. 1.0 is ideal, higher is worse. */
+static void print_quality(const char *name, struct hash_table *ht, size_t n)
+{
+	struct list_head *pos;
+	double probes = 0, m = ht->sz;
+	size_t len, max = 0;
+	int i;
+
+	for (i = 0; i < ht->sz; i++) {
+		len = 0;
+
+		list_for_each(pos, &ht->table[i])
+			len++;
+
+		probes += len * (len + 1) / 2.0;
+		max     = len > max ? len : max;
+	}
+
+	fprintf(stderr, "hash quality: %s keys=%zu buckets=%d max_chain=%zu "
+		"uniformity=%.3f\n", name, n, ht->sz, max,
+		probes / ((n / (2 * m)) * (n + 2 * m - 1)));
+}
+
+/* The table holds up to n distinct words, at a load factor of at most 1. */
+static void *setup_table(size_t n, int fn)
+{
+	struct ctx *c = setup_words(n, 0);
+	size_t i, sz = 1;
+
+	c->nentries = n < vocab.n ? n : vocab.n;
+
+	while (sz < c->nentries)
+		sz <<= 1;
+
+	c->ht      = make_hash_table(sz, fn ? hash_fn_string : mod101, cmp);
+	c->entries = malloc(c->nentries * sizeof(struct word));
+
+	for (i = 0; i < c->nentries; i++) {
+		c->entries[i].str = vocab.words[i].str;
+		hash_insert(c->ht, &c->entries[i].list, c->entries[i].str);
+	}
+
+	print_quality(fn ? "string" : "mod101", c->ht, c->nentries);
+
+	return c;
+}
+
+static void table_search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long found = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		found += !!hash_search(c->ht, c->entries[i % c->nentries].str);
+
+	bench_sink = found;
+}
+
+struct bench bench_hashfn[] = {
+	{ "hashfn", "string_words", 0, setup_words, string_words, teardown,
+	  1, 0 },
+	{ "hashfn", "mod101_words", 0, setup_words, mod101_words, teardown,
+	  1, 0 },
+	{ "hashfn", "bytes",       16, setup_bytes, bytes, teardown, 1, 1 },
+	{ "hashfn", "bytes",       64, setup_bytes, bytes, teardown, 1, 1 },
+	{ "hashfn", "bytes",     1024, setup_bytes, bytes, teardown, 1, 1 },
+	{ "hashfn", "bytes",    65536, setup_bytes, bytes, teardown, 1, 1 },
+	{ "hashfn", "mix64",        0, setup_words, mix64, teardown, 1,
+	  sizeof(uint64_t) },
+	{ "hashfn", "table_mod101", 0, setup_table, table_search, teardown,
+	  1, 0 },
+	{ "hashfn", "table_string", 1, setup_table, table_search, teardown,
+	  1, 0 },
+	BENCH_END
+};
@@ -0,0 +1,111 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "ohash.h"
+
+/* Scans cover this many entries, from a random key on. */
+#define SCAN_LEN 100
+
+struct entry {
+	uint64_t          key;
+	struct ohash_node node;
+};
+
+struct ctx {
+	struct ohash  *oh;
+	struct entry  *entries;
+	unsigned long *keys;
+	size_t        n;
+};
+
+static int cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void *setup(size_t n, int fill)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	size_t i;
+
+	c->oh      = make_ohash(16, hash_fn_u64, cmp);
+	c->keys    = bench_keys(n);
+	c->entries = malloc(n * sizeof(struct entry));
+	c->n       = n;
+
+	for (i = 0; i < n; i++) {
+		c->entries[i].key = c->keys[i];
+
+		if (fill)
+			ohash_insert(c->oh, &c->entries[i].node,
+				     &c->entries[i].key);
+	}
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	ohash_destroy(c->oh);
+	free(c->entries);
+	free(c->keys);
+	free(c);
+}
+
+static void insert(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		ohash_insert(c->oh, &c->entries[i].node, &c->entries[i].key);
+}
+
+static void search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	uint64_t key;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		key  = c->keys[i];
+		sum += ohash_entry(ohash_search(c->oh, &key), struct entry,
+				   node)->key;
+	}
+
+	bench_sink = sum;
+}
+
+/* One range scan per entry. */
+static void scan(void *_c)
+{
+	struct ctx *c = _c;
+	struct ohash_node *x;
+	unsigned long sum = 0;
+	uint64_t key;
+	size_t i;
+	int j;
+
+	for (i = 0; i < c->n; i++) {
+		key = c->keys[i];
+		x   = ohash_lower_bound(c->oh, &key);
+
+		for (j = 0; x && j < SCAN_LEN; j++, x = ohash_next(c->oh, x))
+			sum += ohash_entry(x, struct entry, node)->key;
+	}
+
+	bench_sink = sum;
+}
+
+struct bench bench_ohash[] = {
+	{ "ohash", "insert", 0, setup, insert, teardown, 0, 0 },
+	{ "ohash", "search", 1, setup, search, teardown, 1, 0 },
+	{ "ohash", "scan",   1, setup, scan,   teardown, 1, 0 },
+	BENCH_END
+};
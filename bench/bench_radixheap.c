@@ -0,0 +1,121 @@
+#include <stdlib.h>
+
+#include "bench.h"
+#include "fibheap.h"
+#include "radixheap.h"
+
+/* Max. distance between an extracted key and the one inserted after it, akin
+ * to the max. edge weight in Dijkstra's algorithm. */
+#define MAX_STEP 1024
+
+enum { RADIX = 0, FIB };
+
+/* A monotone workload: n keys are queued, then each extracted key is
+ * re-inserted a random step past itself, n times over. */
+struct ctx {
+	struct radixheap      *rh;
+	struct radixheap_node **rnodes;
+
+	struct fibheap        *fh;
+	struct fibheap_node   **fnodes;
+
+	unsigned long         *keys;
+	unsigned long         *steps;
+	size_t                n;
+};
+
+static int cmp(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *) a;
+	unsigned long y = *(const unsigned long *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void *setup(size_t n, int which)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+	size_t i;
+
+	c->keys  = malloc(n * sizeof(unsigned long));
+	c->steps = malloc(n * sizeof(unsigned long));
+	c->n     = n;
+
+	for (i = 0; i < n; i++) {
+		c->keys[i]  = bench_rand() % MAX_STEP;
+		c->steps[i] = bench_rand() % MAX_STEP;
+	}
+
+	if (which == RADIX) {
+		c->rh     = make_radixheap();
+		c->rnodes = malloc(n * sizeof(struct radixheap_node *));
+
+		for (i = 0; i < n; i++) {
+			c->rnodes[i] = make_radixheap_node(c->keys[i], NULL);
+			radixheap_insert(c->rh, c->rnodes[i]);
+		}
+	} else {
+		c->fh     = make_fibheap(cmp);
+		c->fnodes = malloc(n * sizeof(struct fibheap_node *));
+
+		for (i = 0; i < n; i++) {
+			c->fnodes[i] = make_fibheap_node(&c->keys[i]);
+			fibheap_insert(c->fh, c->fnodes[i]);
+		}
+	}
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		if (c->rh)
+			free(c->rnodes[i]);
+		else
+			free(c->fnodes[i]);
+	}
+
+	free(c->rh);
+	free(c->rnodes);
+	free(c->fh);
+	free(c->fnodes);
+	free(c->keys);
+	free(c->steps);
+	free(c);
+}
+
+static void run(void *_c)
+{
+	struct ctx *c = _c;
+	struct radixheap_node *r;
+	struct fibheap_node *f;
+	unsigned long *key;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		if (c->rh) {
+			r       = radixheap_extract_min(c->rh);
+			r->key += c->steps[i];
+			radixheap_insert(c->rh, r);
+		} else {
+			f    = fibheap_extract_min(c->fh);
+			key  = f->value;
+			*key += c->steps[i];
+
+			f->parent = NULL;
+			f->degree = 0;
+			INIT_LIST_HEAD(&f->child);
+			fibheap_insert(c->fh, f);
+		}
+	}
+}
+
+struct bench bench_radixheap[] = {
+	{ "radixheap", "monotone_radix", RADIX, setup, run, teardown, 0, 0 },
+	{ "radixheap", "monotone_fib",   FIB,   setup, run, teardown, 0, 0 },
+	BENCH_END
+};
@@ -0,0 +1,231 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "filter.h"
+#include "hashfn.h"
+#include "rbtree.h"
+#include "smap.h"
+
+struct ctx {
+	struct rbtree      *t;
+	struct rbtree_node **nodes;
+	unsigned long      *keys;
+	size_t             n;
+
+	struct smap        *frozen;
+	char               *path;   // Where it's saved, for loading.
+
+	struct filter      *filter;
+};
+
+static int cmp(const void *a, const void *b)
+{
+	uintptr_t x = (uintptr_t) a, y = (uintptr_t) b;
+
+	return (x > y) - (x < y);
+}
+
+static void *setup(size_t n, int fill)
+{
+	struct ctx *c = calloc(1, sizeof(struct ctx));
+	size_t i;
+
+	c->t     = make_rbtree(cmp);
+	c->keys  = bench_keys(n);
+	c->nodes = malloc(n * sizeof(struct rbtree_node *));
+	c->n     = n;
+
+	for (i = 0; i < n; i++) {
+		c->nodes[i] = make_rbtree_node((void *) (uintptr_t) c->keys[i]);
+
+		if (fill)
+			rbtree_insert(c->t, c->nodes[i]);
+	}
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	if (c->frozen)
+		smap_destroy(c->frozen);
+
+	if (c->filter)
+		filter_destroy(c->filter);
+
+	if (c->path) {
+		remove(c->path);
+		free(c->path);
+	}
+
+	rbtree_destroy(c->t);  // Frees the nodes still in the tree.
+	free(c->nodes);
+	free(c->keys);
+	free(c);
+}
+
+/* Deleted nodes are no longer reachable from the tree. */
+static void teardown_deleted(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		free(c->nodes[i]);
+
+	teardown(c);
+}
+
+static void insert(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		rbtree_insert(c->t, c->nodes[i]);
+}
+
+static void search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += (uintptr_t) rbtree_search(c->t,
+			(void *) (uintptr_t) c->keys[i])->value;
+
+	bench_sink = sum;
+}
+
+static uint64_t hash(const void *value)
+{
+	return hash_mix64((uintptr_t) value);
+}
+
+/* The argument picks the filter: none, Bloom (1%) or cuckoo. Values are
+ * doubled, so that misses (odd values) end up all over the tree. */
+static void *setup_filtered(size_t n, int kind)
+{
+	struct ctx *c = setup(n, 0);
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		c->nodes[i]->value = (void *) (uintptr_t) (2 * c->keys[i]);
+
+	if (kind) {
+		c->filter = kind == 1 ? make_bloom(n, 0.01) : make_cuckoo(n);
+		rbtree_attach_filter(c->t, c->filter, hash);
+	}
+
+	insert(c);
+
+	return c;
+}
+
+static void search_miss(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += rbtree_search(c->t, (void *) (uintptr_t)
+				     (2 * c->keys[i] + 1)) != c->t->nil;
+
+	bench_sink = sum;
+}
+
+static void delete(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		rbtree_delete(c->t, c->nodes[i]);
+}
+
+static size_t frozen_pack(void *value, void *rec)
+{
+	if (rec)
+		*(unsigned long *) rec = (uintptr_t) value;
+
+	return sizeof(unsigned long);
+}
+
+static int frozen_cmp(const void *rec, const void *key)
+{
+	unsigned long x = *(const unsigned long *) rec;
+	unsigned long y = *(const unsigned long *) key;
+
+	return (x > y) - (x < y);
+}
+
+static void *setup_frozen(size_t n, int fill)
+{
+	struct ctx *c = setup(n, fill);
+
+	c->frozen = rbtree_freeze(c->t, frozen_pack, frozen_cmp);
+
+	return c;
+}
+
+static void *setup_saved(size_t n, int fill)
+{
+	struct ctx *c = setup_frozen(n, fill);
+
+	c->path = bench_tmpfile();
+
+	if (smap_save(c->frozen, c->path)) {
+		perror(c->path);
+		exit(1);
+	}
+
+	return c;
+}
+
+static void search_frozen(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		sum += *(const unsigned long *) smap_search(c->frozen,
+							    &c->keys[i]);
+
+	bench_sink = sum;
+}
+
+/* What a restart pays, instead of rebuilding the tree: mapping the sorted map
+ * in, then looking up a key. */
+static void load_frozen(void *_c)
+{
+	struct ctx *c = _c;
+	struct smap *m = smap_load(c->path, frozen_cmp, 0);
+
+	bench_sink = !!smap_search(m, &c->keys[0]);
+
+	smap_destroy(m);
+}
+
+struct bench bench_rbtree[] = {
+	{ "rbtree", "insert", 0, setup, insert, teardown, 0, 0 },
+	{ "rbtree", "search", 1, setup, search, teardown, 1, 0 },
+	{ "rbtree", "delete", 1, setup, delete, teardown_deleted, 0, 0 },
+	{ "rbtree", "search_miss",   0, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "rbtree", "search_miss",   1, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "rbtree", "search_miss",   2, setup_filtered, search_miss, teardown,
+	  1, 0 },
+	{ "rbtree", "frozen_search", 1, setup_frozen, search_frozen, teardown,
+	  1, 0 },
+	{ "rbtree", "frozen_load",   1, setup_saved,  load_frozen,   teardown,
+	  1, 0 },
+	BENCH_END
+};
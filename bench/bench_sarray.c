@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "sarray.h"
+#include "strmatch.h"
+
+/* The text is made of words spelled out of syllables, small numbers being
+ * likelier, so that it's about as repetitive as prose. Patterns are cut from
+ * it, so they all occur. */
+#define PATTERNS    16
+#define PATTERN_LEN 8
+#define VOCAB       4096
+
+static const char *syllables[16] = {
+	"a", "de", "con", "re", "in", "ter", "pro", "ta",
+	"ment", "tion", "es", "mo", "li", "qu", "ra", "ble"
+};
+
+/* The argument gives the sections built (SARRAY_LCP, SARRAY_FM), or, for
+ * scan, nothing. */
+struct ctx {
+	char          *txt;
+	size_t        n;
+	int           flags;
+
+	const char    *pat[PATTERNS];
+	struct sarray *s;
+};
+
+static void *setup(size_t n, int flags)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	unsigned long x;
+	size_t i = 0, len;
+	int j;
+
+	if (n < PATTERN_LEN)
+		n = PATTERN_LEN;
+
+	c->txt   = malloc(n + 1);
+	c->n     = n;
+	c->flags = flags;
+	c->s     = NULL;
+
+	while (i < n) {
+		x = bench_rand() % (bench_rand() % VOCAB + 1);
+
+		do {
+			len = strlen(syllables[x & 15]);
+			len = len < n - i ? len : n - i;
+			memcpy(c->txt + i, syllables[x & 15], len);
+			i  += len;
+			x >>= 4;
+		} while (x && i < n);
+
+		if (i < n)
+			c->txt[i++] = ' ';
+	}
+
+	c->txt[n] = '\0';
+
+	for (j = 0; j < PATTERNS; j++)
+		c->pat[j] = c->txt + bench_rand() % (n - PATTERN_LEN + 1);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	if (c->s)
+		sarray_destroy(c->s);
+
+	free(c->txt);
+	free(c);
+}
+
+static void build(void *_c)
+{
+	struct ctx *c = _c;
+
+	c->s       = make_sarray(c->txt, c->n, c->flags);
+	bench_sink = sarray_size(c->s);
+}
+
+/* Prints the size of the index, which takes the bulk of the memory needed to
+ * build it. */
+static void *setup_built(size_t n, int flags)
+{
+	struct ctx *c = setup(n, flags);
+
+	build(c);
+
+	fprintf(stderr, "sarray memory: flags=%d n=%zu bytes=%zu "
+		"bytes/char=%.2f\n", flags, c->n, sarray_size(c->s),
+		(double) sarray_size(c->s) / c->n);
+
+	return c;
+}
+
+static void search(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	int i;
+
+	for (i = 0; i < PATTERNS; i++)
+		sum += sarray_search(c->s, c->pat[i], PATTERN_LEN, NULL);
+
+	bench_sink = sum;
+}
+
+/* Matching the patterns over the whole text, for reference. */
+static void scan(void *_c)
+{
+	struct ctx *c = _c;
+	unsigned long sum = 0;
+	int i;
+
+	for (i = 0; i < PATTERNS; i++)
+		sum += strmatch(c->txt, c->n, c->pat[i], PATTERN_LEN, NULL,
+				NULL);
+
+	bench_sink = sum;
+}
+
+/* Builds are given as throughput, bytes of text per second. Indexing 1 GB takes
+ * --sizes 1000000000 --reps 1, and 5 GB of memory for the array alone, 10 GB
+ * with every section (and 4 more while building the LCP array.) */
+struct bench bench_sarray[] = {
+	{ "sarray", "build",  0,            setup,       build,  teardown, 0, 1 },
+	{ "sarray", "build",  SARRAY_LCP,   setup,       build,  teardown, 0, 1 },
+	{ "sarray", "build",  SARRAY_LCP | SARRAY_FM,
+	  setup, build, teardown, 0, 1 },
+	{ "sarray", "search", 0,            setup_built, search, teardown, 1, 0 },
+	{ "sarray", "search", SARRAY_FM,    setup_built, search, teardown, 1, 0 },
+	{ "sarray", "scan",   0,            setup,       scan,   teardown, 1, 0 },
+	BENCH_END
+};
@@ -0,0 +1,118 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "rbtree.h"
+#include "sort.h"
+
+/* Elements are laid out as main.c's words, keyed by a shuffled 1..n. The
+ * argument of parallel is the number of threads. */
+struct word {
+	int        key;
+	const char *str;
+};
+
+struct ctx {
+	struct word *words;
+	size_t      n;
+	int         arg;
+};
+
+static int word_cmp(const void *_a, const void *_b)
+{
+	const struct word *a = _a, *b = _b;
+
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+static uint64_t word_key(const void *w)
+{
+	return ((const struct word *) w)->key;
+}
+
+static void *setup(size_t n, int arg)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	unsigned long *keys = bench_keys(n);
+	size_t i;
+
+	c->words = malloc(n * sizeof(struct word));
+	c->n     = n;
+	c->arg   = arg;
+
+	for (i = 0; i < n; i++) {
+		c->words[i].key = keys[i];
+		c->words[i].str = NULL;
+	}
+
+	free(keys);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	free(c->words);
+	free(c);
+}
+
+static void word_visit(struct rbtree_node *x)
+{
+	bench_sink += ((struct word *) x->value)->key;
+}
+
+/* The way main.c gets words in order: inserting them in a tree, then walking
+ * it. */
+static void rbtree(void *_c)
+{
+	struct ctx *c = _c;
+	struct rbtree *t = make_rbtree(word_cmp);
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		rbtree_insert(t, make_rbtree_node(&c->words[i]));
+
+	rbtree_inorder_walk(t, word_visit);
+	rbtree_destroy(t);
+}
+
+static void libc(void *_c)
+{
+	struct ctx *c = _c;
+
+	qsort(c->words, c->n, sizeof(struct word), word_cmp);
+}
+
+static void pdq(void *_c)
+{
+	struct ctx *c = _c;
+
+	sort_pdq(c->words, c->n, sizeof(struct word), word_cmp);
+}
+
+static void radix(void *_c)
+{
+	struct ctx *c = _c;
+
+	sort_radix(c->words, c->n, sizeof(struct word), word_key);
+}
+
+static void parallel(void *_c)
+{
+	struct ctx *c = _c;
+
+	sort_parallel(c->words, c->n, sizeof(struct word), word_cmp, c->arg);
+}
+
+struct bench bench_sort[] = {
+	{ "sort", "rbtree",   0, setup, rbtree,   teardown, 0, 0 },
+	{ "sort", "qsort",    0, setup, libc,     teardown, 0, 0 },
+	{ "sort", "pdq",      0, setup, pdq,      teardown, 0, 0 },
+	{ "sort", "radix",    0, setup, radix,    teardown, 0, 0 },
+	{ "sort", "parallel", 1, setup, parallel, teardown, 0, 0 },
+	{ "sort", "parallel", 4, setup, parallel, teardown, 0, 0 },
+	BENCH_END
+};
@@ -0,0 +1,102 @@
+#define _GNU_SOURCE             // For memmem().
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "strmatch.h"
+
+#define ALPHABET        16      // Distinct chars. in the text.
+#define PARALLEL_THREADS 4
+
+struct ctx {
+	char   *txt;
+	size_t n;
+	char   *pat;
+	size_t m;
+};
+
+/* The pattern is cut from the middle of the text, so it occurs at least once. */
+static void *setup(size_t n, int m)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	size_t i;
+
+	if (n < (size_t) m)
+		n = m;
+
+	c->txt = malloc(n + 1);
+	c->n   = n;
+	c->m   = m;
+
+	for (i = 0; i < n; i++)
+		c->txt[i] = 'a' + bench_rand() % ALPHABET;
+
+	c->txt[n] = '\0';
+	c->pat    = c->txt + (n - m) / 2;
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	free(c->txt);
+	free(c);
+}
+
+#define BENCH_ALGO(name, fn)                                                    \
+	static void name(void *_c)                                              \
+	{                                                                       \
+		struct ctx *c = _c;                                             \
+		bench_sink = fn(c->txt, c->n, c->pat, c->m, NULL, NULL);        \
+	}
+
+BENCH_ALGO(rk, strmatch_rk_buf)
+BENCH_ALGO(simd, strmatch_simd_buf)
+BENCH_ALGO(kmp, strmatch_kmp_buf)
+BENCH_ALGO(bmh, strmatch_bmh_buf)
+BENCH_ALGO(tw, strmatch_tw_buf)
+BENCH_ALGO(selected, strmatch)
+
+/* The C library's matcher, for reference. */
+static void libc(void *_c)
+{
+	struct ctx *c = _c;
+	const char *p = c->txt, *end = c->txt + c->n;
+	unsigned long matches = 0;
+
+	while ((p = memmem(p, end - p, c->pat, c->m))) {
+		matches++;
+		p++;
+	}
+
+	bench_sink = matches;
+}
+
+static void parallel(void *_c)
+{
+	struct ctx *c = _c;
+
+	bench_sink = strmatch_parallel(c->txt, c->n, c->pat, c->m,
+				       PARALLEL_THREADS, NULL, NULL);
+}
+
+#define BENCH_PAT(m)                                                            \
+	{ "strmatch", "rk",       m, setup, rk,       teardown, 1, 1 },         \
+	{ "strmatch", "simd",     m, setup, simd,     teardown, 1, 1 },         \
+	{ "strmatch", "kmp",      m, setup, kmp,      teardown, 1, 1 },         \
+	{ "strmatch", "bmh",      m, setup, bmh,      teardown, 1, 1 },         \
+	{ "strmatch", "tw",       m, setup, tw,       teardown, 1, 1 },         \
+	{ "strmatch", "auto",     m, setup, selected, teardown, 1, 1 },         \
+	{ "strmatch", "memmem",   m, setup, libc,     teardown, 1, 1 },         \
+	{ "strmatch", "parallel", m, setup, parallel, teardown, 1, 1 }
+
+/* The argument is the pattern length. */
+struct bench bench_strmatch[] = {
+	BENCH_PAT(4),
+	BENCH_PAT(16),
+	BENCH_PAT(64),
+	BENCH_END
+};
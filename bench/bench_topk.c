@@ -0,0 +1,304 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "hash.h"
+#include "hashfn.h"
+#include "sketch.h"
+
+/* Streams are drawn from a vocabulary of synthetic words, with a Zipf
+ * distribution, which is roughly how words occur in natural language. */
+#define VOCAB    100000
+#define ZIPF_S   1.1
+#define WORD_SZ  8
+#define TOP      100            // Items checked for accuracy.
+#define EXACT_SZ 65536
+
+struct ctx {
+	uint32_t *ids;              // Of words in the vocabulary.
+	size_t   n;
+	int      arg;
+};
+
+/* Exact counts, as in main.c's dictionary pipeline. */
+struct count {
+	struct list_head list;
+	char             *word;
+	unsigned long    count;
+};
+
+static char vocab[VOCAB][WORD_SZ];
+static size_t lens[VOCAB];
+static double *cdf;
+
+static void init_vocab(void)
+{
+	double sum = 0, acc = 0;
+	int i;
+
+	cdf = malloc(VOCAB * sizeof(double));
+
+	for (i = 0; i < VOCAB; i++) {
+		lens[i] = sprintf(vocab[i], "w%d", i);
+		sum    += pow(i + 1, -ZIPF_S);
+	}
+
+	for (i = 0; i < VOCAB; i++) {
+		acc   += pow(i + 1, -ZIPF_S) / sum;
+		cdf[i] = acc;
+	}
+}
+
+/* Draws by binary search over the cumulative distribution. */
+static uint32_t zipf(void)
+{
+	double u = (bench_rand() >> 11) * (1.0 / 9007199254740992.0);
+	uint32_t lo = 0, hi = VOCAB - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+
+		if (cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void *setup(size_t n, int arg)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	size_t i;
+
+	if (!cdf)
+		init_vocab();
+
+	c->ids = malloc(n * sizeof(uint32_t));
+	c->n   = n;
+	c->arg = arg;
+
+	for (i = 0; i < n; i++)
+		c->ids[i] = zipf();
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+
+	free(c->ids);
+	free(c);
+}
+
+static int cmp(struct list_head *x, const void *word)
+{
+	return !strcmp(list_entry(x, struct count, list)->word, word);
+}
+
+static int cmp_counts(const void *_a, const void *_b)
+{
+	const struct count *a = *(const struct count **) _a;
+	const struct count *b = *(const struct count **) _b;
+
+	return (a->count < b->count) - (a->count > b->count);
+}
+
+/* Counts every word in a hash table, then sorts them all by count. */
+static void exact(void *_c)
+{
+	struct ctx *c = _c;
+	struct hash_table *ht = make_hash_table(EXACT_SZ, hash_fn_string, cmp);
+	struct count **all = malloc(VOCAB * sizeof(struct count *)), *wc;
+	struct list_head *x;
+	size_t i, n = 0;
+	const char *w;
+
+	for (i = 0; i < c->n; i++) {
+		w = vocab[c->ids[i]];
+
+		if ((x = hash_search(ht, w))) {
+			list_entry(x, struct count, list)->count++;
+			continue;
+		}
+
+		wc        = malloc(sizeof(struct count));
+		wc->word  = malloc(lens[c->ids[i]] + 1);
+		wc->count = 1;
+		memcpy(wc->word, w, lens[c->ids[i]] + 1);
+
+		hash_insert(ht, &wc->list, wc->word);
+		all[n++] = wc;
+	}
+
+	qsort(all, n, sizeof(struct count *), cmp_counts);
+	bench_sink = all[0]->count;
+
+	for (i = 0; i < n; i++) {
+		free(all[i]->word);
+		free(all[i]);
+	}
+
+	free(all);
+	free(ht->table);
+	free(ht);
+}
+
+static struct topk *count_topk(struct ctx *c)
+{
+	struct topk *t = make_topk(c->arg);
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		topk_add(t, vocab[c->ids[i]], lens[c->ids[i]]);
+
+	return t;
+}
+
+static void spacesaving(void *_c)
+{
+	struct ctx *c = _c;
+	struct topk_counter *out = malloc(c->arg * sizeof(struct topk_counter));
+	struct topk *t = count_topk(c);
+
+	bench_sink = topk_list(t, out) ? out[0].count : 0;
+
+	free(out);
+	topk_destroy(t);
+}
+
+/* The argument is 1 / epsilon. */
+static struct cms *count_cms(struct ctx *c)
+{
+	struct cms *s = make_cms(1.0 / c->arg, 0.01);
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		cms_add(s, hash_bytes(vocab[c->ids[i]], lens[c->ids[i]], 0), 1);
+
+	return s;
+}
+
+static void countmin(void *_c)
+{
+	struct cms *s = count_cms(_c);
+
+	bench_sink = s->total;
+
+	cms_destroy(s);
+}
+
+/* --- Accuracy --- */
+
+static unsigned long *true_counts(struct ctx *c)
+{
+	unsigned long *counts = calloc(VOCAB, sizeof(unsigned long));
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		counts[c->ids[i]]++;
+
+	return counts;
+}
+
+/* The count of the TOP-th most frequent word, which any word in the true top
+ * has at least. */
+static unsigned long top_threshold(const unsigned long *counts)
+{
+	unsigned long *sorted = malloc(VOCAB * sizeof(unsigned long)), t;
+	size_t i, j;
+
+	memcpy(sorted, counts, VOCAB * sizeof(unsigned long));
+
+	/* Partial selection sort; TOP is small. */
+	for (i = 0; i < TOP; i++) {
+		for (j = i + 1; j < VOCAB; j++) {
+			if (sorted[j] > sorted[i]) {
+				t         = sorted[i];
+				sorted[i] = sorted[j];
+				sorted[j] = t;
+			}
+		}
+	}
+
+	t = sorted[TOP - 1];
+	free(sorted);
+
+	return t;
+}
+
+/* Prints the share of the reported top words that are in the true top, and
+ * the largest overestimate among them. */
+static void *setup_topk(size_t n, int k)
+{
+	struct ctx *c = setup(n, k);
+	struct topk_counter *out = malloc(k * sizeof(struct topk_counter));
+	unsigned long *counts = true_counts(c), min = top_threshold(counts);
+	unsigned long hits = 0, err, max_err = 0;
+	struct topk *t = count_topk(c);
+	char word[WORD_SZ];
+	int i, nout = topk_list(t, out);
+
+	for (i = 0; i < nout && i < TOP; i++) {
+		memcpy(word, out[i].key, out[i].len);
+		word[out[i].len] = 0;
+
+		err     = out[i].count - counts[atoi(word + 1)];
+		max_err = err > max_err ? err : max_err;
+		hits   += counts[atoi(word + 1)] >= min;
+	}
+
+	fprintf(stderr, "topk accuracy: k=%d items=%zu precision@%d=%.2f "
+		"max_err=%lu bound=%zu\n", k, n, TOP,
+		(double) hits / (nout < TOP ? nout : TOP), max_err, n / k);
+
+	topk_destroy(t);
+	free(counts);
+	free(out);
+
+	return c;
+}
+
+/* Prints the largest and average overestimates of the true top words. */
+static void *setup_cms(size_t n, int inv_eps)
+{
+	struct ctx *c = setup(n, inv_eps);
+	unsigned long *counts = true_counts(c), min = top_threshold(counts);
+	unsigned long err, max_err = 0, sum = 0, m = 0;
+	struct cms *s = count_cms(c);
+	int i;
+
+	for (i = 0; i < VOCAB; i++) {
+		if (counts[i] < min || !counts[i])
+			continue;
+
+		err      = cms_estimate(s, hash_bytes(vocab[i], lens[i], 0)) -
+			   counts[i];
+		max_err  = err > max_err ? err : max_err;
+		sum     += err;
+		m++;
+	}
+
+	fprintf(stderr, "cms accuracy: eps=1/%d items=%zu max_err=%lu "
+		"avg_err=%.2f bound=%zu bytes=%zu\n", inv_eps, n, max_err,
+		m ? (double) sum / m : 0, n / inv_eps,
+		(size_t) s->width * s->depth * sizeof(uint32_t));
+
+	cms_destroy(s);
+	free(counts);
+
+	return c;
+}
+
+struct bench bench_topk[] = {
+	{ "topk", "exact",       0,    setup,      exact,       teardown, 1, 0 },
+	{ "topk", "spacesaving", 256,  setup_topk, spacesaving, teardown, 1, 0 },
+	{ "topk", "spacesaving", 4096, setup_topk, spacesaving, teardown, 1, 0 },
+	{ "topk", "countmin",    1000, setup_cms,  countmin,    teardown, 1, 0 },
+	BENCH_END
+};
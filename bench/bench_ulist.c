@@ -0,0 +1,126 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "list.h"
+#include "ulist.h"
+
+enum { ULIST = 0, LIST };
+
+struct entry {
+	struct list_head list;
+	void             *value;
+};
+
+/* The same n values, held in an unrolled list and in a doubly linked one. */
+struct ctx {
+	struct ulist     *ul, *other_ul;
+	struct list_head head, other_head;
+	struct entry     *entries;
+	size_t           n;
+};
+
+static void *setup(size_t n, int unused)
+{
+	struct ctx *c = malloc(sizeof(struct ctx));
+	unsigned long *keys = bench_keys(n);
+	size_t i;
+
+	(void) unused;
+
+	c->ul       = make_ulist();
+	c->other_ul = make_ulist();
+	c->entries  = malloc(n * sizeof(struct entry));
+	c->n        = n;
+
+	INIT_LIST_HEAD(&c->head);
+	INIT_LIST_HEAD(&c->other_head);
+
+	for (i = 0; i < n; i++) {
+		c->entries[i].value = (void *) (uintptr_t) keys[i];
+		ulist_add_tail(c->entries[i].value, c->ul);
+
+		/* Scatters the entries in memory, as separate allocs. would. */
+		list_add_tail(&c->entries[keys[i] - 1].list, &c->head);
+	}
+
+	free(keys);
+
+	return c;
+}
+
+static void teardown(void *_c)
+{
+	struct ctx *c = _c;
+	struct entry *e, *next;
+
+	list_for_each_entry_safe(e, next, &c->other_head, list)
+		free(e);
+
+	ulist_destroy(c->ul);
+	ulist_destroy(c->other_ul);
+	free(c->entries);
+	free(c);
+}
+
+static void iterate_ulist(void *_c)
+{
+	struct ctx *c = _c;
+	struct ulist_chunk *chunk;
+	unsigned long sum = 0;
+	void *pos;
+	int i;
+
+	ulist_for_each(pos, chunk, i, c->ul)
+		sum += (uintptr_t) pos;
+
+	bench_sink = sum;
+}
+
+static void iterate_list(void *_c)
+{
+	struct ctx *c = _c;
+	struct entry *pos;
+	unsigned long sum = 0;
+
+	list_for_each_entry(pos, &c->head, list)
+		sum += (uintptr_t) pos->value;
+
+	bench_sink = sum;
+}
+
+/* Builds a second list out of the same values. The doubly linked list needs
+ * an alloc. per element, the unrolled one only per chunk. */
+static void append_ulist(void *_c)
+{
+	struct ctx *c = _c;
+	size_t i;
+
+	for (i = 0; i < c->n; i++)
+		ulist_add_tail(c->entries[i].value, c->other_ul);
+}
+
+static void append_list(void *_c)
+{
+	struct ctx *c = _c;
+	struct entry *e;
+	size_t i;
+
+	for (i = 0; i < c->n; i++) {
+		e        = malloc(sizeof(struct entry));
+		e->value = c->entries[i].value;
+		list_add_tail(&e->list, &c->other_head);
+	}
+}
+
+struct bench bench_ulist[] = {
+	{ "ulist", "iterate_ulist", ULIST, setup, iterate_ulist, teardown,
+	  1, sizeof(void *) },
+	{ "ulist", "iterate_list",  LIST,  setup, iterate_list,  teardown,
+	  1, sizeof(void *) },
+	{ "ulist", "append_ulist",  ULIST, setup, append_ulist,  teardown,
+	  0, 0 },
+	{ "ulist", "append_list",   LIST,  setup, append_list,   teardown,
+	  0, 0 },
+	BENCH_END
+};
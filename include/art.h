@@ -0,0 +1,121 @@
+/*
+ * art.h: Implementation of adaptive radix trees (ART) [1], which are ordered
+ *        maps from byte strings to values. Rather than comparing whole keys at
+ *        every level, as red-black trees do, keys are looked up one byte at a
+ *        time, each byte picking the child to go down to. A lookup thus takes
+ *        time proportional to the length of the key, whatever the number of
+ *        keys in the tree.
+ *
+ *        Inner nodes adapt their layout to the number of children they have,
+ *        which keeps the tree compact:
+ *
+ *         - Node4 and Node16 hold sorted key bytes along with the children,
+ *           Node16 being searched with SIMD instructions where available.
+ *         - Node48 indexes up to 48 children by key byte, through 256 slots.
+ *         - Node256 is a plain array of children, one per key byte.
+ *
+ *        Nodes grow and shrink from one layout to another as children come and
+ *        go. Chains of nodes with a single child are collapsed into a prefix
+ *        held by the node below (_path compression_); only the first few bytes
+ *        of a prefix are stored, the rest being checked against a leaf when
+ *        needed. Leaves are only made for whole keys, and hang directly from
+ *        the node where their key stops being shared (_lazy expansion_.)
+ *
+ *        Keys are arbitrary bytes, and may be prefixes of one another: a key
+ *        ending at an inner node is kept aside in that node. Iteration is in
+ *        lexicographic order of the keys, bytes being compared as unsigned.
+ *
+ * Summary of operations for adaptive radix trees:
+ *
+ *  - make_art()                Allocs. a tree.
+ *  - art_insert()              Inserts (or replaces) the value for a key.
+ *  - art_search()              Gets the value for a key.
+ *  - art_delete()              Deletes a key, returning its value.
+ *  - art_minimum()             Gets the leaf with the minimal key.
+ *  - art_maximum()             Gets the leaf with the maximal key.
+ *  - art_walk()                Traverses the leaves in order.
+ *  - art_prefix_walk()         Traverses the leaves whose key has a prefix.
+ *  - art_destroy()             Deallocs. the tree and its leaves.
+ *  - art_stats_dump()          Prints/returns the counters, see stats.h.
+ *
+ * [1] "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases", by
+ *     V. Leis, A. Kemper and T. Neumann. The layout of prefixes and the
+ *     algorithms are close to those of libart, by A. Dadgar.
+ */
+
+#ifndef ART_H_
+#define ART_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint8_t and co.
+
+#include "stats.h"              // For instrumentation counters.
+
+/* Prefix bytes stored in inner nodes. Longer prefixes are partly stored. */
+#define ART_MAX_PREFIX 10
+
+typedef enum {
+	ART_NODE4 = 0, ART_NODE16, ART_NODE48, ART_NODE256
+} art_node_t;
+
+/* Grows and shrinks count the changes of node layout. */
+struct art_stats {
+	unsigned long inserts;
+	unsigned long deletes;
+	unsigned long searches;
+	unsigned long grows;
+	unsigned long shrinks;
+};
+
+/* The key is copied into the leaf. */
+struct art_leaf {
+	void          *value;
+	size_t        len;
+	unsigned char key[];
+};
+
+/* Common to all inner nodes, which are told apart by type. */
+struct art_node {
+	uint8_t         type;
+	uint16_t        n;          // Children.
+	uint32_t        prefix_len; // May be more than what's stored.
+	unsigned char   prefix[ART_MAX_PREFIX];
+
+	struct art_leaf *end;       // For the key ending here, if any.
+};
+
+/* Children are either inner nodes or leaves, the latter being told apart by
+ * having the lowest bit of their address set. */
+struct art {
+	void             *root;
+	size_t           n;
+
+	struct art_stats stats;
+};
+
+/* For visiting leaves in order. Returning nonzero stops the traversal. */
+typedef int (*art_visit)(struct art_leaf *, void *);
+
+/* --- API --- */
+
+struct art *make_art(void);
+
+void *art_insert(struct art *, const void *, size_t, void *);
+
+void *art_search(struct art *, const void *, size_t);
+
+void *art_delete(struct art *, const void *, size_t);
+
+struct art_leaf *art_minimum(struct art *);
+
+struct art_leaf *art_maximum(struct art *);
+
+int art_walk(struct art *, art_visit, void *);
+
+int art_prefix_walk(struct art *, const void *, size_t, art_visit, void *);
+
+void art_destroy(struct art *);
+
+struct art_stats art_stats_dump(struct art *, FILE *);
+
+#endif // ART_H_
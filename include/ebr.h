@@ -0,0 +1,79 @@
+/*
+ * ebr.h: Implementation of epoch-based reclamation (EBR), which is a way of
+ *        deferring the deallocation of memory shared by several threads until
+ *        no thread can possibly hold a reference to it.
+ *
+ *        D'après [1], threads access shared memory within _critical sections_,
+ *        delimited by ebr_enter() and ebr_exit(). Upon entering one, threads
+ *        announce the current global epoch. Memory unlinked from a shared
+ *        structure is _retired_ rather than freed, and tagged with the epoch it
+ *        was retired in. The global epoch is only advanced once every thread
+ *        within a critical section has announced it; thus, memory retired two
+ *        epochs ago can no longer be reached by anyone, and is freed.
+ *
+ *        Each thread gets a record on its first critical section, kept in a
+ *        global list. Records are released by ebr_unregister(), and reused by
+ *        threads created later on.
+ *
+ * Summary of operations for epoch-based reclamation:
+ *
+ *  - ebr_enter()               Enters a critical section.
+ *  - ebr_exit()                Exits a critical section.
+ *  - ebr_retire()              Defers the deallocation of memory.
+ *  - ebr_unregister()          Releases the record of the calling thread.
+ *
+ * [1] "Practical lock-freedom", ch. 5: Implementation issues, by K. Fraser.
+ */
+
+#ifndef EBR_H_
+#define EBR_H_
+
+#include <stdlib.h>             // For malloc().
+
+/* For deallocating retired memory. */
+typedef void (*ebr_free_fn)(void *);
+
+/* Number of epochs memory may be retired in before being freed. */
+#define EBR_EPOCHS 3
+
+/* Retire at most this many times between attempts at advancing the epoch. */
+#define EBR_RETIRE_FREQ 64
+
+struct ebr_retired {
+	void               *ptr;
+	ebr_free_fn        fn;
+
+	struct ebr_retired *next;
+};
+
+/* Memory retired by a thread, bucketed by the epoch it was retired in. */
+struct ebr_limbo {
+	struct ebr_retired *head;
+	unsigned long      epoch;
+};
+
+/* Per-thread record. The announced epoch is shifted left by one bit, with the
+ * lowest bit telling whether the thread is within a critical section, so that
+ * both are read in a single load. */
+struct ebr_record {
+	unsigned long     state;
+	int               in_use;
+	int               nest;
+	int               retired;
+
+	struct ebr_limbo  limbo[EBR_EPOCHS];
+
+	struct ebr_record *next;
+};
+
+/* --- API --- */
+
+void ebr_enter(void);
+
+void ebr_exit(void);
+
+void ebr_retire(void *, ebr_free_fn);
+
+void ebr_unregister(void);
+
+#endif // EBR_H_
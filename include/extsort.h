@@ -0,0 +1,125 @@
+/*
+ * extsort.h: Implementation of external sorting, for data sets of fixed-size
+ *            records larger than the memory they're allowed to take, which is
+ *            set when the sorter is made.
+ *
+ *            Records are fed in any number of batches. They're gathered into
+ *            a buffer until it's full, which is then sorted (see sort.h) and
+ *            written out to a temporary file as a sorted _run_. The buffer is
+ *            split in two halves, one being filled while the other one is
+ *            written out.
+ *
+ *            Runs are then merged k at a time by means of a loser tree [1]: a
+ *            tournament whose inner nodes keep the loser of the match played
+ *            there, so that replacing the winner only takes replaying the
+ *            matches on its way up, i.e. log k comparisons, with no heap
+ *            nodes to alloc. (as in fibheap.h.) Each run being merged is read
+ *            through two buffers, one being consumed while the next block is
+ *            read into the other. Should there be more runs than the memory
+ *            allows buffers for, the merge takes several passes, the last one
+ *            handing the records out in order.
+ *
+ *            Reads and writes are done by a thread of the sorter's own, so
+ *            that I/O overlaps with sorting and merging: the caller only waits
+ *            for a buffer whose I/O isn't done by the time it's needed.
+ *
+ * Summary of operations for external sorting:
+ *
+ *  - make_extsort()            Allocs. a sorter, given a memory limit.
+ *  - extsort_add()             Feeds records to the sorter.
+ *  - extsort_finish()          Merges the runs, visiting records in order.
+ *  - extsort_destroy()         Deallocs. the sorter, removing its files.
+ *  - extsort_stats_dump()      Prints/returns the counters, see stats.h.
+ *
+ * [1] "The Art of Computer Programming", vol. 3, 2nd ed, sec. 5.4.1:
+ *     Multiway Merging and Replacement Selection, by D. E. Knuth.
+ */
+
+#ifndef EXTSORT_H_
+#define EXTSORT_H_
+
+#include <pthread.h>            // For pthread_t and co.
+#include <stdio.h>              // For FILE.
+#include <sys/types.h>          // For off_t.
+
+#include "sort.h"               // For sort_cmp.
+#include "stats.h"              // For instrumentation counters.
+
+/* Size of the blocks runs are read and written in, unless the memory limit is
+ * too low for merging at least two runs with it. */
+#define EXTSORT_BLOCK (1 << 20)
+
+/* Waits are times records couldn't be handed out (or taken in) because the
+ * I/O of the buffer needed wasn't done yet. Passes count the final merge. */
+struct extsort_stats {
+	unsigned long runs;
+	unsigned long passes;
+	unsigned long bytes_read;
+	unsigned long bytes_written;
+	unsigned long waits;
+};
+
+/* A buffer read into (or written out) by the I/O thread. Busy while queued. */
+struct extsort_buf {
+	char               *data;
+	size_t             len;
+	int                fd;
+	off_t              off;
+	int                write;
+	int                busy;
+
+	struct extsort_buf *next;
+};
+
+/* Runs are ranges of a temporary file. */
+struct extsort_run {
+	off_t  off;
+	size_t len;
+};
+
+struct extsort {
+	size_t               size;      // Of records.
+	sort_cmp             cmp;
+	size_t               mem;
+	size_t               block;
+	int                  fan_in;    // Runs merged at a time.
+
+	/* Halves of the buffer runs are gathered in. */
+	struct extsort_buf   half[2];
+	int                  cur;
+	size_t               cap;       // Of each half, in bytes.
+
+	FILE                 *file;
+	off_t                end;
+	struct extsort_run   *runs;
+	int                  nruns;
+	int                  sz;
+
+	/* Queue of the I/O thread, and the error it ran into, if any. */
+	pthread_t            thread;
+	pthread_mutex_t      lock;
+	pthread_cond_t       cond;
+	struct extsort_buf   *head;
+	struct extsort_buf   *tail;
+	int                  stop;
+	int                  error;
+
+	struct extsort_stats stats;
+};
+
+/* Visits a record. Should return non-zero to stop the merge. */
+typedef int (*extsort_visit)(const void *, void *);
+
+/* --- API --- */
+
+struct extsort *make_extsort(size_t, sort_cmp, size_t);
+
+int extsort_add(struct extsort *, const void *, size_t);
+
+int extsort_finish(struct extsort *, extsort_visit, void *);
+
+void extsort_destroy(struct extsort *);
+
+struct extsort_stats extsort_stats_dump(struct extsort *, FILE *);
+
+#endif // EXTSORT_H_
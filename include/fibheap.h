@@ -25,6 +25,7 @@
  *  - fibheap_union()           Concatenates the root lists of two heaps.
  *  - fibheap_decrease()        Moves the decreased node to the heap's root list.
  *  - fibheap_delete()          Deletes a node, then consolidates the heap.
+ *  - fibheap_stats_dump()      Prints/returns the counters, see stats.h.
  *
  * [1] "Introduction to Algorithms", 3rd ed, ch. 19: Fibonacci Heaps, by CLRS.
  */
@@ -37,11 +38,26 @@
 #include <math.h>               // For sqrt(), floor(), and log().
 
 #include "list.h"               // For linked list struct. and ops.
+#include "stats.h"              // For instrumentation counters.
 
 /* For comparing any two nodes. Clients have to define this. Should return
  * negative if a has higher priority than b. */
 typedef int (*fibheap_cmp)(const void *, const void *);
 
+/* Cascading cuts count the marked ancestors cut after a node was. Allocations
+ * count the auxiliary arrays allocated by consolidations. */
+struct fibheap_stats {
+	unsigned long inserts;
+	unsigned long extracts;
+	unsigned long decreases;
+	unsigned long comparisons;
+	unsigned long consolidations;
+	unsigned long links;
+	unsigned long cuts;
+	unsigned long cascading_cuts;
+	unsigned long allocations;
+};
+
 /* Nodes are accessed by means of the heap's root list, which is implemented as
  * a circular, doubly-linked list whose head node connects to the heap node with
  * the minimal value. For convenience, the comparison function is also embedded
@@ -54,8 +70,10 @@ struct fibheap {
 	 * For setting a new min. node, use the BECOME_MIN_NODE() macro. */
 	struct list_head root_list;
 
-	fibheap_cmp      cmp;
-	int              n;
+	fibheap_cmp          cmp;
+	int                  n;
+
+	struct fibheap_stats stats;
 };
 
 /* Nodes are assorted in several circular, doubly linked lists. Conceptually, a
@@ -101,4 +119,6 @@ void fibheap_decrease(struct fibheap *, struct fibheap_node *);
 
 void fibheap_delete(struct fibheap *, struct fibheap_node *);
 
+struct fibheap_stats fibheap_stats_dump(struct fibheap *, FILE *);
+
 #endif // FIBHEAP_H_
@@ -0,0 +1,100 @@
+/*
+ * filter.h: Implementation of approximate membership filters, which tell
+ *           whether a key may be in a set, or is definitely not. They are
+ *           meant to sit in front of a hash table or a red-black tree (see
+ *           hash_attach_filter() and rbtree_attach_filter()), so that lookups
+ *           of absent keys return after a single cache line access, rather
+ *           than walking a chain or a root-to-leaf path. Keys are given to
+ *           filters as 64-bit hashes.
+ *
+ *           The blocked Bloom filter splits its bits into 256-bit blocks,
+ *           each within a cache line. A key maps to a single block, in which
+ *           it sets one bit in each of the 8 32-bit words [1]. Probing takes
+ *           a handful of instructions with AVX2 (which is used when the CPU
+ *           supports it.) The filter is sized for a given number of keys and
+ *           false positive rate. Keys can't be removed.
+ *
+ *           The cuckoo filter [2] stores 16-bit fingerprints of keys, 4 to a
+ *           bucket of 64 bits. A key may be in one of two buckets, the second
+ *           one derived from the first and the fingerprint, so that entries
+ *           can be moved between them (kicked out) to make room. Keys can be
+ *           removed. The false positive rate is fixed by the fingerprint size,
+ *           at about 8 / 2^16 (0.012%), for 16.8 bits per key when full.
+ *
+ *           Neither filter ever reports a key that was added (and not
+ *           removed) as absent.
+ *
+ * Summary of operations for filters:
+ *
+ *  - make_bloom()              Allocs. a blocked Bloom filter.
+ *  - make_cuckoo()             Allocs. a cuckoo filter.
+ *  - filter_add()              Adds a key.
+ *  - filter_test()             Tells if a key may have been added.
+ *  - filter_del()              Removes a key (cuckoo filters only.)
+ *  - filter_size()             Gets the size of the filter, in bytes.
+ *  - filter_destroy()          Deallocs. the filter.
+ *
+ * [1] "Cache-, Hash- and Space-Efficient Bloom Filters", by F. Putze, P.
+ *     Sanders and J. Singler; the block layout is Apache Parquet's.
+ * [2] "Cuckoo Filter: Practically Better Than Bloom", by B. Fan, D. G.
+ *     Andersen, M. Kaminsky and M. D. Mitzenmacher.
+ */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+/* Relocations tried by a cuckoo filter before giving up on an insertion. */
+#define FILTER_MAX_KICKS 500
+
+/* For hashing keys, e.g. by way of hash_bytes() from hashfn.h. */
+typedef uint64_t (*filter_hash)(const void *);
+
+typedef enum { FILTER_BLOOM = 0, FILTER_CUCKOO } filter_t;
+
+struct bloom {
+	uint32_t *blocks;           // nblocks * 8 words, 32-byte aligned.
+	size_t   nblocks;
+};
+
+/* The victim is an entry kicked out by an insertion that failed. It's kept
+ * aside, so that no key is lost, and the filter reports itself full. */
+struct cuckoo {
+	uint64_t *buckets;
+	size_t   mask;              // Buckets are a power of 2.
+
+	uint64_t victim_bucket;
+	uint16_t victim;            // Zero if there's none.
+
+	uint64_t rand;              // For picking entries to kick out.
+};
+
+struct filter {
+	filter_t kind;
+	size_t   n;                 // Keys added and not removed.
+
+	union {
+		struct bloom  bloom;
+		struct cuckoo cuckoo;
+	} u;
+};
+
+/* --- API --- */
+
+struct filter *make_bloom(size_t, double);
+
+struct filter *make_cuckoo(size_t);
+
+int filter_add(struct filter *, uint64_t);
+
+int filter_test(struct filter *, uint64_t);
+
+int filter_del(struct filter *, uint64_t);
+
+size_t filter_size(struct filter *);
+
+void filter_destroy(struct filter *);
+
+#endif // FILTER_H_
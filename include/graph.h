@@ -0,0 +1,75 @@
+/*
+ * graph.h: Implementation of weighted graphs stored in compressed sparse row
+ *          (CSR) form, along with Dijkstra's single-source shortest paths and
+ *          Prim's minimum spanning tree algorithms.
+ *
+ *          In CSR form, the arcs leaving each vertex are laid out contiguously
+ *          in a single array, sorted by their source vertex. The arcs leaving
+ *          vertex v are found at adj[off[v]..off[v + 1]), along with their
+ *          weights in w. Thus, scanning the neighbourhood of a vertex touches
+ *          consecutive memory, rather than chasing a pointer per arc.
+ *
+ *          Both algorithms are driven by a min-priority queue supporting the
+ *          decrease-key op., which is where Fibonacci heaps shine in theory [1].
+ *          Since constant factors tend to dominate in practice, the queue can
+ *          be picked by clients on each call.
+ *
+ * Summary of operations for graphs:
+ *
+ *  - make_graph()              Allocs. a graph from a list of edges.
+ *  - graph_dijkstra()          Computes shortest paths from a single source.
+ *  - graph_prim()              Computes a minimum spanning forest.
+ *  - graph_destroy()           Deallocs. the graph.
+ *
+ * Summary of priority queues:
+ *
+ *  - GRAPH_FIBHEAP             Fibonacci heap, see fibheap.h.
+ *  - GRAPH_BINHEAP             Binary heap indexed by vertex.
+ *  - GRAPH_RADIXHEAP           Radix heap, see radixheap.h. Dijkstra only.
+ *
+ * [1] "Introduction to Algorithms", 3rd ed, ch. 23: Minimum Spanning Trees,
+ *     and ch. 24: Single-Source Shortest Paths, by CLRS.
+ */
+
+#ifndef GRAPH_H_
+#define GRAPH_H_
+
+#include <limits.h>             // For ULONG_MAX.
+#include <stdlib.h>             // For malloc().
+
+/* Distance to unreachable vertices. */
+#define GRAPH_INF ULONG_MAX
+
+/* The priority queue driving Dijkstra's and Prim's algorithms. */
+enum graph_heap { GRAPH_FIBHEAP = 0, GRAPH_BINHEAP, GRAPH_RADIXHEAP };
+
+/* An edge from u to v, as given to make_graph(). */
+struct graph_edge {
+	int          u;
+	int          v;
+	unsigned int w;
+};
+
+/* Vertices are numbered from 0 to n - 1. For undirected graphs, each edge is
+ * stored as a pair of arcs, so m counts arcs rather than edges. */
+struct graph {
+	int          *off;  // Arcs leaving v are at off[v]..off[v + 1].
+	int          *adj;  // Target vertex of each arc.
+	unsigned int *w;    // Weight of each arc.
+
+	int          n;
+	int          m;
+};
+
+/* --- API --- */
+
+struct graph *make_graph(int, const struct graph_edge *, int, int);
+
+void graph_dijkstra(struct graph *, int, enum graph_heap, unsigned long *,
+		    int *);
+
+unsigned long graph_prim(struct graph *, enum graph_heap, int *);
+
+void graph_destroy(struct graph *);
+
+#endif // GRAPH_H_
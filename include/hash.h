@@ -5,15 +5,31 @@
  *         collisions, keeping queries fast.
  *
  *         Since this is intented to be a generic implementation, clients are
- *         left to implement their own custom hash and compare functions that
- *         work with the desired data type to store in the table.
+ *         left to implement their own custom compare functions that work with
+ *         the desired data type to store in the table. Hash functions for the
+ *         usual key types (strings, integers, pointers) are in hashfn.h; custom
+ *         ones may be used as well.
+ *
+ *         Hashes are reduced to bucket indices by the table: masking when the
+ *         size is a power of 2, modulo otherwise. Thus, functions that return
+ *         indices (below the size) keep working as before.
+ *
+ *         A filter (see filter.h) can be attached to a table, so that searches
+ *         for keys that aren't in it mostly return without walking a chain.
+ *         It's given hash_mix64() of the hash of each key, so it's only as
+ *         selective as the hash function (functions returning indices make it
+ *         useless.) Should the filter fill up, it's detached.
  *
  * Summary of operations for hash tables:
  *
  *  - make_hash_table()         Allocs. a table.
  *  - hash_insert()             Inserts an entry in the list of its bucket.
  *  - hash_search()             Searches for an entry in the list of its bucket.
+ *  - hash_bucket()             Gets the list of the bucket a key hashes to.
  *  - hash_delete()             Removes an entry from the table.
+ *  - hash_remove()             Removes an entry, and its key from the filter.
+ *  - hash_attach_filter()      Attaches a filter to an empty table.
+ *  - hash_stats_dump()         Prints/returns the counters, see stats.h.
  */
 
 #ifndef HASH_H_
@@ -21,19 +37,39 @@
 
 #include <stdlib.h>             // For malloc().
 
+#include "filter.h"             // For struct filter.
+#include "hashfn.h"             // For the built-in hash functions.
 #include "list.h"               // For linked list struct. and ops.
+#include "stats.h"              // For instrumentation counters.
 
-/* For determining the bucket associated with items. */
+/* For determining the bucket associated with items, e.g. hash_fn_string(). */
 typedef unsigned int(*hash_fn)(const void *);
 
 /* For comparing items when performing searches. */
 typedef int(*hash_cmp)(struct list_head *, const void *);
 
+/* Probes count the entries compared against while searching. Filtered
+ * searches are the misses answered by the filter alone. */
+struct hash_stats {
+	unsigned long inserts;
+	unsigned long searches;
+	unsigned long misses;
+	unsigned long probes;
+	unsigned long max_probes;  // Longest chain walked by a single search.
+	unsigned long filtered;
+};
+
 struct hash_table {
-	struct list_head *table;
+	struct list_head  *table;
+	int               sz;
+	unsigned int      mask;     // sz - 1 if sz is a power of 2, zero otherwise.
+
+	hash_fn           fn;
+	hash_cmp          cmp;
 
-	hash_fn          fn;
-	hash_cmp         cmp;
+	struct filter     *filter;  // NULL unless attached.
+
+	struct hash_stats stats;
 };
 
 /* --- API --- */
@@ -44,6 +80,14 @@ void hash_insert(struct hash_table *, struct list_head *, const void *);
 
 struct list_head *hash_search(struct hash_table *, const void *);
 
+struct list_head *hash_bucket(struct hash_table *, const void *);
+
 void hash_delete(struct list_head *);
 
+void hash_remove(struct hash_table *, struct list_head *, const void *);
+
+void hash_attach_filter(struct hash_table *, struct filter *);
+
+struct hash_stats hash_stats_dump(struct hash_table *, FILE *);
+
 #endif // HASH_H_
@@ -0,0 +1,105 @@
+/*
+ * hashfn.h: Fast, general purpose hash functions, meant for use with hash.h
+ *           (but not tied to it.) None of them is cryptographic: they're
+ *           meant for spreading keys evenly over buckets, not for resisting an
+ *           attacker that picks the keys.
+ *
+ *           Byte strings are hashed d'après wyhash [1]: up to 16 bytes are
+ *           read in two (possibly overlapping) words, longer keys 16 or 48
+ *           bytes at a time, and every step folds the 128-bit product of two
+ *           words into one. Each byte thus costs a fraction of a multiply,
+ *           rather than a division as with the usual hash modulo a prime.
+ *
+ *           Keys of HASH_LONG_KEY bytes or more are instead accumulated in the
+ *           manner of XXH3 [2]: 8 lanes of 64 bits take a 32x32-bit product
+ *           and an add per 8 bytes, which maps onto SIMD registers. The AVX2
+ *           variant is picked at startup if the CPU supports it, and computes
+ *           the exact same hashes as the scalar one, so that hashes may be
+ *           stored, and read back on any machine.
+ *
+ *           Integers are hashed by mixers (a.k.a. finalizers), bijective
+ *           functions where every input bit affects every output bit. See
+ *           [3] and [4]. These are only a few instructions long, so they're
+ *           defined here, for inlining.
+ *
+ *           The hash_fn_*() functions wrap the above in the signature expected
+ *           by make_hash_table().
+ *
+ * Summary of operations:
+ *
+ *  - hash_bytes()              Hashes a buffer, given a seed.
+ *  - hash_string()             Hashes a NUL-terminated string.
+ *  - hash_mix64()              Mixes the bits of a 64-bit integer.
+ *  - hash_mix32()              Mixes the bits of a 32-bit integer.
+ *  - hash_range()              Maps a 32-bit hash to 0..n - 1.
+ *  - hash_bytes_isa()          Gets the name of the variant used for long keys.
+ *  - hash_fn_string()          hash_fn for (char *) keys.
+ *  - hash_fn_u64()             hash_fn for (uint64_t *) keys.
+ *  - hash_fn_u32()             hash_fn for (uint32_t *) keys.
+ *  - hash_fn_ptr()             hash_fn hashing the key pointer itself.
+ *
+ * [1] https://github.com/wangyi-fudan/wyhash.
+ * [2] https://github.com/Cyan4973/xxHash (XXH3's long-input loop.)
+ * [3] https://nullprogram.com/blog/2018/07/31/ (the 32-bit mixer.)
+ * [4] "Fast splittable pseudorandom number generators", by G. L. Steele Jr.,
+ *     D. Lea and C. H. Flood (the 64-bit mixer.)
+ * [5] "A fast alternative to the modulo reduction", by D. Lemire.
+ */
+
+#ifndef HASHFN_H_
+#define HASHFN_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+/* Keys this long (in bytes) go through the SIMD-friendly loop. */
+#define HASH_LONG_KEY 256
+
+/* The finalizer of SplitMix64 [4]. */
+static inline uint64_t hash_mix64(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+
+	return x;
+}
+
+/* Chris Wellons' "lowbias32" [3]. */
+static inline uint32_t hash_mix32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+
+	return x;
+}
+
+/* Takes the high half of x * n [5], which is fair as long as the bits of x
+ * are, without a division. */
+static inline size_t hash_range(uint32_t x, size_t n)
+{
+	return (size_t) (((uint64_t) x * n) >> 32);
+}
+
+/* --- API --- */
+
+uint64_t hash_bytes(const void *, size_t, uint64_t);
+
+uint64_t hash_string(const char *);
+
+const char *hash_bytes_isa(void);
+
+unsigned int hash_fn_string(const void *);
+
+unsigned int hash_fn_u64(const void *);
+
+unsigned int hash_fn_u32(const void *);
+
+unsigned int hash_fn_ptr(const void *);
+
+#endif // HASHFN_H_
@@ -0,0 +1,77 @@
+/*
+ * image.h: Implementation of images, which are copies of data structures laid
+ *          out in a single contiguous array, with no pointers in it (sections
+ *          refer to each other by offsets from the start.) Images can thus be
+ *          written to a file as they are in memory, then mapped back in with
+ *          mmap() in constant time, however large they are, and queried in
+ *          place: pages are only read from disk as they're first touched.
+ *
+ *          Every image starts with a header telling what it holds, the version
+ *          of its layout, its size and a checksum of the rest. Loading fails
+ *          on a mismatch of any of these (images are meant to be rebuilt from
+ *          the source data, not converted.) Since verifying the checksum takes
+ *          a pass over the whole image, it's up to the caller whether to do it
+ *          (e.g. once, after the file is copied over from where it was built.)
+ *
+ *          Images are only portable across machines with the same byte order;
+ *          loading fails on the others. Past the header, each kind of image
+ *          checks its own sections on loading, so that a corrupt header can't
+ *          send lookups outside of the mapping.
+ *
+ *          See phash.h, smap.h and sarray.h for the structures that can be
+ *          saved.
+ *
+ * Summary of operations for images:
+ *
+ *  - image_seal()              Fills in the header of a freshly built image.
+ *  - image_check()             Checks the header (and checksum) of an image.
+ *  - image_save()              Writes an image to a file.
+ *  - image_load()              Maps an image in from a file.
+ *  - image_unload()            Unmaps an image.
+ *  - image_destroy()           Unmaps (or frees) an image, however it was made.
+ */
+
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+/* Written in the machine's byte order, so that images built on machines of
+ * the other one can be told apart. */
+#define IMAGE_BOM 0x01020304u
+
+/* Rounds x up to a multiple of a, a power of 2. Sections start at offsets
+ * aligned to the widest type in them. */
+#define IMAGE_ALIGN(x, a) (((x) + (a) - 1) & ~(size_t) ((a) - 1))
+
+struct image_hdr {
+	uint32_t magic;             // What the image holds, e.g. PHASH_MAGIC.
+	uint32_t version;           // Of its layout.
+	uint32_t bom;
+	uint32_t unused;
+
+	uint64_t size;              // Of the whole image, this header included.
+	uint64_t checksum;          // Of everything past this header.
+};
+
+/* For checking, in constant time, that the sections of a loaded image are in
+ * order and within it. Should return non-zero if they are. */
+typedef int (*image_valid)(const struct image_hdr *);
+
+/* --- API --- */
+
+void image_seal(struct image_hdr *, uint32_t, uint32_t, uint64_t);
+
+int image_check(const struct image_hdr *, size_t, uint32_t, uint32_t, int);
+
+int image_save(const struct image_hdr *, const char *);
+
+struct image_hdr *image_load(const char *, uint32_t, uint32_t, int,
+			     image_valid);
+
+void image_unload(struct image_hdr *);
+
+void image_destroy(struct image_hdr *, int);
+
+#endif // IMAGE_H_
@@ -0,0 +1,105 @@
+/*
+ * lfqueue.h: Implementation of lock-free FIFO queues for handing work items
+ *            over between threads.
+ *
+ *            The MPSC queue (multiple producers, single consumer) is due to D.
+ *            Vyukov [1]. It is _intrusive_: as with list.h, clients embed a
+ *            node in the structs. to queue, and fetch them back by means of
+ *            container_of(). It is unbounded, and never allocates. Producers
+ *            take a single atomic exchange each, and the consumer none, as
+ *            long as the queue isn't about to run empty.
+ *
+ *            The MPMC queue (multiple producers and consumers) is a bounded
+ *            ring buffer of pointers, also due to D. Vyukov [2]. Each slot is
+ *            tagged with a sequence number telling the round in which it may
+ *            next be written or read, so that claiming a slot takes a single
+ *            compare-and-swap on the enqueue (or dequeue) position.
+ *
+ *            Both queues support enqueueing and dequeueing in batches, which
+ *            take a single atomic op. per batch rather than one per item.
+ *
+ * Summary of operations for MPSC queues:
+ *
+ *  - make_mpsc()               Allocs. a queue.
+ *  - mpsc_push()               Appends a node to the queue.
+ *  - mpsc_push_batch()         Appends an array of nodes to the queue.
+ *  - mpsc_pop()                Detaches the node at the front of the queue.
+ *  - mpsc_pop_batch()          Detaches up to n nodes.
+ *
+ * Summary of operations for MPMC queues:
+ *
+ *  - make_mpmc()               Allocs. a queue.
+ *  - mpmc_enqueue()            Appends an item to the queue, unless full.
+ *  - mpmc_enqueue_batch()      Appends up to n items to the queue.
+ *  - mpmc_dequeue()            Detaches the item at the front, unless empty.
+ *  - mpmc_dequeue_batch()      Detaches up to n items.
+ *  - mpmc_destroy()            Deallocs. the queue.
+ *
+ * [1] https://www.1024cores.net/home/lock-free-algorithms/queues/
+ *     intrusive-mpsc-node-based-queue.
+ * [2] https://www.1024cores.net/home/lock-free-algorithms/queues/
+ *     bounded-mpmc-queue.
+ */
+
+#ifndef LFQUEUE_H_
+#define LFQUEUE_H_
+
+#include <stdlib.h>             // For malloc().
+
+#include "list.h"               // For container_of().
+
+/* Padding so that producers and consumers don't share cache lines. */
+#define LFQUEUE_CACHE_LINE 64
+
+struct mpsc_node {
+	struct mpsc_node *next;
+};
+
+/* Producers append at the head, while the consumer detaches from the tail. The
+ * stub node keeps the queue from ever being empty, which is what lets the
+ * consumer work without atomic ops. */
+struct mpsc_queue {
+	struct mpsc_node *head __attribute__ ((aligned (LFQUEUE_CACHE_LINE)));
+	struct mpsc_node *tail __attribute__ ((aligned (LFQUEUE_CACHE_LINE)));
+
+	struct mpsc_node stub;
+};
+
+struct mpmc_cell {
+	unsigned long seq;
+	void          *data;
+};
+
+struct mpmc_queue {
+	struct mpmc_cell *cells;
+	unsigned long    mask;  // Capacity minus one; capacity is a power of 2.
+
+	unsigned long    enq __attribute__ ((aligned (LFQUEUE_CACHE_LINE)));
+	unsigned long    deq __attribute__ ((aligned (LFQUEUE_CACHE_LINE)));
+};
+
+/* --- API --- */
+
+struct mpsc_queue *make_mpsc(void);
+
+void mpsc_push(struct mpsc_queue *, struct mpsc_node *);
+
+void mpsc_push_batch(struct mpsc_queue *, struct mpsc_node **, int);
+
+struct mpsc_node *mpsc_pop(struct mpsc_queue *);
+
+int mpsc_pop_batch(struct mpsc_queue *, struct mpsc_node **, int);
+
+struct mpmc_queue *make_mpmc(unsigned long);
+
+int mpmc_enqueue(struct mpmc_queue *, void *);
+
+int mpmc_enqueue_batch(struct mpmc_queue *, void **, int);
+
+void *mpmc_dequeue(struct mpmc_queue *);
+
+int mpmc_dequeue_batch(struct mpmc_queue *, void **, int);
+
+void mpmc_destroy(struct mpmc_queue *);
+
+#endif // LFQUEUE_H_
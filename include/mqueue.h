@@ -0,0 +1,75 @@
+/*
+ * mqueue.h: Implementation of MultiQueues, which are concurrent, _relaxed_
+ *           priority queues meant to be shared by several threads, e.g. as the
+ *           work queue of a thread pool.
+ *
+ *           D'après [1], a MultiQueue is an array of sequential priority queues
+ *           (binary heaps here), each protected by its own lock. Insertions go
+ *           to a queue picked at random. Extractions peek at the minima of two
+ *           queues picked at random, and pop the smaller one. Thus, threads
+ *           rarely contend for the same lock, at the expense of extracting
+ *           elements that are only _close_ to the minimum: the rank error is
+ *           O(n) in expectation, where n is the number of queues.
+ *
+ *           The trade-off between ordering and scalability is set by the
+ *           number of queues: a single queue yields a strict (yet serialized)
+ *           priority queue, whereas a small multiple of the number of threads
+ *           (2 to 4) is where MultiQueues scale best.
+ *
+ * Summary of operations for MultiQueues:
+ *
+ *  - make_mqueue()             Allocs. a MultiQueue.
+ *  - mqueue_insert()           Inserts an element into a random queue.
+ *  - mqueue_try_extract_min()  Extracts the smaller min. of two random queues.
+ *  - mqueue_destroy()          Deallocs. the MultiQueue.
+ *
+ * [1] "MultiQueues: Simpler, Faster, and Better Relaxed Concurrent Priority
+ *     Queues", by H. Rihani, P. Sanders and R. Dementiev.
+ */
+
+#ifndef MQUEUE_H_
+#define MQUEUE_H_
+
+#include <limits.h>             // For ULONG_MAX.
+#include <stdlib.h>             // For malloc().
+
+/* Key cached as the minimum of an empty queue, so that it's picked last. It's
+ * a valid key all the same: emptiness is told by the size of the queue. */
+#define MQUEUE_EMPTY ULONG_MAX
+
+/* Padding so that queues don't share cache lines. */
+#define MQUEUE_CACHE_LINE 64
+
+struct mqueue_elem {
+	unsigned long key;
+	void          *value;
+};
+
+/* A sequential binary min-heap, along with its lock and copies of its minimal
+ * key and size, which are read without taking the lock. */
+struct mqueue_heap {
+	struct mqueue_elem *elems;
+	int                n;
+	int                sz;
+
+	unsigned long      top;
+	int                size;
+	char               lock;
+} __attribute__ ((aligned (MQUEUE_CACHE_LINE)));
+
+struct mqueue {
+	struct mqueue_heap *heaps;
+	int                n;
+};
+
+/* --- API --- */
+
+struct mqueue *make_mqueue(int);
+
+void mqueue_insert(struct mqueue *, unsigned long, void *);
+
+int mqueue_try_extract_min(struct mqueue *, unsigned long *, void **);
+
+void mqueue_destroy(struct mqueue *);
+
+#endif // MQUEUE_H_
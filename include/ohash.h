@@ -0,0 +1,98 @@
+/*
+ * ohash.h: Implementation of ordered hash tables, which index the same set of
+ *          entries both by hash and in a red-black tree (see rbtree.h). Point
+ *          lookups take O(1) expected time through the hash chains, while the
+ *          tree gives ordered iteration and range scans, from any key on.
+ *
+ *          Both indexes are kept within a single node, embedded in the entries
+ *          of clients (as with list_head in list.h), so there's no allocation
+ *          besides the entry itself. Keys are compared by a single function,
+ *          whose sign orders the tree and whose zero ends chain walks. Nodes
+ *          keep the hash of their key, so chains are only compared against on
+ *          a full hash match, and growing the table (which is done whenever it
+ *          holds more entries than buckets) calls no hash function.
+ *
+ * Summary of operations for ordered hash tables:
+ *
+ *  - make_ohash()              Allocs. a table.
+ *  - ohash_insert()            Inserts an entry, in both indexes.
+ *  - ohash_search()            Looks for the entry with a key, by hash.
+ *  - ohash_lower_bound()       Gets the first entry whose key is not less.
+ *  - ohash_first()             Gets the entry with the smallest key.
+ *  - ohash_last()              Gets the entry with the largest key.
+ *  - ohash_next()              Gets the entry following a given one.
+ *  - ohash_prev()              Gets the entry preceding a given one.
+ *  - ohash_delete()            Removes an entry, from both indexes.
+ *  - ohash_destroy()           Deallocs. the table (but not the entries.)
+ *  - ohash_stats_dump()        Prints/returns the counters, see stats.h.
+ */
+
+#ifndef OHASH_H_
+#define OHASH_H_
+
+#include "hash.h"               // For hash_fn and the built-in functions.
+#include "rbtree.h"             // For the ordered index.
+#include "stats.h"              // For instrumentation counters.
+
+/* For comparing keys, with the same convention as strcmp(). */
+typedef int (*ohash_cmp)(const void *, const void *);
+
+/* Probes count the entries compared against while searching, i.e. those with
+ * the same full hash. */
+struct ohash_stats {
+	unsigned long inserts;
+	unsigned long deletes;
+	unsigned long searches;
+	unsigned long misses;
+	unsigned long probes;
+	unsigned long resizes;
+};
+
+/* The tree node holds the key as its value. */
+struct ohash_node {
+	struct rbtree_node tree;
+	struct ohash_node  *next;   // In the bucket.
+	unsigned int       hash;
+};
+
+struct ohash {
+	struct ohash_node  **table;
+	unsigned int       mask;    // The table has a power of 2 buckets.
+
+	struct rbtree      *tree;   // Also holds the number of entries.
+
+	hash_fn            fn;
+	ohash_cmp          cmp;
+
+	struct ohash_stats stats;
+};
+
+/* Gets the entry a node is embedded in. */
+#define ohash_entry(ptr, type, member)                                          \
+	container_of(ptr, type, member)
+
+/* --- API --- */
+
+struct ohash *make_ohash(int, hash_fn, ohash_cmp);
+
+void ohash_insert(struct ohash *, struct ohash_node *, const void *);
+
+struct ohash_node *ohash_search(struct ohash *, const void *);
+
+struct ohash_node *ohash_lower_bound(struct ohash *, const void *);
+
+struct ohash_node *ohash_first(struct ohash *);
+
+struct ohash_node *ohash_last(struct ohash *);
+
+struct ohash_node *ohash_next(struct ohash *, struct ohash_node *);
+
+struct ohash_node *ohash_prev(struct ohash *, struct ohash_node *);
+
+void ohash_delete(struct ohash *, struct ohash_node *);
+
+void ohash_destroy(struct ohash *);
+
+struct ohash_stats ohash_stats_dump(struct ohash *, FILE *);
+
+#endif // OHASH_H_
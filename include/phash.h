@@ -0,0 +1,126 @@
+/*
+ * phash.h: Implementation of frozen hash tables, which are read-only copies
+ *          of hash tables (see hash.h) built around a _minimal perfect hash
+ *          function_: one that maps the n keys in the table to the positions
+ *          0..n - 1 without any collisions. A lookup thus takes a single probe
+ *          and a single comparison, with no chains to walk.
+ *
+ *          D'après PTHash [1], keys are first spread over about n / 5 small
+ *          buckets by their hash (skewed, so that 60% of the keys go to 30% of
+ *          the buckets.) Buckets are then placed largest first: for each one, a
+ *          _pilot_ is searched for, such that hashing each key in the bucket
+ *          together with the pilot yields positions that are all still free.
+ *          Pilots are the only thing stored for the function itself (2 bytes
+ *          per bucket, i.e. less than half a byte per key.)
+ *
+ *          Positions range over slightly more than n slots (which keeps pilot
+ *          searches short); the few keys placed past n are remapped to the
+ *          holes left below n, which makes the function minimal.
+ *
+ *          Entries are copied, by a client-supplied _pack_ function, into
+ *          records laid out one after the other (and found by their offsets,
+ *          unless they're all the same size.) Everything (header, pilots,
+ *          remapped positions, record offsets and records) lives in a single
+ *          contiguous array, with no pointers in it: an image (see image.h),
+ *          which can be saved to a file and loaded back in constant time. The
+ *          original hash table (and its entries) can be freed once frozen.
+ *
+ *          The positions are derived from a 64-bit hash of each key (e.g. by
+ *          way of hash_string() from hashfn.h), so keys must have distinct
+ *          hashes. Freezing fails otherwise, as it does for duplicate keys.
+ *
+ * Summary of operations for frozen hash tables:
+ *
+ *  - hash_freeze()             Builds a frozen copy of a hash table.
+ *  - phash_search()            Looks for the record of a key.
+ *  - phash_size()              Gets the size of the contiguous array, in bytes.
+ *  - phash_save()              Writes the frozen table to a file.
+ *  - phash_load()              Maps a frozen table in from a file.
+ *  - phash_destroy()           Deallocs. (or unmaps) the frozen table.
+ *
+ * [1] "PTHash: Revisiting FCH Minimal Perfect Hashing", by G. E. Pibiri and R.
+ *     Trani.
+ */
+
+#ifndef PHASH_H_
+#define PHASH_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+#include "hash.h"               // For struct hash_table.
+#include "image.h"              // For struct image_hdr.
+
+/* Avg. number of keys per bucket. Higher means smaller, but slower to build. */
+#define PHASH_LAMBDA 5
+
+/* Positions range over n * 100 / PHASH_ALPHA slots. */
+#define PHASH_ALPHA  98
+
+/* Of images. The version is bumped whenever the layout changes. */
+#define PHASH_MAGIC   0x48534850u // "PHSH"
+#define PHASH_VERSION 1
+
+/* For getting the key of an entry of the hash table. */
+typedef const void *(*phash_key)(struct list_head *);
+
+/* For hashing a key to 64 bits. */
+typedef uint64_t (*phash_fn)(const void *);
+
+/* For copying an entry into its record. Should return the size of the record,
+ * and only write it if the buffer is not NULL. */
+typedef size_t (*phash_pack)(struct list_head *, void *);
+
+/* For comparing a record with a key. Same semantics as hash_cmp. */
+typedef int (*phash_cmp)(const void *, const void *);
+
+/* Header of the contiguous array. Sections are given as byte offsets from the
+ * start of the header. */
+struct phash_hdr {
+	struct image_hdr img;       // Holds the size of the whole array.
+	uint64_t seed;
+
+	uint32_t n;                 // Keys.
+	uint32_t m;                 // Slots, i.e. range of the positions.
+	uint32_t nbuckets;
+	uint32_t ndense;            // Buckets taking the bulk of the keys.
+
+	uint32_t pilots;            // nbuckets uint16_t's.
+	uint32_t remap;             // m - n uint32_t's.
+	uint32_t offs;              // n uint32_t's, offsets of the records...
+	uint32_t recs;              // ...which start here.
+
+	uint32_t stride;            // If all records are this long, no offsets.
+	uint32_t unused;
+};
+
+struct phash {
+	struct phash_hdr *hdr;
+
+	const uint16_t   *pilots;
+	const uint32_t   *remap;
+	const uint32_t   *offs;
+	const char       *recs;
+
+	phash_fn         fn;
+	phash_cmp        cmp;
+
+	int              mapped;    // Loaded from a file, rather than built.
+};
+
+/* --- API --- */
+
+struct phash *hash_freeze(struct hash_table *, phash_key, phash_fn, phash_pack,
+			  phash_cmp);
+
+const void *phash_search(struct phash *, const void *);
+
+size_t phash_size(struct phash *);
+
+int phash_save(struct phash *, const char *);
+
+struct phash *phash_load(const char *, phash_fn, phash_cmp, int);
+
+void phash_destroy(struct phash *);
+
+#endif // PHASH_H_
@@ -0,0 +1,96 @@
+/*
+ * prbtree.h: Implementation of persistent red-black trees, meant for ordered
+ *            indices that are read far more often than they're written.
+ *
+ *            Writers never modify nodes reachable by readers. Instead, every
+ *            node on the path to the update is copied (_path copying_), the
+ *            copies are rebalanced, and the new root is published at once.
+ *            Readers thus take a _snapshot_ by loading the root, and traverse
+ *            an immutable tree with no locks, nor atomics, on the way. Nodes
+ *            replaced by copies are reclaimed through ebr.h, once no reader
+ *            can still be traversing a snapshot holding them. Writers are
+ *            serialized by a mutex.
+ *
+ *            Rebalancing follows the left-leaning variant of red-black trees
+ *            [1], in which red links lean left. Every op. is then a recursive
+ *            descent that rebuilds the tree on its way up, which is what path
+ *            copying needs; the in-place fixups of rbtree.h walk up through
+ *            parent pointers, which persistent nodes can't have.
+ *
+ * Summary of operations for persistent red-black trees:
+ *
+ *  - make_prbtree()            Allocs. a tree.
+ *  - prbtree_snapshot()        Takes a snapshot of the tree for reading.
+ *  - prbtree_release()         Releases a snapshot.
+ *  - prbtree_snapshot_search() Looks for a value in a snapshot.
+ *  - prbtree_snapshot_walk()   Traverses a snapshot in order.
+ *  - prbtree_search()          Looks for a value in the latest version.
+ *  - prbtree_insert()          Publishes a version with a value inserted.
+ *  - prbtree_delete()          Publishes a version with a value deleted.
+ *  - prbtree_destroy()         Deallocs. the tree and all its nodes.
+ *
+ * [1] "Left-leaning Red-Black Trees", by R. Sedgewick.
+ */
+
+#ifndef PRBTREE_H_
+#define PRBTREE_H_
+
+#include <pthread.h>            // For pthread_mutex_t.
+#include <stdlib.h>             // For malloc().
+
+#include "rbtree.h"             // For color_t and rbtree_cmp.
+
+typedef void (*prbtree_visit)(void *);
+
+/* Nodes are immutable once published. The version tells whether a node was
+ * created by the write in progress, in which case it can be modified in place
+ * rather than copied. */
+struct prbtree_node {
+	struct prbtree_node *left;
+	struct prbtree_node *right;
+
+	/* Holds the "value" of the node. */
+	void                *value;
+
+	color_t             color;
+	unsigned long       version;
+};
+
+/* Nodes replaced by the write in progress are kept in _garbage_ until the new
+ * root is published, and only then retired. */
+struct prbtree {
+	struct prbtree_node *root;
+
+	rbtree_cmp          cmp;
+	int                 n;
+
+	pthread_mutex_t     lock;
+	unsigned long       version;
+
+	struct prbtree_node **garbage;
+	int                 ngarbage;
+	int                 szgarbage;
+};
+
+/* --- API --- */
+
+struct prbtree *make_prbtree(rbtree_cmp);
+
+const struct prbtree_node *prbtree_snapshot(struct prbtree *);
+
+void prbtree_release(void);
+
+void *prbtree_snapshot_search(struct prbtree *, const struct prbtree_node *,
+			      const void *);
+
+void prbtree_snapshot_walk(const struct prbtree_node *, prbtree_visit);
+
+void *prbtree_search(struct prbtree *, const void *);
+
+int prbtree_insert(struct prbtree *, void *);
+
+void *prbtree_delete(struct prbtree *, const void *);
+
+void prbtree_destroy(struct prbtree *);
+
+#endif // PRBTREE_H_
@@ -0,0 +1,86 @@
+/*
+ * radixheap.h: Implementation of radix heaps, which are monotone priority
+ *              queues for integer keys. _Monotone_ means that keys extracted
+ *              from the heap never decrease over time, as is the case for
+ *              Dijkstra's algorithm with non-negative weights, or for event
+ *              queues ordered by timestamp.
+ *
+ *              D'après [1], nodes are kept in buckets according to the most
+ *              significant bit in which their key differs from the last key
+ *              extracted. Bucket 0 holds nodes whose key equals it; bucket i
+ *              holds those differing first in bit i - 1. Only when bucket 0
+ *              runs empty is the first non-empty bucket redistributed around
+ *              its minimal key, and since nodes only ever move to lower
+ *              buckets, each one is moved at most once per bit of its key.
+ *
+ *              Keys are compared as plain integers, so unlike fibheap.h, no
+ *              comparison function is involved.
+ *
+ * Summary of operations for radix heaps:
+ *
+ *  - make_radixheap()          Allocs. a heap.
+ *  - make_radixheap_node()     Allocs. a heap node.
+ *  - radixheap_is_empty()      Asserts if the heap is empty.
+ *  - radixheap_insert()        Inserts a node into the bucket of its key.
+ *  - radixheap_minimum()       Peeks at the top of the heap.
+ *  - radixheap_extract_min()   Detaches the min. node.
+ *  - radixheap_decrease()      Moves a node to the bucket of its new key.
+ *  - radixheap_delete()        Detaches a node.
+ *
+ * [1] "Faster algorithms for the shortest path problem", by R. K. Ahuja, K.
+ *     Mehlhorn, J. B. Orlin and R. E. Tarjan.
+ */
+
+#ifndef RADIXHEAP_H_
+#define RADIXHEAP_H_
+
+#include <stdint.h>             // For uint64_t.
+#include <stdlib.h>             // For malloc().
+
+#include "list.h"               // For linked list struct. and ops.
+
+/* Keys are unsigned integers of up to 64 bits; 32-bit keys simply never set
+ * the upper buckets. */
+typedef uint64_t radixheap_key;
+
+/* One bucket per bit of the key, plus one for keys equal to the last one. */
+#define RADIXHEAP_BUCKETS (sizeof(radixheap_key) * 8 + 1)
+
+struct radixheap {
+	struct list_head bucket[RADIXHEAP_BUCKETS];
+
+	radixheap_key    last;  // Last key extracted; no key can be smaller.
+	int              n;
+};
+
+/* Nodes are linked into their bucket, and remember which one that is. */
+struct radixheap_node {
+	struct list_head list;
+
+	radixheap_key    key;
+	int              bucket;
+
+	/* Holds the "value" of the node. */
+	void             *value;
+};
+
+/* --- API --- */
+
+struct radixheap *make_radixheap(void);
+
+struct radixheap_node *make_radixheap_node(radixheap_key, void *);
+
+int radixheap_is_empty(struct radixheap *);
+
+void radixheap_insert(struct radixheap *, struct radixheap_node *);
+
+struct radixheap_node *radixheap_minimum(struct radixheap *);
+
+struct radixheap_node *radixheap_extract_min(struct radixheap *);
+
+void radixheap_decrease(struct radixheap *, struct radixheap_node *,
+			radixheap_key);
+
+void radixheap_delete(struct radixheap *, struct radixheap_node *);
+
+#endif // RADIXHEAP_H_
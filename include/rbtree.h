@@ -7,6 +7,11 @@
  *           See [1] for further details on Red-Black trees and their
  *           operations.
  *
+ *           A filter (see filter.h) can be attached to a tree, along with a
+ *           function hashing values, so that searches for values that aren't
+ *           in the tree mostly return NIL without walking down from the root.
+ *           Should the filter fill up, it's detached.
+ *
  * Summary of operations for red-black trees:
  *
  *  - make_rbtree()             Allocs. a tree.
@@ -22,6 +27,8 @@
  *  - rbtree_insert()           Inserts a node, then rebalances the tree.
  *  - rbtree_delete()           Deletes a node, then rebalances the tree.
  *  - rbtree_destroy()          Deallocs. the tree and all its nodes.
+ *  - rbtree_attach_filter()    Attaches a filter to an empty tree.
+ *  - rbtree_stats_dump()       Prints/returns the counters, see stats.h.
  *
  * [1] "Introduction to Algorithms", 3rd ed, ch. 13: Red-Black Trees, by CLRS.
  */
@@ -31,6 +38,9 @@
 
 #include <stdlib.h>             // For malloc().
 
+#include "filter.h"             // For struct filter.
+#include "stats.h"              // For instrumentation counters.
+
 struct rbtree_node;
 
 /* Node colors can be either red or black. */
@@ -43,14 +53,33 @@ typedef int (*rbtree_cmp)(const void *, const void *);
 
 typedef void (*rbtree_visit)(struct rbtree_node *);
 
+/* Fixups count the iterations of the rebalancing loops, i.e. how far up the
+ * tree a violation of the red-black properties got pushed. Filtered searches
+ * are the misses answered by the filter alone. */
+struct rbtree_stats {
+	unsigned long inserts;
+	unsigned long deletes;
+	unsigned long searches;
+	unsigned long comparisons;
+	unsigned long rotations;
+	unsigned long insert_fixups;
+	unsigned long delete_fixups;
+	unsigned long filtered;
+};
+
 /* Simply consists of a pointer to the root node and the number of nodes in the
  * tree. Also, NIL is contained within the tree. */
 struct rbtree {
-	struct rbtree_node *root;
-	struct rbtree_node *nil;
+	struct rbtree_node  *root;
+	struct rbtree_node  *nil;
 
-	rbtree_cmp         cmp;
-	int                n;
+	rbtree_cmp          cmp;
+	int                 n;
+
+	struct filter       *filter;    // NULL unless attached.
+	filter_hash         hash;
+
+	struct rbtree_stats stats;
 };
 
 /* As with regular binary trees, nodes point up to their parent and down to
@@ -95,4 +124,8 @@ void rbtree_delete(struct rbtree *, struct rbtree_node *);
 
 void rbtree_destroy(struct rbtree *);
 
+void rbtree_attach_filter(struct rbtree *, struct filter *, filter_hash);
+
+struct rbtree_stats rbtree_stats_dump(struct rbtree *, FILE *);
+
 #endif // RBTREE_H_
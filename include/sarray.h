@@ -0,0 +1,126 @@
+/*
+ * sarray.h: Implementation of suffix arrays, which index a fixed text for any
+ *           number of substring queries. The suffixes of the text are sorted,
+ *           so that those starting with a pattern sit next to each other, and
+ *           are found by binary search in O(m log n) time, rather than by going
+ *           over the whole text as string matchers do (see strmatch.h.)
+ *
+ *           The array is built in linear time by induced sorting (SA-IS) [1]:
+ *           suffixes are classified as S or L depending on how they compare to
+ *           the next one, the leftmost S-suffixes (LMS) of each run are sorted
+ *           by recursing on a text of about half the size, and the order of
+ *           all the others is induced from theirs in two passes.
+ *
+ *           Two more sections can be built along with the array:
+ *
+ *            - The LCP array, holding the length of the longest common prefix
+ *              of each suffix and the one before it in the array, built in
+ *              linear time by way of the permuted LCP (the _Phi_ algorithm)
+ *              [2]. It tells, for one, what the longest repeated substring is.
+ *            - An FM-index [3], which counts the occurrences of a pattern in
+ *              O(m) time by backward search over the Burrows-Wheeler transform
+ *              of the text. Occurrences of each byte are counted every so many
+ *              rows; lookups scan from the nearest count on.
+ *
+ *           Everything lives in a single contiguous array, along with a copy of
+ *           the text, i.e. an image (see image.h), which can be saved to a file
+ *           and loaded back in constant time. Texts are up to 2 GB long.
+ *
+ * Summary of operations for suffix arrays:
+ *
+ *  - make_sarray()             Builds the suffix array of a text.
+ *  - sarray_search()           Counts (and ranks) the occurrences of a pattern.
+ *  - sarray_pos()              Gets the offset of the suffix of some rank.
+ *  - sarray_lcp()              Gets the LCP of the suffix of some rank.
+ *  - sarray_longest_repeat()   Finds the longest repeated substring.
+ *  - sarray_size()             Gets the size of the contiguous array, in bytes.
+ *  - sarray_save()             Writes the suffix array to a file.
+ *  - sarray_load()             Maps a suffix array in from a file.
+ *  - sarray_destroy()          Deallocs. (or unmaps) the suffix array.
+ *
+ * [1] "Two Efficient Algorithms for Linear Time Suffix Array Construction", by
+ *     G. Nong, S. Zhang and W. H. Chan.
+ * [2] "Permuted Longest-Common-Prefix Array", by J. Kärkkäinen, G. Manzini and
+ *     S. J. Puglisi.
+ * [3] "Opportunistic Data Structures with Applications", by P. Ferragina and
+ *     G. Manzini.
+ */
+
+#ifndef SARRAY_H_
+#define SARRAY_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+#include "image.h"              // For struct image_hdr.
+
+/* Of images. The version is bumped whenever the layout changes. */
+#define SARRAY_MAGIC   0x52524153u // "SARR"
+#define SARRAY_VERSION 1
+
+/* Sections built besides the suffix array. */
+#define SARRAY_LCP     1
+#define SARRAY_FM      2
+
+/* Longest text that can be indexed. */
+#define SARRAY_MAX_LEN ((size_t) INT32_MAX - 1)
+
+/* Header of the contiguous array. Sections are given as byte offsets from the
+ * start of the header, zero for those that weren't built. */
+struct sarray_hdr {
+	struct image_hdr img;       // Holds the size of the whole array.
+
+	uint64_t n;                 // Length of the text.
+	uint64_t flags;
+	uint64_t text;
+	uint64_t sa;                // n + 1 uint32_t's, the first being n.
+	uint64_t lcp;               // n uint32_t's.
+	uint64_t fm;                // A struct sarray_fm.
+};
+
+/* Rows of the Burrows-Wheeler matrix are the suffixes in order, the empty one
+ * first. Counts only cover the bytes that occur in the text, in columns. */
+struct sarray_fm {
+	uint64_t c[257];            // Rows starting with a lesser byte.
+	uint16_t col[256];          // Column of each byte, or 0xffff.
+	uint64_t sigma;             // Bytes occurring.
+	uint64_t primary;           // Row of the whole text, which has no byte.
+	uint64_t occ;               // Counts of every column before each block.
+	uint64_t bwt;               // The byte before each row, n + 1 of them.
+};
+
+struct sarray {
+	struct sarray_hdr      *hdr;
+
+	const unsigned char    *text;
+	const uint32_t         *sa;    // The n non-empty suffixes.
+	const uint32_t         *lcp;   // NULL unless built.
+
+	const struct sarray_fm *fm;    // NULL unless built.
+	const uint32_t         *occ;
+	const unsigned char    *bwt;
+
+	int                    mapped; // Loaded from a file, rather than built.
+};
+
+/* --- API --- */
+
+struct sarray *make_sarray(const void *, size_t, int);
+
+size_t sarray_search(struct sarray *, const void *, size_t, size_t *);
+
+size_t sarray_pos(struct sarray *, size_t);
+
+size_t sarray_lcp(struct sarray *, size_t);
+
+size_t sarray_longest_repeat(struct sarray *, size_t *);
+
+size_t sarray_size(struct sarray *);
+
+int sarray_save(struct sarray *, const char *);
+
+struct sarray *sarray_load(const char *, int);
+
+void sarray_destroy(struct sarray *);
+
+#endif // SARRAY_H_
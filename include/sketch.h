@@ -0,0 +1,118 @@
+/*
+ * sketch.h: Implementation of streaming sketches, which summarize unbounded
+ *           streams of items in a fixed amount of memory, at the cost of some
+ *           (bounded) error in the counts they give.
+ *
+ *           Space-Saving [1] keeps the heavy hitters of a stream, i.e. its top
+ *           k items, in k counters. An item already counted has its counter
+ *           bumped; any other takes over the smallest counter, inheriting its
+ *           count (which becomes the error of the new item.) Counters of equal
+ *           count are kept in buckets, in a list sorted by count (the paper's
+ *           _Stream-Summary_), so that bumping a counter and finding the
+ *           smallest one take constant time. Counters are found by item
+ *           through a small index.
+ *           Given a stream of N items, every item occurring more than N / k
+ *           times is guaranteed to be counted, and each count overestimates
+ *           the true one by at most its error, itself at most N / k.
+ *
+ *           The count-min sketch [2] estimates how often any item occurred, in
+ *           depth rows of width counters. Each item bumps one counter per row,
+ *           and the smallest of its counters is the estimate (since other
+ *           items only ever add to them.) With width = e / epsilon and depth =
+ *           ln(1 / delta), estimates overshoot by more than epsilon * N with a
+ *           probability of at most delta; they never undershoot. Counters are
+ *           only raised as far as needed (a _conservative update_), which
+ *           keeps errors well below the bound in practice.
+ *
+ * Summary of operations for Space-Saving summaries:
+ *
+ *  - make_topk()               Allocs. a summary with k counters.
+ *  - topk_add()                Counts an item.
+ *  - topk_list()               Gets the counted items, most frequent first.
+ *  - topk_destroy()            Deallocs. the summary.
+ *
+ * Summary of operations for count-min sketches:
+ *
+ *  - make_cms()                Allocs. a sketch for given error bounds.
+ *  - cms_add()                 Counts an item, returning its new estimate.
+ *  - cms_estimate()            Gets the estimated count of an item.
+ *  - cms_destroy()             Deallocs. the sketch.
+ *
+ * [1] "Efficient Computation of Frequent and Top-k Elements in Data Streams",
+ *     by A. Metwally, D. Agrawal and A. El Abbadi.
+ * [2] "An Improved Data Stream Summary: The Count-Min Sketch and its
+ *     Applications", by G. Cormode and S. Muthukrishnan.
+ */
+
+#ifndef SKETCH_H_
+#define SKETCH_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+/* Items are copied into their counters, so that the stream may be discarded
+ * as it goes. The true count of the item is between count - error and
+ * count. */
+struct topk_counter {
+	uint64_t count;
+	uint64_t error;
+	uint64_t hash;
+
+	char     *key;
+	size_t   len;
+	size_t   cap;               // Of key, which is reused by later items.
+
+	int      bucket;
+	int      prev, next;        // In the bucket.
+};
+
+/* Counters holding the same count. */
+struct topk_bucket {
+	uint64_t count;
+	int      first;             // Counter.
+	int      prev, next;        // Neighbours by count, or the free list.
+};
+
+struct topk {
+	struct topk_counter *counters;
+	struct topk_bucket  *buckets;
+	int                 min;    // Bucket with the smallest count.
+	int                 free;   // Bucket list.
+	int                 n;      // Counters in use.
+	int                 k;
+
+	int                 *index; // Counter + 1 by hash, zero if empty.
+	size_t              mask;   // The index has a power of 2 slots.
+
+	uint64_t            total;  // Items counted.
+};
+
+/* Items are given to sketches as 64-bit hashes, e.g. by way of hash_bytes()
+ * from hashfn.h. */
+struct cms {
+	uint32_t *counters;         // depth rows of width counters.
+	uint32_t width;             // A power of 2.
+	uint32_t depth;
+
+	uint64_t total;
+};
+
+/* --- API --- */
+
+struct topk *make_topk(int);
+
+void topk_add(struct topk *, const void *, size_t);
+
+int topk_list(struct topk *, struct topk_counter *);
+
+void topk_destroy(struct topk *);
+
+struct cms *make_cms(double, double);
+
+uint32_t cms_add(struct cms *, uint64_t, uint32_t);
+
+uint32_t cms_estimate(struct cms *, uint64_t);
+
+void cms_destroy(struct cms *);
+
+#endif // SKETCH_H_
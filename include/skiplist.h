@@ -0,0 +1,87 @@
+/*
+ * skiplist.h: Implementation of lock-free skip lists, which are ordered sets
+ *             that can be shared by several threads without locking.
+ *
+ *             A skip list is a hierarchy of sorted linked lists: every node is
+ *             in the bottom list, and each list above holds (about) half the
+ *             nodes of the one below it, picked at random. Searches start at
+ *             the top list, dropping one level whenever the next node would
+ *             overshoot, and thus take logarithmic time in expectation.
+ *
+ *             D'après [1], nodes are deleted by first _marking_ their next
+ *             pointers (from the top level down), using their lowest bit; the
+ *             node is logically deleted once its bottom pointer is marked.
+ *             Marked nodes are then unlinked by any thread that comes across
+ *             them while searching. Unlike rotations in red-black trees, every
+ *             update is a single compare-and-swap on one pointer.
+ *
+ *             Unlinked nodes are reclaimed through ebr.h, so that threads
+ *             still traversing them never touch freed memory.
+ *
+ * Summary of operations for skip lists:
+ *
+ *  - make_skiplist()           Allocs. a skip list.
+ *  - skiplist_search()         Looks for a value equal to a specific one.
+ *  - skiplist_minimum()        Gets the minimal value.
+ *  - skiplist_insert()         Inserts a value, unless an equal one is in.
+ *  - skiplist_delete()         Deletes the value equal to a specific one.
+ *  - skiplist_range()          Visits, in order, the values within a range.
+ *  - skiplist_destroy()        Deallocs. the list and all its nodes.
+ *
+ * [1] "The Art of Multiprocessor Programming", ch. 14: Skiplists and Balanced
+ *     Search, by M. Herlihy and N. Shavit.
+ */
+
+#ifndef SKIPLIST_H_
+#define SKIPLIST_H_
+
+#include <stdint.h>             // For uintptr_t.
+#include <stdlib.h>             // For malloc().
+
+/* Enough levels for about 2^24 values to be searched in logarithmic time. */
+#define SKIPLIST_MAX_LEVEL 24
+
+/* For comparing any two values. Clients have to define this. Same semantics as
+ * rbtree_cmp. */
+typedef int (*skiplist_cmp)(const void *, const void *);
+
+/* Visits a value within a range. Should return non-zero to stop the scan. */
+typedef int (*skiplist_visit)(void *, void *);
+
+/* Next pointers are stored as integers, as their lowest bit is used as the
+ * mark. The node itself is freed once both the thread that inserted it and the
+ * one that deleted it are done with it (see _refs_.) */
+struct skiplist_node {
+	void      *value;
+	int       level;
+	int       refs;
+
+	uintptr_t next[];
+};
+
+/* The head is a sentinel node spanning all levels. The tail is NULL, which is
+ * greater than every value. */
+struct skiplist {
+	struct skiplist_node *head;
+
+	skiplist_cmp         cmp;
+};
+
+/* --- API --- */
+
+struct skiplist *make_skiplist(skiplist_cmp);
+
+void *skiplist_search(struct skiplist *, const void *);
+
+void *skiplist_minimum(struct skiplist *);
+
+int skiplist_insert(struct skiplist *, void *);
+
+void *skiplist_delete(struct skiplist *, const void *);
+
+void skiplist_range(struct skiplist *, const void *, const void *,
+		    skiplist_visit, void *);
+
+void skiplist_destroy(struct skiplist *);
+
+#endif // SKIPLIST_H_
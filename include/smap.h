@@ -0,0 +1,91 @@
+/*
+ * smap.h: Implementation of sorted maps, which are read-only, flattened copies
+ *         of red-black trees (see rbtree.h): records are laid out in key order
+ *         one after the other, and looked up by binary search. As with frozen
+ *         hash tables (see phash.h), everything lives in a single contiguous
+ *         array with no pointers in it, i.e. an image (see image.h), which can
+ *         be saved to a file and loaded back in constant time.
+ *
+ *         Nodes are copied into records by a client-supplied _pack_ function.
+ *         Records are found by their offsets, unless they're all the same
+ *         size, in which case the i-th one is simply i times that size in.
+ *         Either way, they're visited in order by their rank, from 0 to n - 1,
+ *         which is also how range queries are answered: smap_lower_bound()
+ *         gives the rank of the first record not less than a key.
+ *
+ * Summary of operations for sorted maps:
+ *
+ *  - rbtree_freeze()           Builds a sorted map from a red-black tree.
+ *  - smap_search()             Looks for the record of a key.
+ *  - smap_lower_bound()        Gets the rank of the first record >= a key.
+ *  - smap_at()                 Gets the record of a given rank.
+ *  - smap_count()              Gets the number of records.
+ *  - smap_size()               Gets the size of the contiguous array, in bytes.
+ *  - smap_save()               Writes the sorted map to a file.
+ *  - smap_load()               Maps a sorted map in from a file.
+ *  - smap_destroy()            Deallocs. (or unmaps) the sorted map.
+ */
+
+#ifndef SMAP_H_
+#define SMAP_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+#include "image.h"              // For struct image_hdr.
+#include "rbtree.h"             // For struct rbtree.
+
+/* Of images. The version is bumped whenever the layout changes. */
+#define SMAP_MAGIC   0x50414d53u // "SMAP"
+#define SMAP_VERSION 1
+
+/* For copying the value of a node into its record. Should return the size of
+ * the record, and only write it if the buffer is not NULL. */
+typedef size_t (*smap_pack)(void *, void *);
+
+/* For comparing a record with a key. Same semantics as rbtree_cmp. */
+typedef int (*smap_cmp)(const void *, const void *);
+
+/* Header of the contiguous array. Sections are given as byte offsets from the
+ * start of the header. */
+struct smap_hdr {
+	struct image_hdr img;       // Holds the size of the whole array.
+
+	uint64_t n;                 // Records.
+	uint64_t offs;              // n uint64_t's, offsets of the records...
+	uint64_t recs;              // ...which start here.
+	uint64_t stride;            // If all records are this long, no offsets.
+};
+
+struct smap {
+	struct smap_hdr *hdr;
+
+	const uint64_t  *offs;
+	const char      *recs;
+
+	smap_cmp        cmp;
+
+	int             mapped;     // Loaded from a file, rather than built.
+};
+
+/* --- API --- */
+
+struct smap *rbtree_freeze(struct rbtree *, smap_pack, smap_cmp);
+
+const void *smap_search(struct smap *, const void *);
+
+size_t smap_lower_bound(struct smap *, const void *);
+
+const void *smap_at(struct smap *, size_t);
+
+size_t smap_count(struct smap *);
+
+size_t smap_size(struct smap *);
+
+int smap_save(struct smap *, const char *);
+
+struct smap *smap_load(const char *, smap_cmp, int);
+
+void smap_destroy(struct smap *);
+
+#endif // SMAP_H_
@@ -0,0 +1,86 @@
+/*
+ * sort.h: Implementation of sorting algorithms, for arrays of elements of any
+ *         size, as taken by qsort():
+ *
+ *          - Pattern-defeating quicksort (pdqsort) [1], the default for
+ *            sorting with a comparison function. It's introsort, picking the
+ *            pivot as the median of 3 (or of 3 medians of 3, for long runs),
+ *            along with a few tweaks that make it run in linear time on
+ *            common patterns: runs equal to the pivot of the enclosing
+ *            partition are put aside in a single pass, partitions that needed
+ *            no swaps are finished by insertion sort (bailing out if that
+ *            gets costly), and elements are shuffled around whenever a
+ *            partition comes out too unbalanced. It falls back to heapsort
+ *            when that keeps happening, which bounds it to O(n log n).
+ *          - LSD radix sort, for elements with an unsigned integer key, such
+ *            as struct word's. Keys are taken a byte at a time, from the
+ *            least significant up, each pass distributing the elements into
+ *            256 buckets, which takes O(n) time and as much extra memory as
+ *            the array. The counts of all passes are taken at once, before
+ *            any of them, and passes in which every key has the same byte
+ *            are skipped, so short keys in wide integers are cheap. The sort
+ *            is stable, unless that memory can't be had, in which case it
+ *            falls back to pdqsort.
+ *          - Parallel merge sort, splitting the array into a chunk per
+ *            thread, sorted by pdqsort, then merging pairs of sorted runs
+ *            until there's one left. Each merge is split in turn into as many
+ *            pieces as there are threads for it, at the points where the
+ *            output does (found by binary search, see [2]), so that all the
+ *            threads are busy up to the last merge. Chunks are sorted where
+ *            they are; merges stream through the array and a buffer of the
+ *            same size, in turns.
+ *
+ *         None of them takes more than O(log n) stack space.
+ *
+ * Summary of sorting algorithms:
+ *
+ *  - sort_pdq()                Pattern-defeating quicksort.
+ *  - sort_radix()              LSD radix sort, on integer keys.
+ *  - sort_parallel()           Merge sort over a number of threads.
+ *  - sort_stats_dump()         Prints/returns the counters, see stats.h.
+ *
+ * [1] "Pattern-defeating Quicksort", by O. R. L. Peters.
+ * [2] "Merge Path - Parallel Merging Made Simple", by S. Odeh, O. Green, Z.
+ *     Mwassi, O. Shmueli and Y. Birk.
+ */
+
+#ifndef SORT_H_
+#define SORT_H_
+
+#include <stddef.h>             // For size_t.
+#include <stdint.h>             // For uint64_t.
+
+#include "stats.h"              // For instrumentation counters.
+
+/* Min. number of elements in the chunk of each thread of sort_parallel(). Each
+ * chunk costs a thread, plus its share of the merges that follow; chunks of
+ * fewer elements than this (about a millisecond of sorting) don't pay off. */
+#define SORT_MIN_CHUNK (1 << 14)
+
+/* Counters shared by all sorts (and threads.) Fallbacks are partitions sorted
+ * by heapsort, and shortcuts those finished by insertion sort. */
+struct sort_stats {
+	unsigned long pdq_fallbacks;
+	unsigned long pdq_shortcuts;
+	unsigned long radix_passes;
+	unsigned long radix_skipped;
+};
+
+/* As taken by qsort(). */
+typedef int (*sort_cmp)(const void *, const void *);
+
+/* Gets the key of an element. Signed keys should have their sign bit flipped,
+ * so that negative ones come first. */
+typedef uint64_t (*sort_key)(const void *);
+
+/* --- API --- */
+
+void sort_pdq(void *, size_t, size_t, sort_cmp);
+
+void sort_radix(void *, size_t, size_t, sort_key);
+
+void sort_parallel(void *, size_t, size_t, sort_cmp, int);
+
+struct sort_stats sort_stats_dump(FILE *);
+
+#endif // SORT_H_
@@ -0,0 +1,62 @@
+/*
+ * stats.h: Instrumentation counters for the hot paths of the data structures,
+ *          meant for finding out how they behave on real workloads: how long
+ *          hash chains get, how many rotations red-black trees go through,
+ *          and so on.
+ *
+ *          Counters are only updated when ALGS_STATS is defined (e.g. by
+ *          building with `make STATS=Y`). Otherwise, the macros below expand to
+ *          nothing, so there's no cost but the room the counters take. The
+ *          stats members are kept in the structs. either way, so that objects
+ *          (and libalgs.so) built with and without ALGS_STATS agree on their
+ *          layout.
+ *
+ *          Each module exposes its counters through a *_stats_dump() function,
+ *          which prints them to a stream (if not NULL) and returns a copy of
+ *          them, for exporting elsewhere. With ALGS_STATS undefined, it returns
+ *          all zeros.
+ *
+ * Summary of macros:
+ *
+ *  - STATS_INC()               Increments a counter.
+ *  - STATS_ADD()               Adds to a counter.
+ *  - STATS_MAX()               Raises a counter to a value, if greater.
+ *  - STATS_ATOMIC_INC()        Increments a counter shared between threads.
+ *  - STATS_PRINT()             Prints a counter as a "name value" line.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>              // For fprintf().
+
+#ifdef ALGS_STATS
+
+#define STATS_INC(_stats, _field)                                               \
+	((_stats)._field++)
+
+#define STATS_ADD(_stats, _field, _n)                                           \
+	((_stats)._field += (_n))
+
+#define STATS_MAX(_stats, _field, _n)                                           \
+	do {                                                                    \
+		if ((unsigned long) (_n) > (_stats)._field)                     \
+			(_stats)._field = (_n);                                 \
+	} while (0)
+
+#define STATS_ATOMIC_INC(_stats, _field)                                        \
+	__atomic_add_fetch(&(_stats)._field, 1, __ATOMIC_RELAXED)
+
+#else
+
+#define STATS_INC(_stats, _field)        ((void) 0)
+#define STATS_ADD(_stats, _field, _n)    ((void) 0)
+#define STATS_MAX(_stats, _field, _n)    ((void) 0)
+#define STATS_ATOMIC_INC(_stats, _field) ((void) 0)
+
+#endif // ALGS_STATS
+
+#define STATS_PRINT(_out, _prefix, _stats, _field)                              \
+	fprintf((_out), "%s.%s %lu\n", (_prefix), #_field, (_stats)._field)
+
+#endif // STATS_H_
@@ -4,6 +4,39 @@
  * Summary of string-matching algorithms:
  *
  *  - strmatch_rk()             Algorithm due to Rabin and Karp, see [1].
+ *  - strmatch_simd()           First/last char. filter using SIMD, see [4].
+ *
+ * Summary of length-aware operations:
+ *
+ *  - strmatch_rk_buf()         Rabin-Karp over a (ptr, len) buffer.
+ *  - strmatch_simd_buf()       SIMD filter over a (ptr, len) buffer.
+ *  - strmatch_kmp_buf()        Algorithm due to Knuth, Morris and Pratt, see
+ *                              [1].
+ *  - strmatch_bmh_buf()        Horspool's variant of Boyer-Moore, see [5].
+ *  - strmatch_tw_buf()         Two-Way algorithm due to Crochemore and Perrin,
+ *                              see [6].
+ *  - strmatch()                Picks one of the above, then runs it.
+ *  - strmatch_select()         Picks one of the above.
+ *  - strmatch_parallel()       Runs strmatch() on chunks of text in parallel.
+ *  - strmatch_stats_dump()     Prints/returns the counters, see stats.h.
+ *  - strmatch_offsets()        Collects match offsets in an array.
+ *
+ * Summary of streaming operations:
+ *
+ *  - strmatch_stream_init()    Allocs. a matcher for text fed in chunks.
+ *  - strmatch_stream_feed()    Matches the next chunk of text.
+ *  - strmatch_stream_finish()  Deallocs. the matcher, returns the match count.
+ *
+ * The length-aware matchers take explicit buffer lengths, so neither the text
+ * nor the pattern have to be NUL-terminated (e.g. mmapped files or binary
+ * data). Every match is reported to a visitor along with its offset; returning
+ * non-zero from the visitor stops the search. They all return the number of
+ * matches reported, and the visitor may be NULL for merely counting them.
+ *
+ * The streaming matcher carries the last m - 1 chars. of the text fed so far
+ * over to the next call to feed(), so that matches straddling a chunk boundary
+ * are not lost. Offsets reported to the visitor are relative to the beginning
+ * of the stream, and memory usage doesn't depend on the length of the text.
  *
  * Modular exponentiation is performed by means of an efficient method that runs
  * in the number of bits of the exponent (O(log exp)), which is useful when
@@ -15,18 +48,119 @@
  * providing support for non-ASCII character strings lookup. For a more
  * comprehensive description of the utf-8 encoding see [3].
  *
+ * The SIMD matcher compares the first and last chars. of the pattern against a
+ * whole block of text positions at once, and only verifies those positions
+ * where both of them match. The widest variant supported by the CPU (AVX2, SSE2
+ * or plain scalar code) is picked once, at startup, by means of cpuid.
+ *
+ * Horspool skips up to m chars. at a time, making it sublinear on average for
+ * long patterns, although it is quadratic in the worst case. Two-Way runs in
+ * linear time in the worst case with constant extra space, while KMP needs an
+ * extra array of m size_t's but never backs up the text.
+ *
  * [1] "Introduction to Algorithms", 3rd ed, ch. 32: String Matching, by CLRS.
  * [2] https://en.wikipedia.org/wiki/Modular_exponentiation.
  * [3] https://en.wikipedia.org/wiki/UTF-8.
+ * [4] http://0x80.pl/articles/simd-strfind.html.
+ * [5] "Practical fast searching in strings", by R. N. Horspool.
+ * [6] "Two-way string-matching", by M. Crochemore and D. Perrin.
  */
 
 #ifndef STRMATCH_H_
 #define STRMATCH_H_
 
-#include <string.h>             // For strlen().
+#include <stddef.h>             // For size_t.
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For strlen() and memcmp().
+
+#include "stats.h"              // For instrumentation counters.
+
+/* Thresholds used by strmatch_select() when there's no vector variant of the
+ * SIMD filter to run. */
+#define STRMATCH_LONG_PAT   16  // Patterns at least this long may skip chars.
+#define STRMATCH_SHORT_TXT  256 // Texts shorter than this aren't worth it.
+#define STRMATCH_SMALL_ALPH 8   // Fewer distinct chars. make shifts short.
+
+/* Min. number of text positions matched by each thread of strmatch_parallel(),
+ * below which starting a thread costs more than what it saves. */
+#define STRMATCH_MIN_CHUNK  (1 << 16)
+
+/* Counters shared by all matchers (and threads.) Hits are positions where the
+ * Rabin-Karp hashes are equal, or where the SIMD filter lets a position
+ * through; false positives are hits that turn out not to be matches. */
+struct strmatch_stats {
+	unsigned long rk_hits;
+	unsigned long rk_false_positives;
+	unsigned long simd_hits;
+	unsigned long simd_false_positives;
+};
+
+/* Visits the offset of a match. Should return non-zero to stop the search. */
+typedef int (*strmatch_visit)(size_t, void *);
+
+/* For the length-aware matchers: text, text length, pattern, pattern length,
+ * visitor, and an argument passed along to the visitor. */
+typedef size_t (*strmatch_algo)(const char *, size_t, const char *, size_t,
+				strmatch_visit, void *);
+
+/* State of a matcher fed in chunks. The window holds the last m - 1 chars. fed
+ * so far (the tail), followed by up to m - 1 chars. of the chunk being fed. */
+struct strmatch_stream {
+	char           *pat;
+	size_t         m;
+
+	char           *win;
+	size_t         tail;    // Number of chars. in the tail.
+
+	size_t         base;    // Stream offset of the text being matched.
+	size_t         matches;
+	int            stopped; // Set once the visitor asks to stop.
+
+	strmatch_visit visit;
+	void           *arg;
+};
 
 /* --- API --- */
 
 int strmatch_rk(char *, const char *);
 
+int strmatch_simd(const char *, const char *, int *, int);
+
+const char *strmatch_simd_isa(void);
+
+size_t strmatch_rk_buf(const char *, size_t, const char *, size_t,
+		       strmatch_visit, void *);
+
+size_t strmatch_simd_buf(const char *, size_t, const char *, size_t,
+			 strmatch_visit, void *);
+
+size_t strmatch_offsets(strmatch_algo, const char *, size_t, const char *,
+			size_t, size_t *, size_t);
+
+size_t strmatch_kmp_buf(const char *, size_t, const char *, size_t,
+			strmatch_visit, void *);
+
+size_t strmatch_bmh_buf(const char *, size_t, const char *, size_t,
+			strmatch_visit, void *);
+
+size_t strmatch_tw_buf(const char *, size_t, const char *, size_t,
+		       strmatch_visit, void *);
+
+strmatch_algo strmatch_select(size_t, const char *, size_t);
+
+size_t strmatch(const char *, size_t, const char *, size_t, strmatch_visit,
+		void *);
+
+size_t strmatch_parallel(const char *, size_t, const char *, size_t, int,
+			 strmatch_visit, void *);
+
+struct strmatch_stats strmatch_stats_dump(FILE *);
+
+struct strmatch_stream *strmatch_stream_init(const char *, size_t,
+					     strmatch_visit, void *);
+
+size_t strmatch_stream_feed(struct strmatch_stream *, const char *, size_t);
+
+size_t strmatch_stream_finish(struct strmatch_stream *);
+
 #endif // STRMATCH_H_
@@ -0,0 +1,94 @@
+/*
+ * ulist.h: Implementation of unrolled linked lists, in which every node (a
+ *          _chunk_) holds a small array of elements, rather than a single one.
+ *
+ *          Iterating over the intrusive lists of list.h takes a dependent load
+ *          per element, each one likely missing the cache. Unrolled lists take
+ *          one per chunk instead, and elements within a chunk are contiguous,
+ *          so they are prefetched along with it. As a result, iteration runs
+ *          at close to the speed of an array, while insertions at either end
+ *          and splicing remain constant time.
+ *
+ *          Chunks are themselves linked by means of list.h, and are filled
+ *          from the middle out: elements live at elems[start..end), so that
+ *          both ends of the list have room to grow without moving elements.
+ *          Unlike list.h, elements are pointers to client data, rather than
+ *          nodes embedded in it.
+ *
+ * Summary of operations for unrolled lists:
+ *
+ *  - make_ulist()              Allocs. a list.
+ *  - ulist_add()               Inserts an element at the head.
+ *  - ulist_add_tail()          Inserts an element at the tail.
+ *  - ulist_del()               Removes an element, given its chunk and index.
+ *  - ulist_empty()             Asserts if the list is empty.
+ *  - ulist_splice()            Attaches one list to another at the head.
+ *  - ulist_splice_tail()       Attaches one list to another at the tail.
+ *  - ulist_destroy()           Deallocs. the list and all its chunks.
+ */
+
+#ifndef ULIST_H_
+#define ULIST_H_
+
+#include <stdlib.h>             // For malloc().
+
+#include "list.h"               // For linked list struct. and ops.
+
+/* Chunks take up four 64-byte cache lines. */
+#define ULIST_CHUNK_BYTES 256
+
+#define ULIST_CHUNK_SZ                                                          \
+	((ULIST_CHUNK_BYTES - sizeof(struct list_head) - 2 * sizeof(int)) /     \
+	 sizeof(void *))
+
+struct ulist_chunk {
+	struct list_head list;
+
+	int              start;
+	int              end;
+
+	void             *elems[ULIST_CHUNK_SZ];
+};
+
+struct ulist {
+	struct list_head chunks;
+	int              n;
+};
+
+/* Iterates over the elements of the list, with _c_ and _i_ holding the chunk
+ * and index of each. Since two loops are involved, break only leaves the inner
+ * one; use goto for leaving both. */
+#define ulist_for_each(pos, c, i, l)                                            \
+	list_for_each_entry(c, &(l)->chunks, list)                              \
+		for ((i) = (c)->start;                                          \
+		     (i) < (c)->end && (((pos) = (c)->elems[(i)]), 1);          \
+		     (i)++)
+
+/* Same as above, in reverse order. */
+#define ulist_for_each_reverse(pos, c, i, l)                                    \
+	for (c = list_entry((l)->chunks.prev, typeof(*c), list);                \
+	     &c->list != &(l)->chunks;                                          \
+	     c = list_entry(c->list.prev, typeof(*c), list))                    \
+		for ((i) = (c)->end - 1;                                        \
+		     (i) >= (c)->start && (((pos) = (c)->elems[(i)]), 1);       \
+		     (i)--)
+
+/* --- API --- */
+
+struct ulist *make_ulist(void);
+
+void ulist_add(void *, struct ulist *);
+
+void ulist_add_tail(void *, struct ulist *);
+
+void ulist_del(struct ulist *, struct ulist_chunk *, int);
+
+int ulist_empty(struct ulist *);
+
+void ulist_splice(struct ulist *, struct ulist *);
+
+void ulist_splice_tail(struct ulist *, struct ulist *);
+
+void ulist_destroy(struct ulist *);
+
+#endif // ULIST_H_
@@ -0,0 +1,909 @@
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For memcmp() and memcpy().
+
+#include "art.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>          // For the SSE2 intrinsics.
+#endif
+
+#define IS_LEAF(x) ((uintptr_t) (x) & 1)
+#define LEAF(x)    ((struct art_leaf *) ((uintptr_t) (x) & ~(uintptr_t) 1))
+#define TAG(l)     ((void *) ((uintptr_t) (l) | 1))
+
+#define MIN(a, b)  ((a) < (b) ? (a) : (b))
+
+/* Node48 shrinks to Node16 and Node256 to Node48 a few children below where
+ * they'd have grown, so that a key going back and forth doesn't make the node
+ * change layout every time. */
+#define NODE48_MIN  12
+#define NODE256_MIN 37
+
+struct node4 {
+	struct art_node n;
+	unsigned char   keys[4];
+	void            *children[4];
+};
+
+struct node16 {
+	struct art_node n;
+	unsigned char   keys[16];
+	void            *children[16];
+};
+
+/* Slots hold the child index + 1, or zero. */
+struct node48 {
+	struct art_node n;
+	unsigned char   slots[256];
+	void            *children[48];
+};
+
+struct node256 {
+	struct art_node n;
+	void            *children[256];
+};
+
+static struct art_leaf *make_leaf(const void *key, size_t len, void *value)
+{
+	struct art_leaf *l = malloc(sizeof(struct art_leaf) + len);
+
+	l->value = value;
+	l->len   = len;
+	memcpy(l->key, key, len);
+
+	return l;
+}
+
+static inline int leaf_matches(const struct art_leaf *l, const void *key,
+			       size_t len)
+{
+	return l->len == len && !memcmp(l->key, key, len);
+}
+
+static struct art_node *make_node(art_node_t type)
+{
+	static const size_t sizes[] = {
+		sizeof(struct node4), sizeof(struct node16),
+		sizeof(struct node48), sizeof(struct node256)
+	};
+	struct art_node *n = calloc(1, sizes[type]);
+
+	n->type = type;
+
+	return n;
+}
+
+/* Copies everything but the children. */
+static void copy_header(struct art_node *dst, const struct art_node *src)
+{
+	dst->n          = src->n;
+	dst->prefix_len = src->prefix_len;
+	dst->end        = src->end;
+	memcpy(dst->prefix, src->prefix, MIN(src->prefix_len, ART_MAX_PREFIX));
+}
+
+/* Returns the slot of the child for byte c, or NULL if there's none. */
+static void **find_child(struct art_node *n, unsigned char c)
+{
+	struct node4 *n4;
+	struct node16 *n16;
+	struct node48 *n48;
+	struct node256 *n256;
+	int i;
+#ifdef __SSE2__
+	__m128i cmp;
+	unsigned int mask;
+#endif
+
+	switch (n->type) {
+	case ART_NODE4:
+		n4 = (struct node4 *) n;
+
+		for (i = 0; i < n->n; i++)
+			if (n4->keys[i] == c)
+				return &n4->children[i];
+
+		return NULL;
+
+	case ART_NODE16:
+		n16 = (struct node16 *) n;
+
+#ifdef __SSE2__
+		cmp  = _mm_cmpeq_epi8(_mm_set1_epi8((char) c),
+				      _mm_loadu_si128((__m128i *) n16->keys));
+		mask = _mm_movemask_epi8(cmp) & ((1u << n->n) - 1);
+
+		return mask ? &n16->children[__builtin_ctz(mask)] : NULL;
+#else
+		for (i = 0; i < n->n; i++)
+			if (n16->keys[i] == c)
+				return &n16->children[i];
+
+		return NULL;
+#endif
+
+	case ART_NODE48:
+		n48 = (struct node48 *) n;
+		i   = n48->slots[c];
+
+		return i ? &n48->children[i - 1] : NULL;
+
+	default:
+		n256 = (struct node256 *) n;
+
+		return n256->children[c] ? &n256->children[c] : NULL;
+	}
+}
+
+/* Smallest and largest leaves below x. The key ending at a node comes before
+ * those of its children. */
+static struct art_leaf *minimum(void *x)
+{
+	struct art_node *n;
+	struct node48 *n48;
+	int i;
+
+	while (!IS_LEAF(x)) {
+		n = x;
+
+		if (n->end)
+			return n->end;
+
+		switch (n->type) {
+		case ART_NODE4:
+			x = ((struct node4 *) n)->children[0];
+			break;
+		case ART_NODE16:
+			x = ((struct node16 *) n)->children[0];
+			break;
+		case ART_NODE48:
+			n48 = (struct node48 *) n;
+
+			for (i = 0; !n48->slots[i]; i++)
+				;
+
+			x = n48->children[n48->slots[i] - 1];
+			break;
+		default:
+			for (i = 0; !((struct node256 *) n)->children[i]; i++)
+				;
+
+			x = ((struct node256 *) n)->children[i];
+		}
+	}
+
+	return LEAF(x);
+}
+
+static struct art_leaf *maximum(void *x)
+{
+	struct art_node *n;
+	struct node48 *n48;
+	int i;
+
+	while (!IS_LEAF(x)) {
+		n = x;
+
+		if (!n->n)
+			return n->end;
+
+		switch (n->type) {
+		case ART_NODE4:
+			x = ((struct node4 *) n)->children[n->n - 1];
+			break;
+		case ART_NODE16:
+			x = ((struct node16 *) n)->children[n->n - 1];
+			break;
+		case ART_NODE48:
+			n48 = (struct node48 *) n;
+
+			for (i = 255; !n48->slots[i]; i--)
+				;
+
+			x = n48->children[n48->slots[i] - 1];
+			break;
+		default:
+			for (i = 255; !((struct node256 *) n)->children[i]; i--)
+				;
+
+			x = ((struct node256 *) n)->children[i];
+		}
+	}
+
+	return LEAF(x);
+}
+
+/* Counts the stored prefix bytes of n matching the key from depth on. */
+static size_t check_prefix(const struct art_node *n, const unsigned char *key,
+			   size_t len, size_t depth)
+{
+	size_t i, max = MIN(MIN(n->prefix_len, ART_MAX_PREFIX), len - depth);
+
+	for (i = 0; i < max && n->prefix[i] == key[depth + i]; i++)
+		;
+
+	return i;
+}
+
+/* Same as above, but over the whole prefix, going to a leaf for the bytes that
+ * aren't stored. */
+static size_t prefix_mismatch(const struct art_node *n,
+			      const unsigned char *key, size_t len, size_t depth)
+{
+	size_t i = check_prefix(n, key, len, depth), max;
+	struct art_leaf *l;
+
+	if (i < ART_MAX_PREFIX || n->prefix_len <= ART_MAX_PREFIX)
+		return i;
+
+	l   = minimum((void *) n);
+	max = MIN(n->prefix_len, MIN(l->len, len) - depth);
+
+	for (; i < max && l->key[depth + i] == key[depth + i]; i++)
+		;
+
+	return i;
+}
+
+static void add_child(struct art *, void **, struct art_node *, unsigned char,
+		      void *);
+
+/* Puts a leaf in node n at depth, either as a child or as the key ending
+ * there. */
+static void place_leaf(struct art *t, void **ref, struct art_node *n,
+		       struct art_leaf *l, size_t depth)
+{
+	if (l->len == depth)
+		n->end = l;
+	else
+		add_child(t, ref, n, l->key[depth], TAG(l));
+}
+
+/* Inserts in a sorted array of keys (and children), at the position of c. */
+static void add_sorted(unsigned char *keys, void **children, int n,
+		       unsigned char c, void *child)
+{
+	int i;
+
+	for (i = 0; i < n && keys[i] < c; i++)
+		;
+
+	memmove(keys + i + 1, keys + i, n - i);
+	memmove(children + i + 1, children + i, (n - i) * sizeof(void *));
+
+	keys[i]     = c;
+	children[i] = child;
+}
+
+/* Replaces the node at *ref with a copy of the next layout. The tree is only
+ * needed for the counters. */
+static struct art_node *grow(struct art *t __attribute__ ((unused)),
+			     void **ref, struct art_node *n)
+{
+	struct art_node *m = make_node(n->type + 1);
+	struct node4 *n4 = (struct node4 *) n;
+	struct node16 *n16 = (struct node16 *) n;
+	struct node48 *n48 = (struct node48 *) n;
+	int i;
+
+	copy_header(m, n);
+
+	switch (n->type) {
+	case ART_NODE4:
+		memcpy(((struct node16 *) m)->keys, n4->keys, 4);
+		memcpy(((struct node16 *) m)->children, n4->children,
+		       4 * sizeof(void *));
+		break;
+	case ART_NODE16:
+		for (i = 0; i < 16; i++) {
+			((struct node48 *) m)->slots[n16->keys[i]] = i + 1;
+			((struct node48 *) m)->children[i] = n16->children[i];
+		}
+		break;
+	default:
+		for (i = 0; i < 256; i++)
+			if (n48->slots[i])
+				((struct node256 *) m)->children[i] =
+					n48->children[n48->slots[i] - 1];
+	}
+
+	STATS_INC(t->stats, grows);
+
+	*ref = m;
+	free(n);
+
+	return m;
+}
+
+static void add_child(struct art *t, void **ref, struct art_node *n,
+		      unsigned char c, void *child)
+{
+	struct node48 *n48;
+	int i;
+
+	switch (n->type) {
+	case ART_NODE4:
+		if (n->n == 4)
+			break;
+
+		add_sorted(((struct node4 *) n)->keys,
+			   ((struct node4 *) n)->children, n->n++, c, child);
+		return;
+
+	case ART_NODE16:
+		if (n->n == 16)
+			break;
+
+		add_sorted(((struct node16 *) n)->keys,
+			   ((struct node16 *) n)->children, n->n++, c, child);
+		return;
+
+	case ART_NODE48:
+		if (n->n == 48)
+			break;
+
+		n48 = (struct node48 *) n;
+
+		for (i = 0; n48->children[i]; i++)
+			;
+
+		n48->children[i] = child;
+		n48->slots[c]    = i + 1;
+		n->n++;
+		return;
+
+	default:
+		((struct node256 *) n)->children[c] = child;
+		n->n++;
+		return;
+	}
+
+	add_child(t, ref, grow(t, ref, n), c, child);
+}
+
+/* Splits the prefix of n where it stops matching the key (at diff bytes), with
+ * a Node4 holding both n and a new leaf. */
+static void split_prefix(struct art *t, void **ref, struct art_node *n,
+			 size_t depth, size_t diff, struct art_leaf *l)
+{
+	struct art_node *m = make_node(ART_NODE4);
+	struct art_leaf *min;
+
+	m->prefix_len = diff;
+	memcpy(m->prefix, n->prefix, MIN(diff, ART_MAX_PREFIX));
+	*ref = m;
+
+	if (n->prefix_len <= ART_MAX_PREFIX) {
+		add_child(t, ref, m, n->prefix[diff], n);
+		n->prefix_len -= diff + 1;
+		memmove(n->prefix, n->prefix + diff + 1,
+			MIN(n->prefix_len, ART_MAX_PREFIX));
+	} else {
+		/* The bytes past the stored ones are taken from a leaf. */
+		min = minimum(n);
+		add_child(t, ref, m, min->key[depth + diff], n);
+		n->prefix_len -= diff + 1;
+		memcpy(n->prefix, min->key + depth + diff + 1,
+		       MIN(n->prefix_len, ART_MAX_PREFIX));
+	}
+
+	place_leaf(t, ref, m, l, depth + diff);
+}
+
+/* Makes a Node4 holding the leaf already at *ref and a new one, with the
+ * bytes both keys share from depth on as prefix. */
+static void split_leaf(struct art *t, void **ref, struct art_leaf *old,
+		       struct art_leaf *l, size_t depth)
+{
+	struct art_node *m = make_node(ART_NODE4);
+	size_t i, max = MIN(old->len, l->len);
+
+	for (i = depth; i < max && old->key[i] == l->key[i]; i++)
+		;
+
+	m->prefix_len = i - depth;
+	memcpy(m->prefix, l->key + depth, MIN(i - depth, ART_MAX_PREFIX));
+	*ref = m;
+
+	place_leaf(t, ref, m, old, i);
+	place_leaf(t, ref, m, l, i);
+}
+
+static void *insert(struct art *t, void **ref, const unsigned char *key,
+		    size_t len, size_t depth, void *value)
+{
+	struct art_leaf *l;
+	struct art_node *n;
+	void **child, *old;
+	size_t diff;
+
+	for (;;) {
+		if (!*ref) {
+			*ref = TAG(make_leaf(key, len, value));
+			break;
+		}
+
+		if (IS_LEAF(*ref)) {
+			l = LEAF(*ref);
+
+			if (leaf_matches(l, key, len)) {
+				old      = l->value;
+				l->value = value;
+				return old;
+			}
+
+			split_leaf(t, ref, l, make_leaf(key, len, value),
+				   depth);
+			break;
+		}
+
+		n = *ref;
+
+		if (n->prefix_len) {
+			diff = prefix_mismatch(n, key, len, depth);
+
+			if (diff < n->prefix_len) {
+				split_prefix(t, ref, n, depth, diff,
+					     make_leaf(key, len, value));
+				break;
+			}
+
+			depth += n->prefix_len;
+		}
+
+		if (depth == len) {
+			if (n->end) {
+				old           = n->end->value;
+				n->end->value = value;
+				return old;
+			}
+
+			n->end = make_leaf(key, len, value);
+			break;
+		}
+
+		if (!(child = find_child(n, key[depth]))) {
+			add_child(t, ref, n, key[depth],
+				  TAG(make_leaf(key, len, value)));
+			break;
+		}
+
+		ref = child;
+		depth++;
+	}
+
+	t->n++;
+
+	return NULL;
+}
+
+/* Replaces the node at *ref with a copy of the previous layout. */
+static void shrink(struct art *t __attribute__ ((unused)), void **ref,
+		   struct art_node *n)
+{
+	struct art_node *m = make_node(n->type - 1);
+	struct node16 *n16 = (struct node16 *) n;
+	struct node48 *n48 = (struct node48 *) n;
+	struct node256 *n256 = (struct node256 *) n;
+	int i, j = 0;
+
+	copy_header(m, n);
+
+	switch (n->type) {
+	case ART_NODE16:
+		memcpy(((struct node4 *) m)->keys, n16->keys, n->n);
+		memcpy(((struct node4 *) m)->children, n16->children,
+		       n->n * sizeof(void *));
+		break;
+	case ART_NODE48:
+		for (i = 0; i < 256; i++) {
+			if (!n48->slots[i])
+				continue;
+
+			((struct node16 *) m)->keys[j]     = i;
+			((struct node16 *) m)->children[j] =
+				n48->children[n48->slots[i] - 1];
+			j++;
+		}
+		break;
+	default:
+		for (i = 0; i < 256; i++) {
+			if (!n256->children[i])
+				continue;
+
+			((struct node48 *) m)->slots[i]    = j + 1;
+			((struct node48 *) m)->children[j] = n256->children[i];
+			j++;
+		}
+	}
+
+	STATS_INC(t->stats, shrinks);
+
+	*ref = m;
+	free(n);
+}
+
+/* A Node4 left with nothing but the key ending at it turns into that key's
+ * leaf, and one left with a single child (and no such key) is merged into the
+ * child, its prefix and key byte going in front of the child's prefix. */
+static void collapse(void **ref, struct node4 *n4)
+{
+	struct art_node *n = &n4->n, *c;
+	size_t len;
+
+	if (!n->n && n->end) {
+		*ref = TAG(n->end);
+		free(n);
+		return;
+	}
+
+	if (n->n != 1 || n->end)
+		return;
+
+	if (!IS_LEAF(n4->children[0])) {
+		c   = n4->children[0];
+		len = n->prefix_len;
+
+		if (len < ART_MAX_PREFIX)
+			n->prefix[len++] = n4->keys[0];
+
+		if (len < ART_MAX_PREFIX) {
+			memcpy(n->prefix + len, c->prefix,
+			       MIN(c->prefix_len, ART_MAX_PREFIX - len));
+			len += MIN(c->prefix_len, ART_MAX_PREFIX - len);
+		}
+
+		memcpy(c->prefix, n->prefix, MIN(len, ART_MAX_PREFIX));
+		c->prefix_len += n->prefix_len + 1;
+	}
+
+	*ref = n4->children[0];
+	free(n);
+}
+
+/* Removes the child at slot, a pointer into the children of n. */
+static void remove_child(struct art *t, void **ref, struct art_node *n,
+			 unsigned char c, void **slot)
+{
+	struct node4 *n4 = (struct node4 *) n;
+	struct node16 *n16 = (struct node16 *) n;
+	int i;
+
+	switch (n->type) {
+	case ART_NODE4:
+		i = slot - n4->children;
+		memmove(n4->keys + i, n4->keys + i + 1, n->n - i - 1);
+		memmove(slot, slot + 1, (n->n - i - 1) * sizeof(void *));
+		n->n--;
+		collapse(ref, n4);
+		break;
+
+	case ART_NODE16:
+		i = slot - n16->children;
+		memmove(n16->keys + i, n16->keys + i + 1, n->n - i - 1);
+		memmove(slot, slot + 1, (n->n - i - 1) * sizeof(void *));
+
+		if (--n->n == 3)
+			shrink(t, ref, n);
+		break;
+
+	case ART_NODE48:
+		((struct node48 *) n)->slots[c] = 0;
+		*slot = NULL;
+
+		if (--n->n == NODE48_MIN)
+			shrink(t, ref, n);
+		break;
+
+	default:
+		*slot = NULL;
+
+		if (--n->n == NODE256_MIN)
+			shrink(t, ref, n);
+	}
+}
+
+static struct art_leaf *delete(struct art *t, void **ref,
+			       const unsigned char *key, size_t len)
+{
+	struct art_leaf *l;
+	struct art_node *n;
+	size_t depth = 0;
+	void **child;
+
+	if (!*ref)
+		return NULL;
+
+	if (IS_LEAF(*ref)) {
+		l = LEAF(*ref);
+
+		if (!leaf_matches(l, key, len))
+			return NULL;
+
+		*ref = NULL;
+		return l;
+	}
+
+	for (;;) {
+		n = *ref;
+
+		if (n->prefix_len) {
+			if (check_prefix(n, key, len, depth) !=
+			    MIN(n->prefix_len, ART_MAX_PREFIX))
+				return NULL;
+
+			depth += n->prefix_len;
+		}
+
+		if (depth > len)
+			return NULL;
+
+		if (depth == len) {
+			if (!(l = n->end) || !leaf_matches(l, key, len))
+				return NULL;
+
+			n->end = NULL;
+
+			if (n->type == ART_NODE4)
+				collapse(ref, (struct node4 *) n);
+
+			return l;
+		}
+
+		if (!(child = find_child(n, key[depth])))
+			return NULL;
+
+		if (IS_LEAF(*child)) {
+			l = LEAF(*child);
+
+			if (!leaf_matches(l, key, len))
+				return NULL;
+
+			remove_child(t, ref, n, key[depth], child);
+			return l;
+		}
+
+		ref = child;
+		depth++;
+	}
+}
+
+/* Visits the leaves below x in order. */
+static int walk(void *x, art_visit visit, void *arg)
+{
+	struct art_node *n = x;
+	struct node48 *n48;
+	void *c;
+	int i, r;
+
+	if (!x)
+		return 0;
+
+	if (IS_LEAF(x))
+		return visit(LEAF(x), arg);
+
+	if (n->end && (r = visit(n->end, arg)))
+		return r;
+
+	switch (n->type) {
+	case ART_NODE4:
+	case ART_NODE16:
+		for (i = 0; i < n->n; i++) {
+			c = n->type == ART_NODE4 ?
+				((struct node4 *) n)->children[i] :
+				((struct node16 *) n)->children[i];
+
+			if ((r = walk(c, visit, arg)))
+				return r;
+		}
+		break;
+
+	case ART_NODE48:
+		n48 = (struct node48 *) n;
+
+		for (i = 0; i < 256; i++)
+			if (n48->slots[i] &&
+			    (r = walk(n48->children[n48->slots[i] - 1], visit,
+				      arg)))
+				return r;
+		break;
+
+	default:
+		for (i = 0; i < 256; i++)
+			if ((c = ((struct node256 *) n)->children[i]) &&
+			    (r = walk(c, visit, arg)))
+				return r;
+	}
+
+	return 0;
+}
+
+static void destroy(void *x)
+{
+	struct art_node *n = x;
+	struct node48 *n48;
+	int i;
+
+	if (!x)
+		return;
+
+	if (IS_LEAF(x)) {
+		free(LEAF(x));
+		return;
+	}
+
+	free(n->end);
+
+	switch (n->type) {
+	case ART_NODE4:
+		for (i = 0; i < n->n; i++)
+			destroy(((struct node4 *) n)->children[i]);
+		break;
+	case ART_NODE16:
+		for (i = 0; i < n->n; i++)
+			destroy(((struct node16 *) n)->children[i]);
+		break;
+	case ART_NODE48:
+		n48 = (struct node48 *) n;
+
+		for (i = 0; i < 48; i++)
+			destroy(n48->children[i]);
+		break;
+	default:
+		for (i = 0; i < 256; i++)
+			destroy(((struct node256 *) n)->children[i]);
+	}
+
+	free(n);
+}
+
+/* --- API --- */
+
+struct art *make_art(void)
+{
+	struct art *t = malloc(sizeof(struct art));
+
+	t->root = NULL;
+	t->n    = 0;
+
+	t->stats = (struct art_stats) { 0 };
+
+	return t;
+}
+
+/* Returns the value the key had, if it was already in (NULL otherwise.) The
+ * key is copied, but not the value. */
+void *art_insert(struct art *t, const void *key, size_t len, void *value)
+{
+	STATS_INC(t->stats, inserts);
+
+	return insert(t, &t->root, key, len, 0, value);
+}
+
+/* Prefixes are only checked as far as they're stored; the leaf reached is
+ * compared against the whole key anyway. */
+void *art_search(struct art *t, const void *_key, size_t len)
+{
+	const unsigned char *key = _key;
+	struct art_node *n;
+	void *x = t->root, **child;
+	size_t depth = 0;
+
+	STATS_INC(t->stats, searches);
+
+	while (x && !IS_LEAF(x)) {
+		n = x;
+
+		if (n->prefix_len) {
+			if (check_prefix(n, key, len, depth) !=
+			    MIN(n->prefix_len, ART_MAX_PREFIX))
+				return NULL;
+
+			depth += n->prefix_len;
+		}
+
+		if (depth >= len) {
+			x = depth == len && n->end ? TAG(n->end) : NULL;
+			break;
+		}
+
+		child = find_child(n, key[depth++]);
+		x     = child ? *child : NULL;
+	}
+
+	return x && leaf_matches(LEAF(x), key, len) ? LEAF(x)->value : NULL;
+}
+
+/* Returns the value the key had, or NULL if it wasn't in. */
+void *art_delete(struct art *t, const void *key, size_t len)
+{
+	struct art_leaf *l = delete(t, &t->root, key, len);
+	void *value;
+
+	if (!l)
+		return NULL;
+
+	value = l->value;
+	free(l);
+
+	t->n--;
+	STATS_INC(t->stats, deletes);
+
+	return value;
+}
+
+struct art_leaf *art_minimum(struct art *t)
+{
+	return t->root ? minimum(t->root) : NULL;
+}
+
+struct art_leaf *art_maximum(struct art *t)
+{
+	return t->root ? maximum(t->root) : NULL;
+}
+
+/* Returns whatever the visit function returned to stop the traversal, or zero
+ * if it went through. */
+int art_walk(struct art *t, art_visit visit, void *arg)
+{
+	return walk(t->root, visit, arg);
+}
+
+/* Same as above, for the keys starting with a prefix of len bytes. Everything
+ * below the node where the prefix runs out is visited. */
+int art_prefix_walk(struct art *t, const void *_prefix, size_t len,
+		    art_visit visit, void *arg)
+{
+	const unsigned char *prefix = _prefix;
+	struct art_leaf *l;
+	struct art_node *n;
+	void *x = t->root, **child;
+	size_t depth = 0, m;
+
+	while (x) {
+		if (IS_LEAF(x)) {
+			l = LEAF(x);
+
+			if (l->len < len || memcmp(l->key, prefix, len))
+				return 0;
+
+			return visit(l, arg);
+		}
+
+		n = x;
+		m = prefix_mismatch(n, prefix, len, depth);
+
+		if (depth + m == len)
+			return walk(n, visit, arg);
+
+		if (m < n->prefix_len)
+			return 0;
+
+		depth += n->prefix_len;
+		child  = find_child(n, prefix[depth++]);
+		x      = child ? *child : NULL;
+	}
+
+	return 0;
+}
+
+void art_destroy(struct art *t)
+{
+	destroy(t->root);
+	free(t);
+}
+
+struct art_stats art_stats_dump(struct art *t, FILE *out)
+{
+	struct art_stats s = t->stats;
+
+	if (out) {
+		STATS_PRINT(out, "art", s, inserts);
+		STATS_PRINT(out, "art", s, deletes);
+		STATS_PRINT(out, "art", s, searches);
+		STATS_PRINT(out, "art", s, grows);
+		STATS_PRINT(out, "art", s, shrinks);
+	}
+
+	return s;
+}
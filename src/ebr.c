@@ -0,0 +1,154 @@
+#include "ebr.h"
+
+#define ACTIVE 1UL
+
+#define LOAD(_ptr)         __atomic_load_n((_ptr), __ATOMIC_SEQ_CST)
+#define STORE(_ptr, _val)  __atomic_store_n((_ptr), (_val), __ATOMIC_SEQ_CST)
+
+#define CAS(_ptr, _old, _new)                                                   \
+	__atomic_compare_exchange_n((_ptr), (_old), (_new), 0,                  \
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+
+static unsigned long global_epoch = EBR_EPOCHS;
+
+static struct ebr_record *records;
+
+static __thread struct ebr_record *self;
+
+/* Frees all memory in a limbo list. */
+static void limbo_free(struct ebr_limbo *l)
+{
+	struct ebr_retired *r, *next;
+
+	for (r = l->head; r; r = next) {
+		next = r->next;
+		r->fn(r->ptr);
+		free(r);
+	}
+
+	l->head = NULL;
+}
+
+/* Frees the memory retired by the calling thread at least two epochs ago. */
+static void reclaim(struct ebr_record *rec, unsigned long epoch)
+{
+	int i;
+
+	for (i = 0; i < EBR_EPOCHS; i++)
+		if (rec->limbo[i].head && rec->limbo[i].epoch + 2 <= epoch)
+			limbo_free(&rec->limbo[i]);
+}
+
+/* Advances the global epoch, provided every thread within a critical section
+ * has announced the current one. */
+static void try_advance(void)
+{
+	unsigned long epoch = LOAD(&global_epoch), state;
+	struct ebr_record *rec;
+
+	for (rec = LOAD(&records); rec; rec = rec->next) {
+		state = LOAD(&rec->state);
+
+		if ((state & ACTIVE) && (state >> 1) != epoch)
+			return;
+	}
+
+	CAS(&global_epoch, &epoch, epoch + 1);
+}
+
+/* Grabs a record released by some other thread, or else allocs. a new one and
+ * pushes it onto the global list. */
+static struct ebr_record *acquire(void)
+{
+	struct ebr_record *rec;
+	int i, unused;
+
+	for (rec = LOAD(&records); rec; rec = rec->next) {
+		unused = 0;
+
+		if (!LOAD(&rec->in_use) && CAS(&rec->in_use, &unused, 1))
+			return rec;
+	}
+
+	rec = malloc(sizeof(struct ebr_record));
+
+	rec->state   = 0;
+	rec->in_use  = 1;
+	rec->nest    = 0;
+	rec->retired = 0;
+
+	for (i = 0; i < EBR_EPOCHS; i++) {
+		rec->limbo[i].head  = NULL;
+		rec->limbo[i].epoch = 0;
+	}
+
+	rec->next = LOAD(&records);
+
+	while (!CAS(&records, &rec->next, rec))
+		;
+
+	return rec;
+}
+
+/* --- API --- */
+
+/* Critical sections may nest; only the outermost one announces the epoch. */
+void ebr_enter(void)
+{
+	unsigned long epoch;
+
+	if (!self)
+		self = acquire();
+
+	if (self->nest++)
+		return;
+
+	epoch = LOAD(&global_epoch);
+	STORE(&self->state, (epoch << 1) | ACTIVE);
+
+	/* Shared memory must not be read before the epoch is announced. */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	reclaim(self, epoch);
+}
+
+void ebr_exit(void)
+{
+	if (!--self->nest)
+		STORE(&self->state, self->state & ~ACTIVE);
+}
+
+/* Must be called from within a critical section, once _ptr_ can no longer be
+ * reached by threads entering one. */
+void ebr_retire(void *ptr, ebr_free_fn fn)
+{
+	unsigned long epoch = LOAD(&global_epoch);
+	struct ebr_limbo *l = &self->limbo[epoch % EBR_EPOCHS];
+	struct ebr_retired *r = malloc(sizeof(struct ebr_retired));
+
+	/* The bucket may still hold memory from EBR_EPOCHS epochs ago. */
+	if (l->epoch != epoch) {
+		limbo_free(l);
+		l->epoch = epoch;
+	}
+
+	r->ptr  = ptr;
+	r->fn   = fn;
+	r->next = l->head;
+	l->head = r;
+
+	if (++self->retired % EBR_RETIRE_FREQ == 0)
+		try_advance();
+}
+
+/* Releases the record of the calling thread, which must not be within a
+ * critical section. Memory it retired is freed by whichever thread gets the
+ * record next. */
+void ebr_unregister(void)
+{
+	if (!self)
+		return;
+
+	STORE(&self->in_use, 0);
+	self = NULL;
+}
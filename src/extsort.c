@@ -0,0 +1,546 @@
+#define _POSIX_C_SOURCE 200809L // For pthreads, pread() and fileno().
+
+#include <errno.h>              // For errno.
+#include <pthread.h>            // For pthread_create() and co.
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For memcpy().
+#include <unistd.h>             // For pread() and pwrite().
+
+#include "extsort.h"
+
+/* A run being merged: the record at its head, and the buffers it's read
+ * through, the next block being read into one while the other is consumed. */
+struct reader {
+	struct extsort_buf buf[2];
+	int                cur;
+	off_t              next;    // Offset of the next block to read.
+	off_t              end;
+
+	const char         *rec;    // NULL once the run is done with.
+	const char         *lim;
+};
+
+/* Where a merge pass writes its runs out, a block at a time. */
+struct writer {
+	struct extsort_buf buf[2];
+	int                cur;
+	off_t              off;
+};
+
+/* Reads (or writes) queued buffers until told to stop, once the queue's empty.
+ * Only the first error is kept. */
+static void *io_run(void *arg)
+{
+	struct extsort *x = arg;
+	struct extsort_buf *b;
+	size_t done;
+	ssize_t r;
+	int err;
+
+	pthread_mutex_lock(&x->lock);
+
+	for (;;) {
+		while (!x->head && !x->stop)
+			pthread_cond_wait(&x->cond, &x->lock);
+
+		if (!(b = x->head))
+			break;
+
+		if (!(x->head = b->next))
+			x->tail = NULL;
+
+		pthread_mutex_unlock(&x->lock);
+
+		for (done = 0, err = 0; !err && done < b->len; done += r) {
+			r = b->write ?
+			    pwrite(b->fd, b->data + done, b->len - done,
+				   b->off + done) :
+			    pread(b->fd, b->data + done, b->len - done,
+				  b->off + done);
+
+			if (r < 0 && errno == EINTR)
+				r = 0;
+			else if (r <= 0)
+				err = r ? errno : EIO;
+		}
+
+		pthread_mutex_lock(&x->lock);
+
+		if (err && !x->error)
+			x->error = err;
+
+		b->busy = 0;
+		pthread_cond_broadcast(&x->cond);
+	}
+
+	pthread_mutex_unlock(&x->lock);
+
+	return NULL;
+}
+
+static void submit(struct extsort *x, struct extsort_buf *b)
+{
+	if (b->write)
+		STATS_ADD(x->stats, bytes_written, b->len);
+	else
+		STATS_ADD(x->stats, bytes_read, b->len);
+
+	pthread_mutex_lock(&x->lock);
+
+	b->busy = 1;
+	b->next = NULL;
+
+	if (x->tail)
+		x->tail->next = b;
+	else
+		x->head = b;
+
+	x->tail = b;
+
+	pthread_cond_broadcast(&x->cond);
+	pthread_mutex_unlock(&x->lock);
+}
+
+/* Waits for the I/O of a buffer to be done. Returns zero, or -1 with errno set
+ * if the I/O thread ran into an error, this buffer's or any other. */
+static int wait_buf(struct extsort *x, struct extsort_buf *b)
+{
+	int err;
+
+	pthread_mutex_lock(&x->lock);
+
+	if (b->busy)
+		STATS_INC(x->stats, waits);
+
+	while (b->busy)
+		pthread_cond_wait(&x->cond, &x->lock);
+
+	err = x->error;
+
+	pthread_mutex_unlock(&x->lock);
+
+	if (err) {
+		errno = err;
+		return -1;
+	}
+
+	return 0;
+}
+
+static void add_run(struct extsort *x, off_t off, size_t len)
+{
+	if (x->nruns == x->sz) {
+		x->sz   = x->sz ? 2 * x->sz : 16;
+		x->runs = realloc(x->runs, x->sz * sizeof(struct extsort_run));
+	}
+
+	x->runs[x->nruns++] = (struct extsort_run) { off, len };
+}
+
+/* Sorts the current half of the buffer and has it written out as a run, while
+ * records go on to the other half. */
+static int spill(struct extsort *x)
+{
+	struct extsort_buf *b = &x->half[x->cur];
+
+	sort_pdq(b->data, b->len / x->size, x->size, x->cmp);
+	add_run(x, x->end, b->len);
+	STATS_INC(x->stats, runs);
+
+	b->off  = x->end;
+	x->end += b->len;
+	submit(x, b);
+
+	b = &x->half[x->cur ^= 1];
+
+	if (wait_buf(x, b) < 0)
+		return -1;
+
+	b->len = 0;
+
+	return 0;
+}
+
+/* Queues the next block of a run to be read into one of its buffers, leaving
+ * the buffer empty if the run has been read through. */
+static void fill(struct extsort *x, struct reader *r, struct extsort_buf *b)
+{
+	b->len = r->end - r->next < (off_t) x->block ?
+		 (size_t) (r->end - r->next) : x->block;
+
+	if (b->len) {
+		b->off   = r->next;
+		r->next += b->len;
+		submit(x, b);
+	}
+}
+
+/* Moves on to the next record of a run, switching buffers at the end of one,
+ * which is then refilled. */
+static int advance(struct extsort *x, struct reader *r)
+{
+	struct extsort_buf *b;
+
+	if ((r->rec += x->size) < r->lim)
+		return 0;
+
+	fill(x, r, &r->buf[r->cur]);
+	b = &r->buf[r->cur ^= 1];
+
+	if (!b->len) {
+		r->rec = NULL;
+		return 0;
+	}
+
+	if (wait_buf(x, b) < 0)
+		return -1;
+
+	r->rec = b->data;
+	r->lim = b->data + b->len;
+
+	return 0;
+}
+
+static int put(struct extsort *x, struct writer *w, const char *rec)
+{
+	struct extsort_buf *b = &w->buf[w->cur];
+
+	memcpy(b->data + b->len, rec, x->size);
+
+	if ((b->len += x->size) < x->block)
+		return 0;
+
+	b->off  = w->off;
+	w->off += b->len;
+	submit(x, b);
+
+	b = &w->buf[w->cur ^= 1];
+
+	if (wait_buf(x, b) < 0)
+		return -1;
+
+	b->len = 0;
+
+	return 0;
+}
+
+/* Tells whether the head of run a goes before that of run b, runs done with
+ * going last. */
+static int beats(struct extsort *x, struct reader *r, int a, int b)
+{
+	if (!r[b].rec)
+		return 1;
+
+	if (!r[a].rec)
+		return 0;
+
+	return x->cmp(r[a].rec, r[b].rec) <= 0;
+}
+
+/* Merges k runs of a file, either writing them out as a single run, or
+ * visiting the records. The loser tree has the k runs as its leaves, at k to
+ * 2k - 1, and inner nodes from 1 up, tree[0] being the winner. */
+static int merge(struct extsort *x, int fd, struct extsort_run *runs, int k,
+		 struct writer *w, extsort_visit visit, void *arg)
+{
+	struct reader *r = calloc(k, sizeof(struct reader));
+	int *tree = malloc(k * sizeof(int)), *win = malloc(2 * k * sizeof(int));
+	int i, j, n, t, ret = 0;
+
+	for (i = 0; i < k; i++) {
+		r[i].next = runs[i].off;
+		r[i].end  = runs[i].off + runs[i].len;
+
+		for (j = 0; j < 2; j++) {
+			r[i].buf[j].data  = malloc(x->block);
+			r[i].buf[j].fd    = fd;
+			r[i].buf[j].write = 0;
+			fill(x, &r[i], &r[i].buf[j]);
+		}
+	}
+
+	for (i = 0; i < k; i++) {
+		if ((ret = wait_buf(x, &r[i].buf[0])) < 0)
+			goto out;
+
+		r[i].rec = r[i].buf[0].len ? r[i].buf[0].data : NULL;
+		r[i].lim = r[i].buf[0].data + r[i].buf[0].len;
+		win[k + i] = i;
+	}
+
+	for (n = k - 1; n > 0; n--) {
+		i = win[2 * n];
+		j = win[2 * n + 1];
+
+		win[n]  = beats(x, r, i, j) ? i : j;
+		tree[n] = beats(x, r, i, j) ? j : i;
+	}
+
+	tree[0] = k > 1 ? win[1] : 0;
+
+	/* The winner's run moves on, and its next record plays the matches on
+	 * its way up, the loser of each staying there. */
+	while (r[i = tree[0]].rec) {
+		if (w)
+			ret = put(x, w, r[i].rec);
+		else if (visit(r[i].rec, arg))
+			break;
+
+		if (ret < 0 || (ret = advance(x, &r[i])) < 0)
+			goto out;
+
+		for (n = (i + k) / 2; n > 0; n /= 2) {
+			if (beats(x, r, tree[n], i)) {
+				t       = tree[n];
+				tree[n] = i;
+				i       = t;
+			}
+		}
+
+		tree[0] = i;
+	}
+
+out:
+	/* Buffers still queued (when stopping early) are waited for. */
+	for (i = 0; i < k; i++) {
+		for (j = 0; j < 2; j++) {
+			wait_buf(x, &r[i].buf[j]);
+			free(r[i].buf[j].data);
+		}
+	}
+
+	free(win);
+	free(tree);
+	free(r);
+
+	return ret;
+}
+
+/* Merges the runs fan_in at a time into a new file, which takes the place of
+ * the current one. Each merge is flushed, so that its run ends where the next
+ * one starts. */
+static int merge_pass(struct extsort *x)
+{
+	struct extsort_run *runs = x->runs;
+	int i, k, nruns = x->nruns, ret = 0;
+	FILE *file = x->file;
+	struct extsort_buf *b;
+	struct writer w;
+	off_t start;
+
+	if (!(x->file = tmpfile())) {
+		x->file = file;
+		return -1;
+	}
+
+	x->runs  = NULL;
+	x->nruns = x->sz = 0;
+	w.cur    = 0;
+	w.off    = 0;
+
+	for (i = 0; i < 2; i++) {
+		w.buf[i].data  = malloc(x->block);
+		w.buf[i].len   = 0;
+		w.buf[i].fd    = fileno(x->file);
+		w.buf[i].write = 1;
+		w.buf[i].busy  = 0;
+	}
+
+	for (i = 0; !ret && i < nruns; i += k) {
+		k     = nruns - i < x->fan_in ? nruns - i : x->fan_in;
+		start = w.off;
+		ret   = merge(x, fileno(file), runs + i, k, &w, NULL, NULL);
+		b     = &w.buf[w.cur];
+
+		if (!ret && b->len) {
+			b->off  = w.off;
+			w.off  += b->len;
+			submit(x, b);
+
+			ret    = wait_buf(x, b);
+			b->len = 0;
+		}
+
+		add_run(x, start, w.off - start);
+	}
+
+	for (i = 0; i < 2; i++) {
+		wait_buf(x, &w.buf[i]);
+		free(w.buf[i].data);
+	}
+
+	STATS_INC(x->stats, passes);
+
+	fclose(file);
+	free(runs);
+
+	return ret;
+}
+
+/* --- API --- */
+
+/* Makes a sorter of records of some size, taking up to mem bytes for buffers
+ * (and a few more for bookkeeping.) Returns NULL, with errno set, if mem can't
+ * hold 8 records, or the temporary file, the buffers or the I/O thread can't
+ * be made. */
+struct extsort *make_extsort(size_t size, sort_cmp cmp, size_t mem)
+{
+	struct extsort *x;
+	int i, err;
+
+	if (!size || mem / 8 < size) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if (!(x = calloc(1, sizeof(struct extsort))))
+		return NULL;
+
+	if (!(x->file = tmpfile())) {
+		free(x);
+		return NULL;
+	}
+
+	x->size = size;
+	x->cmp  = cmp;
+	x->mem  = mem;
+	x->cap  = mem / 2 / size * size;
+
+	/* Merging takes two blocks per run, plus two for the output. */
+	x->block = EXTSORT_BLOCK / size ? EXTSORT_BLOCK / size * size : size;
+
+	if (mem / (2 * x->block) < 3)
+		x->block = mem / 6 / size * size;
+
+	x->fan_in = mem / (2 * x->block) - 1;
+
+	for (i = 0; i < 2; i++) {
+		x->half[i].data  = malloc(x->cap);
+		x->half[i].fd    = fileno(x->file);
+		x->half[i].write = 1;
+	}
+
+	if (!x->half[0].data || !x->half[1].data) {
+		err = ENOMEM;
+		goto fail;
+	}
+
+	pthread_mutex_init(&x->lock, NULL);
+	pthread_cond_init(&x->cond, NULL);
+
+	/* Without the I/O thread, the first spill would wait forever. */
+	if ((err = pthread_create(&x->thread, NULL, io_run, x))) {
+		pthread_cond_destroy(&x->cond);
+		pthread_mutex_destroy(&x->lock);
+		goto fail;
+	}
+
+	return x;
+
+fail:
+	fclose(x->file);
+	free(x->half[0].data);
+	free(x->half[1].data);
+	free(x);
+	errno = err;
+
+	return NULL;
+}
+
+/* Feeds n records to the sorter. Returns zero, or -1 with errno set if a run
+ * couldn't be written out. */
+int extsort_add(struct extsort *x, const void *recs, size_t n)
+{
+	const char *p = recs;
+	size_t len = n * x->size, k;
+	struct extsort_buf *b;
+
+	while (len) {
+		b = &x->half[x->cur];
+		k = x->cap - b->len < len ? x->cap - b->len : len;
+
+		memcpy(b->data + b->len, p, k);
+		b->len += k;
+		p      += k;
+		len    -= k;
+
+		if (b->len == x->cap && spill(x) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Visits the records fed so far in order, until the visitor returns non-zero.
+ * Records that fit in half the memory are sorted there, with no I/O. Otherwise,
+ * runs are merged in as many passes as needed. Returns zero, or -1 with errno
+ * set on an I/O error. The sorter can't be fed any more records afterwards. */
+int extsort_finish(struct extsort *x, extsort_visit visit, void *arg)
+{
+	struct extsort_buf *b = &x->half[x->cur];
+	char *p;
+	int i;
+
+	if (!x->nruns) {
+		sort_pdq(b->data, b->len / x->size, x->size, x->cmp);
+
+		for (p = b->data; p < b->data + b->len; p += x->size)
+			if (visit(p, arg))
+				break;
+
+		return 0;
+	}
+
+	if ((b->len && spill(x) < 0) || wait_buf(x, &x->half[x->cur ^ 1]))
+		return -1;
+
+	/* Merge buffers take the place of the halves. */
+	for (i = 0; i < 2; i++) {
+		free(x->half[i].data);
+		x->half[i].data = NULL;
+		x->half[i].len  = 0;
+	}
+
+	while (x->nruns > x->fan_in)
+		if (merge_pass(x) < 0)
+			return -1;
+
+	STATS_INC(x->stats, passes);
+
+	return merge(x, fileno(x->file), x->runs, x->nruns, NULL, visit, arg);
+}
+
+/* Stops the I/O thread, once it's done with what's queued, and closes (thus
+ * removes) the temporary file. */
+void extsort_destroy(struct extsort *x)
+{
+	pthread_mutex_lock(&x->lock);
+	x->stop = 1;
+	pthread_cond_broadcast(&x->cond);
+	pthread_mutex_unlock(&x->lock);
+
+	pthread_join(x->thread, NULL);
+	pthread_cond_destroy(&x->cond);
+	pthread_mutex_destroy(&x->lock);
+
+	fclose(x->file);
+	free(x->half[0].data);
+	free(x->half[1].data);
+	free(x->runs);
+	free(x);
+}
+
+struct extsort_stats extsort_stats_dump(struct extsort *x, FILE *out)
+{
+	struct extsort_stats s = x->stats;
+
+	if (out) {
+		STATS_PRINT(out, "extsort", s, runs);
+		STATS_PRINT(out, "extsort", s, passes);
+		STATS_PRINT(out, "extsort", s, bytes_read);
+		STATS_PRINT(out, "extsort", s, bytes_written);
+		STATS_PRINT(out, "extsort", s, waits);
+	}
+
+	return s;
+}
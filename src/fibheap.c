@@ -1,5 +1,9 @@
 #include "fibheap.h"
 
+/* Compares the values of two nodes, counting the comparison. */
+#define CMP(_heap, a, b)                                                        \
+	(STATS_INC((_heap)->stats, comparisons), (_heap)->cmp((a), (b)))
+
 #define REMOVE_FROM_LIST(_node)                                                 \
 	list_del(&(_node)->list)
 
@@ -54,6 +58,9 @@ static inline void consolidate(struct fibheap *h)
 	/* Let A[0..D(H.n)] be a new array. */
 	A = malloc((maxdeg + 1) * sizeof(struct fibheap_node *));
 
+	STATS_INC(h->stats, consolidations);
+	STATS_INC(h->stats, allocations);
+
 	for (i = 0; i <= maxdeg; i++)
 		A[i] = NULL;
 
@@ -63,13 +70,14 @@ static inline void consolidate(struct fibheap *h)
 		while (A[d]) {
 			y = A[d]; // Another node with the same degree as x.
 
-			if (h->cmp(y->value, x->value) < 0) {
+			if (CMP(h, y->value, x->value) < 0) {
 				/* Exchange x with y. */
 				swp = x;
 				x   = y;
 				y   = swp;
 			}
 			link(y, x);
+			STATS_INC(h->stats, links);
 			A[d] = NULL;
 			d++;
 		}
@@ -86,7 +94,7 @@ static inline void consolidate(struct fibheap *h)
 
 				min = GET_MIN_NODE(h);
 
-				if (h->cmp(A[i]->value, min->value) < 0)
+				if (CMP(h, A[i]->value, min->value) < 0)
 					BECOME_MIN_NODE(A[i], h);
 			}
 			A[i]->parent = NULL;
@@ -98,6 +106,8 @@ static inline void consolidate(struct fibheap *h)
 static inline void cut(struct fibheap *h, struct fibheap_node *x,
 		       struct fibheap_node *y)
 {
+	STATS_INC(h->stats, cuts);
+
 	/* Remove x from the child list of y, decrementing y.degree. */
 	REMOVE_FROM_LIST(x);
 	y->degree--;
@@ -115,6 +125,7 @@ static inline void cascading_cut(struct fibheap *h, struct fibheap_node *y)
 
 	if (z) {
 		if (TEST_MARK(y)) {
+			STATS_INC(h->stats, cascading_cuts);
 			cut(h, y, z);
 			cascading_cut(h, z);
 		} else {
@@ -134,6 +145,8 @@ struct fibheap *make_fibheap(fibheap_cmp cmp)
 	heap->cmp = cmp;
 	heap->n   = 0;
 
+	heap->stats = (struct fibheap_stats) { 0 };
+
 	return heap;
 }
 
@@ -168,10 +181,11 @@ void fibheap_insert(struct fibheap *h, struct fibheap_node *x)
 
 		min = GET_MIN_NODE(h);
 
-		if (h->cmp(x->value, min->value) < 0)
+		if (CMP(h, x->value, min->value) < 0)
 			BECOME_MIN_NODE(x, h);
 	}
 	h->n++;
+	STATS_INC(h->stats, inserts);
 }
 
 struct fibheap_node *fibheap_minimum(struct fibheap *h)
@@ -188,6 +202,8 @@ struct fibheap_node *fibheap_extract_min(struct fibheap *h)
 
 	z = GET_MIN_NODE(h);
 
+	STATS_INC(h->stats, extracts);
+
 	if (!list_empty(&z->child)) {
 		list_for_each_entry_safe(x, next, &z->child, list) {
 			/* Add x to the root list of h. */
@@ -221,7 +237,7 @@ struct fibheap *fibheap_union(struct fibheap *heap1, struct fibheap *heap2)
 
 	list_splice_tail(&heap2->root_list, &heap1->root_list);
 
-	if (heap1->cmp(h2->value, h1->value) < 0)
+	if (CMP(heap1, h2->value, h1->value) < 0)
 		BECOME_MIN_NODE(h2, heap1);
 
 	heap1->n += heap2->n;
@@ -237,13 +253,15 @@ void fibheap_decrease(struct fibheap *h, struct fibheap_node *x)
 {
 	struct fibheap_node *y = x->parent, *min;
 
-	if (y && h->cmp(x->value, y->value) < 0) {
+	STATS_INC(h->stats, decreases);
+
+	if (y && CMP(h, x->value, y->value) < 0) {
 		cut(h, x, y);
 		cascading_cut(h, y);
 	}
 	min = GET_MIN_NODE(h);
 
-	if (h->cmp(x->value, min->value) < 0)
+	if (CMP(h, x->value, min->value) < 0)
 		BECOME_MIN_NODE(x, h);
 }
 
@@ -264,3 +282,22 @@ void fibheap_delete(struct fibheap *h, struct fibheap_node *x)
 	/* Finally, the node is extracted from the heap. */
 	fibheap_extract_min(h);
 }
+
+struct fibheap_stats fibheap_stats_dump(struct fibheap *h, FILE *out)
+{
+	struct fibheap_stats s = h->stats;
+
+	if (out) {
+		STATS_PRINT(out, "fibheap", s, inserts);
+		STATS_PRINT(out, "fibheap", s, extracts);
+		STATS_PRINT(out, "fibheap", s, decreases);
+		STATS_PRINT(out, "fibheap", s, comparisons);
+		STATS_PRINT(out, "fibheap", s, consolidations);
+		STATS_PRINT(out, "fibheap", s, links);
+		STATS_PRINT(out, "fibheap", s, cuts);
+		STATS_PRINT(out, "fibheap", s, cascading_cuts);
+		STATS_PRINT(out, "fibheap", s, allocations);
+	}
+
+	return s;
+}
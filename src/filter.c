@@ -0,0 +1,365 @@
+#define _POSIX_C_SOURCE 200809L // For posix_memalign().
+
+#include <math.h>               // For exp(), lgamma() and pow().
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For memset().
+
+#include "filter.h"
+#include "hashfn.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>          // For the AVX2 intrinsics.
+#define FILTER_X86
+#endif
+
+#define BLOCK_WORDS 8
+#define BLOCK_BYTES (BLOCK_WORDS * sizeof(uint32_t))
+
+/* Cuckoo buckets hold 4 16-bit fingerprints, zero meaning an empty slot. */
+#define SLOTS       4
+#define SLOT_BITS   16
+#define SLOT_MASK   0xffffull
+#define ONES        0x0001000100010001ull
+#define HIGHS       0x8000800080008000ull
+#define MAX_LOAD    0.96
+
+/* Odd constants for picking a bit in each word of a block, from Parquet. */
+static const uint32_t salt[BLOCK_WORDS] = {
+	0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+	0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+/* The block is picked by the upper half of the hash, and the bits within it
+ * by the lower half. */
+static inline uint32_t *bloom_block(struct bloom *b, uint64_t h)
+{
+	return b->blocks + hash_range(h >> 32, b->nblocks) * BLOCK_WORDS;
+}
+
+static int block_test_scalar(const uint32_t *block, uint32_t h)
+{
+	int i;
+
+	for (i = 0; i < BLOCK_WORDS; i++)
+		if (!(block[i] & (1u << ((h * salt[i]) >> 27))))
+			return 0;
+
+	return 1;
+}
+
+#ifdef FILTER_X86
+
+/* Same as above, all 8 words at once. */
+__attribute__ ((target ("avx2")))
+static int block_test_avx2(const uint32_t *block, uint32_t h)
+{
+	__m256i s = _mm256_loadu_si256((const __m256i *) salt);
+	__m256i b = _mm256_load_si256((const __m256i *) block);
+	__m256i m;
+
+	s = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(h), s), 27);
+	m = _mm256_sllv_epi32(_mm256_set1_epi32(1), s);
+
+	return _mm256_testc_si256(b, m);  // All bits of m set in b.
+}
+
+#endif // FILTER_X86
+
+/* Picked once, at startup, according to what the CPU supports. */
+static int (*block_test)(const uint32_t *, uint32_t) = block_test_scalar;
+
+__attribute__ ((constructor))
+static void filter_init(void)
+{
+#ifdef FILTER_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		block_test = block_test_avx2;
+#endif
+}
+
+/* Expected false positive rate with lambda keys per block, on average. Block
+ * loads follow a Poisson distribution, and a block holding i keys has each
+ * bit of a word set with probability 1 - (31/32)^i. The sum is taken over the
+ * loads that aren't vanishingly rare. */
+static double bloom_fpr(double lambda)
+{
+	double fpr = 0, spread = 12 * sqrt(lambda) + 32;
+	long i, lo = lambda > spread ? (long) (lambda - spread) : 0;
+
+	for (i = lo; i <= (long) (lambda + spread); i++)
+		fpr += exp(i * log(lambda) - lambda - lgamma(i + 1.0)) *
+		       pow(1 - pow(31.0 / 32, i), BLOCK_WORDS);
+
+	return fpr;
+}
+
+/* Finds the fewest blocks keeping the rate under fpr, by bisection (the rate
+ * only goes down as blocks are added.) */
+static size_t bloom_blocks(size_t n, double fpr)
+{
+	size_t lo = 1, hi = n + 1, mid;
+
+	if (!n || fpr >= 1)
+		return 1;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (bloom_fpr((double) n / mid) <= fpr)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo < UINT32_MAX ? lo : UINT32_MAX;
+}
+
+static inline uint64_t has_zero_slot(uint64_t x)
+{
+	return (x - ONES) & ~x & HIGHS;
+}
+
+static inline uint16_t fingerprint(uint64_t h)
+{
+	uint16_t fp = (uint16_t) (h >> 48);
+
+	return fp ? fp : 1;
+}
+
+/* The other bucket a fingerprint may be in. Going there from either bucket
+ * leads to the other, so entries can be moved around knowing only their
+ * fingerprint. */
+static inline uint64_t alt_bucket(struct cuckoo *c, uint64_t i, uint16_t fp)
+{
+	return (i ^ (fp * 0x5bd1e995ull)) & c->mask;
+}
+
+/* Of the first slot flagged by has_zero_slot(), the only one that's exact. */
+static inline unsigned int slot_shift(uint64_t z)
+{
+	return __builtin_ctzll(z) & ~(SLOT_BITS - 1);
+}
+
+static inline int has_fp(uint64_t bucket, uint16_t fp)
+{
+	return !!has_zero_slot(bucket ^ (fp * ONES));
+}
+
+/* Puts the fingerprint in the first free slot of the bucket, if any. */
+static inline int cuckoo_put(struct cuckoo *c, uint64_t i, uint16_t fp)
+{
+	uint64_t z = has_zero_slot(c->buckets[i]);
+
+	if (!z)
+		return 0;
+
+	c->buckets[i] |= (uint64_t) fp << slot_shift(z);
+
+	return 1;
+}
+
+/* Clears a slot holding the fingerprint, if any. */
+static inline int cuckoo_clear(struct cuckoo *c, uint64_t i, uint16_t fp)
+{
+	uint64_t z = has_zero_slot(c->buckets[i] ^ (fp * ONES));
+
+	if (!z)
+		return 0;
+
+	c->buckets[i] &= ~(SLOT_MASK << slot_shift(z));
+
+	return 1;
+}
+
+static inline uint64_t cuckoo_rand(struct cuckoo *c)
+{
+	c->rand ^= c->rand << 13;
+	c->rand ^= c->rand >> 7;
+	c->rand ^= c->rand << 17;
+
+	return c->rand;
+}
+
+/* Kicks out random entries until one finds room. The one left over when giving
+ * up becomes the victim. */
+static int cuckoo_add(struct cuckoo *c, uint64_t h)
+{
+	uint16_t fp = fingerprint(h), old;
+	uint64_t i = h & c->mask, shift;
+	int kicks;
+
+	if (c->victim)
+		return 0;
+
+	if (cuckoo_put(c, i, fp) || cuckoo_put(c, alt_bucket(c, i, fp), fp))
+		return 1;
+
+	if (cuckoo_rand(c) & 1)
+		i = alt_bucket(c, i, fp);
+
+	for (kicks = 0; kicks < FILTER_MAX_KICKS; kicks++) {
+		shift = (cuckoo_rand(c) % SLOTS) * SLOT_BITS;
+		old   = (uint16_t) (c->buckets[i] >> shift);
+
+		c->buckets[i] &= ~(SLOT_MASK << shift);
+		c->buckets[i] |= (uint64_t) fp << shift;
+
+		fp = old;
+		i  = alt_bucket(c, i, fp);
+
+		if (cuckoo_put(c, i, fp))
+			return 1;
+	}
+
+	c->victim        = fp;
+	c->victim_bucket = i;
+
+	return 1;
+}
+
+static int cuckoo_test(struct cuckoo *c, uint64_t h)
+{
+	uint16_t fp = fingerprint(h);
+	uint64_t i = h & c->mask, j = alt_bucket(c, i, fp);
+
+	if (has_fp(c->buckets[i], fp) | has_fp(c->buckets[j], fp))
+		return 1;
+
+	return c->victim == fp && (c->victim_bucket == i ||
+				   c->victim_bucket == j);
+}
+
+/* Removing an entry makes room for the victim, if there's one. */
+static int cuckoo_del(struct cuckoo *c, uint64_t h)
+{
+	uint16_t fp = fingerprint(h);
+	uint64_t i = h & c->mask, j = alt_bucket(c, i, fp);
+	uint64_t v = c->victim_bucket;
+
+	if (c->victim == fp && (v == i || v == j)) {
+		c->victim = 0;
+		return 1;
+	}
+
+	if (!cuckoo_clear(c, i, fp) && !cuckoo_clear(c, j, fp))
+		return 0;
+
+	if (c->victim) {
+		fp        = c->victim;
+		c->victim = 0;
+
+		if (!cuckoo_put(c, v, fp) &&
+		    !cuckoo_put(c, alt_bucket(c, v, fp), fp))
+			c->victim = fp;  // Still no room for it.
+	}
+
+	return 1;
+}
+
+/* --- API --- */
+
+/* Allocs. a blocked Bloom filter for n keys, with a false positive rate of at
+ * most fpr (e.g. 0.01 for 1%) once they're all added. */
+struct filter *make_bloom(size_t n, double fpr)
+{
+	struct filter *f = malloc(sizeof(struct filter));
+	struct bloom *b = &f->u.bloom;
+	void *blocks;
+
+	f->kind    = FILTER_BLOOM;
+	f->n       = 0;
+	b->nblocks = bloom_blocks(n, fpr);
+
+	if (posix_memalign(&blocks, BLOCK_BYTES, b->nblocks * BLOCK_BYTES)) {
+		free(f);
+		return NULL;
+	}
+
+	b->blocks = memset(blocks, 0, b->nblocks * BLOCK_BYTES);
+
+	return f;
+}
+
+/* Allocs. a cuckoo filter for n keys. Buckets are rounded up to a power of 2,
+ * so that it's no more than 96% full with n keys in. */
+struct filter *make_cuckoo(size_t n)
+{
+	struct filter *f = malloc(sizeof(struct filter));
+	struct cuckoo *c = &f->u.cuckoo;
+	size_t nbuckets = 1;
+
+	while (nbuckets * SLOTS * MAX_LOAD < n)
+		nbuckets <<= 1;
+
+	f->kind    = FILTER_CUCKOO;
+	f->n       = 0;
+	c->buckets = calloc(nbuckets, sizeof(uint64_t));
+	c->mask    = nbuckets - 1;
+	c->victim  = 0;
+	c->rand    = 88172645463325252ull;
+
+	return f;
+}
+
+/* Returns zero if the key couldn't be added, which only happens to cuckoo
+ * filters that are full. */
+int filter_add(struct filter *f, uint64_t h)
+{
+	uint32_t *block, i;
+
+	if (f->kind == FILTER_CUCKOO) {
+		if (!cuckoo_add(&f->u.cuckoo, h))
+			return 0;
+	} else {
+		block = bloom_block(&f->u.bloom, h);
+
+		for (i = 0; i < BLOCK_WORDS; i++)
+			block[i] |= 1u << (((uint32_t) h * salt[i]) >> 27);
+	}
+
+	f->n++;
+
+	return 1;
+}
+
+/* Returns zero if the key is definitely not in. */
+int filter_test(struct filter *f, uint64_t h)
+{
+	if (f->kind == FILTER_CUCKOO)
+		return cuckoo_test(&f->u.cuckoo, h);
+
+	return block_test(bloom_block(&f->u.bloom, h), (uint32_t) h);
+}
+
+/* Only keys that were added should be removed: the fingerprint of some other
+ * key would be removed instead. Returns zero if nothing was (and always, for
+ * Bloom filters.) */
+int filter_del(struct filter *f, uint64_t h)
+{
+	if (f->kind != FILTER_CUCKOO || !cuckoo_del(&f->u.cuckoo, h))
+		return 0;
+
+	f->n--;
+
+	return 1;
+}
+
+size_t filter_size(struct filter *f)
+{
+	if (f->kind == FILTER_CUCKOO)
+		return (f->u.cuckoo.mask + 1) * sizeof(uint64_t);
+
+	return f->u.bloom.nblocks * BLOCK_BYTES;
+}
+
+void filter_destroy(struct filter *f)
+{
+	if (f->kind == FILTER_CUCKOO)
+		free(f->u.cuckoo.buckets);
+	else
+		free(f->u.bloom.blocks);
+
+	free(f);
+}
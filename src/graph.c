@@ -0,0 +1,464 @@
+#include "graph.h"
+#include "fibheap.h"
+#include "radixheap.h"
+
+/* Min-priority queues holding vertices, keyed by key[v]. Clients set key[v]
+ * before pushing v and lower it before decreasing it; queues never write to
+ * it. Each implementation embeds this struct., retrieved with container_of(). */
+struct pq {
+	const struct pq_ops *ops;
+	unsigned long       *key;
+};
+
+struct pq_ops {
+	void (*push)(struct pq *, int);
+	void (*decrease)(struct pq *, int);
+	int  (*pop)(struct pq *);          // Returns -1 if the queue is empty.
+	void (*destroy)(struct pq *);
+};
+
+/* ############# */
+/* Fibonacci heap */
+/* ############# */
+
+/* Nodes point to the key of their vertex, which is thus recovered by pointer
+ * arithmetic on the key array. */
+struct fib_pq {
+	struct pq           pq;
+	struct fibheap      *h;
+	struct fibheap_node **node;
+};
+
+static int fib_pq_cmp(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *) a;
+	unsigned long y = *(const unsigned long *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void fib_pq_push(struct pq *pq, int v)
+{
+	struct fib_pq *q = container_of(pq, struct fib_pq, pq);
+
+	q->node[v] = make_fibheap_node(&pq->key[v]);
+	fibheap_insert(q->h, q->node[v]);
+}
+
+static void fib_pq_decrease(struct pq *pq, int v)
+{
+	struct fib_pq *q = container_of(pq, struct fib_pq, pq);
+
+	fibheap_decrease(q->h, q->node[v]);
+}
+
+static int fib_pq_pop(struct pq *pq)
+{
+	struct fib_pq *q = container_of(pq, struct fib_pq, pq);
+	struct fibheap_node *x = fibheap_extract_min(q->h);
+	int v;
+
+	if (!x)
+		return -1;
+
+	v = (unsigned long *) x->value - pq->key;
+
+	free(x);
+	q->node[v] = NULL;
+
+	return v;
+}
+
+static void fib_pq_destroy(struct pq *pq)
+{
+	struct fib_pq *q = container_of(pq, struct fib_pq, pq);
+
+	free(q->h);
+	free(q->node);
+	free(q);
+}
+
+static const struct pq_ops fib_pq_ops = {
+	fib_pq_push, fib_pq_decrease, fib_pq_pop, fib_pq_destroy
+};
+
+static struct pq *make_fib_pq(int n, unsigned long *key)
+{
+	struct fib_pq *q = malloc(sizeof(struct fib_pq));
+
+	q->pq.ops = &fib_pq_ops;
+	q->pq.key = key;
+
+	q->h    = make_fibheap(fib_pq_cmp);
+	q->node = calloc(n, sizeof(struct fibheap_node *));
+
+	return &q->pq;
+}
+
+/* ########### */
+/* Binary heap */
+/* ########### */
+
+/* An implicit binary min-heap of vertices, along with the position of each
+ * vertex in it (or -1), which is needed for decreasing keys in O(log n). */
+struct bin_pq {
+	struct pq pq;
+	int       *heap;
+	int       *pos;
+	int       n;
+};
+
+#define PARENT(i) (((i) - 1) / 2)
+#define LEFT(i)   (2 * (i) + 1)
+
+static inline void bin_pq_place(struct bin_pq *q, int i, int v)
+{
+	q->heap[i] = v;
+	q->pos[v]  = i;
+}
+
+static void bin_pq_sift_up(struct bin_pq *q, int i)
+{
+	unsigned long *key = q->pq.key;
+	int v = q->heap[i];
+
+	while (i && key[v] < key[q->heap[PARENT(i)]]) {
+		bin_pq_place(q, i, q->heap[PARENT(i)]);
+		i = PARENT(i);
+	}
+	bin_pq_place(q, i, v);
+}
+
+static void bin_pq_sift_down(struct bin_pq *q, int i)
+{
+	unsigned long *key = q->pq.key;
+	int c, v = q->heap[i];
+
+	while ((c = LEFT(i)) < q->n) {
+		if (c + 1 < q->n && key[q->heap[c + 1]] < key[q->heap[c]])
+			c++;
+
+		if (key[v] <= key[q->heap[c]])
+			break;
+
+		bin_pq_place(q, i, q->heap[c]);
+		i = c;
+	}
+	bin_pq_place(q, i, v);
+}
+
+static void bin_pq_push(struct pq *pq, int v)
+{
+	struct bin_pq *q = container_of(pq, struct bin_pq, pq);
+
+	q->heap[q->n] = v;
+	bin_pq_sift_up(q, q->n++);
+}
+
+static void bin_pq_decrease(struct pq *pq, int v)
+{
+	struct bin_pq *q = container_of(pq, struct bin_pq, pq);
+
+	bin_pq_sift_up(q, q->pos[v]);
+}
+
+static int bin_pq_pop(struct pq *pq)
+{
+	struct bin_pq *q = container_of(pq, struct bin_pq, pq);
+	int v;
+
+	if (!q->n)
+		return -1;
+
+	v = q->heap[0];
+	q->pos[v] = -1;
+
+	if (--q->n) {
+		q->heap[0] = q->heap[q->n];
+		bin_pq_sift_down(q, 0);
+	}
+
+	return v;
+}
+
+static void bin_pq_destroy(struct pq *pq)
+{
+	struct bin_pq *q = container_of(pq, struct bin_pq, pq);
+
+	free(q->heap);
+	free(q->pos);
+	free(q);
+}
+
+static const struct pq_ops bin_pq_ops = {
+	bin_pq_push, bin_pq_decrease, bin_pq_pop, bin_pq_destroy
+};
+
+static struct pq *make_bin_pq(int n, unsigned long *key)
+{
+	struct bin_pq *q = malloc(sizeof(struct bin_pq));
+
+	q->pq.ops = &bin_pq_ops;
+	q->pq.key = key;
+
+	q->heap = malloc(n * sizeof(int));
+	q->pos  = malloc(n * sizeof(int));
+	q->n    = 0;
+
+	return &q->pq;
+}
+
+/* ########## */
+/* Radix heap */
+/* ########## */
+
+/* As with Fibonacci heaps, nodes point to the key of their vertex. */
+struct radix_pq {
+	struct pq             pq;
+	struct radixheap      *h;
+	struct radixheap_node **node;
+};
+
+static void radix_pq_push(struct pq *pq, int v)
+{
+	struct radix_pq *q = container_of(pq, struct radix_pq, pq);
+
+	q->node[v] = make_radixheap_node(pq->key[v], &pq->key[v]);
+	radixheap_insert(q->h, q->node[v]);
+}
+
+static void radix_pq_decrease(struct pq *pq, int v)
+{
+	struct radix_pq *q = container_of(pq, struct radix_pq, pq);
+
+	radixheap_decrease(q->h, q->node[v], pq->key[v]);
+}
+
+static int radix_pq_pop(struct pq *pq)
+{
+	struct radix_pq *q = container_of(pq, struct radix_pq, pq);
+	struct radixheap_node *x = radixheap_extract_min(q->h);
+	int v;
+
+	if (!x)
+		return -1;
+
+	v = (unsigned long *) x->value - pq->key;
+
+	free(x);
+	q->node[v] = NULL;
+
+	return v;
+}
+
+static void radix_pq_destroy(struct pq *pq)
+{
+	struct radix_pq *q = container_of(pq, struct radix_pq, pq);
+
+	free(q->h);
+	free(q->node);
+	free(q);
+}
+
+static const struct pq_ops radix_pq_ops = {
+	radix_pq_push, radix_pq_decrease, radix_pq_pop, radix_pq_destroy
+};
+
+static struct pq *make_radix_pq(int n, unsigned long *key)
+{
+	struct radix_pq *q = malloc(sizeof(struct radix_pq));
+
+	q->pq.ops = &radix_pq_ops;
+	q->pq.key = key;
+
+	q->h    = make_radixheap();
+	q->node = calloc(n, sizeof(struct radixheap_node *));
+
+	return &q->pq;
+}
+
+static struct pq *make_pq(enum graph_heap heap, int n, unsigned long *key)
+{
+	switch (heap) {
+	case GRAPH_RADIXHEAP:
+		return make_radix_pq(n, key);
+	case GRAPH_BINHEAP:
+		return make_bin_pq(n, key);
+	case GRAPH_FIBHEAP:
+	default:
+		return make_fib_pq(n, key);
+	}
+}
+
+/* --- API --- */
+
+/* Lays out the _m_ edges in CSR form by counting sort on their source vertex.
+ * If _undirected_ is set, each edge is also stored in the opposite direction. */
+struct graph *make_graph(int n, const struct graph_edge *edges, int m,
+			 int undirected)
+{
+	struct graph *g;
+	int i, *next;
+
+	if (n <= 0 || m < 0 || (m && !edges))
+		return NULL;
+
+	g = malloc(sizeof(struct graph));
+
+	g->n   = n;
+	g->m   = undirected ? 2 * m : m;
+	g->off = calloc(n + 1, sizeof(int));
+	g->adj = malloc(g->m * sizeof(int));
+	g->w   = malloc(g->m * sizeof(unsigned int));
+
+	/* Count the arcs leaving each vertex... */
+	for (i = 0; i < m; i++) {
+		g->off[edges[i].u + 1]++;
+
+		if (undirected)
+			g->off[edges[i].v + 1]++;
+	}
+
+	/* ...then turn the counts into offsets... */
+	for (i = 0; i < n; i++)
+		g->off[i + 1] += g->off[i];
+
+	/* ...and finally, place every arc at the next free slot of its source. */
+	next = malloc(n * sizeof(int));
+
+	for (i = 0; i < n; i++)
+		next[i] = g->off[i];
+
+	for (i = 0; i < m; i++) {
+		g->adj[next[edges[i].u]] = edges[i].v;
+		g->w[next[edges[i].u]++] = edges[i].w;
+
+		if (undirected) {
+			g->adj[next[edges[i].v]] = edges[i].u;
+			g->w[next[edges[i].v]++] = edges[i].w;
+		}
+	}
+
+	free(next);
+
+	return g;
+}
+
+/* Computes the length of the shortest paths from _src_ to every vertex in
+ * _dist_, which must hold n entries. If _pred_ isn't NULL, the predecessor of
+ * each vertex in its shortest path is stored in it (or -1.) */
+void graph_dijkstra(struct graph *g, int src, enum graph_heap heap,
+		    unsigned long *dist, int *pred)
+{
+	struct pq *q;
+	unsigned long d;
+	int i, u, v;
+
+	for (v = 0; v < g->n; v++)
+		dist[v] = GRAPH_INF;
+
+	if (pred)
+		for (v = 0; v < g->n; v++)
+			pred[v] = -1;
+
+	/* Distances double as the keys of the queue. */
+	q = make_pq(heap, g->n, dist);
+
+	dist[src] = 0;
+	q->ops->push(q, src);
+
+	while ((u = q->ops->pop(q)) >= 0) {
+		for (i = g->off[u]; i < g->off[u + 1]; i++) {
+			v = g->adj[i];
+			d = dist[u] + g->w[i];
+
+			if (d >= dist[v])
+				continue;
+
+			if (dist[v] == GRAPH_INF) {
+				dist[v] = d;
+				q->ops->push(q, v);
+			} else {
+				dist[v] = d;
+				q->ops->decrease(q, v);
+			}
+
+			if (pred)
+				pred[v] = u;
+		}
+	}
+
+	q->ops->destroy(q);
+}
+
+/* Computes a minimum spanning forest of an undirected graph, growing a tree
+ * from each vertex not reached yet. If _pred_ isn't NULL, the parent of each
+ * vertex in its tree is stored in it (or -1, for roots.) Returns the total
+ * weight of the forest.
+ *
+ * Keys extracted by Prim's algorithm are not monotone, so a binary heap is
+ * used in place of a radix heap. */
+unsigned long graph_prim(struct graph *g, enum graph_heap heap, int *pred)
+{
+	unsigned long *key = malloc(g->n * sizeof(unsigned long)), total = 0;
+	char *in_tree = calloc(g->n, sizeof(char));
+	struct pq *q;
+	int i, r, u, v;
+
+	if (heap == GRAPH_RADIXHEAP)
+		heap = GRAPH_BINHEAP;
+
+	q = make_pq(heap, g->n, key);
+
+	for (v = 0; v < g->n; v++)
+		key[v] = GRAPH_INF;
+
+	if (pred)
+		for (v = 0; v < g->n; v++)
+			pred[v] = -1;
+
+	for (r = 0; r < g->n; r++) {
+		if (in_tree[r])
+			continue;
+
+		key[r] = 0;
+		q->ops->push(q, r);
+
+		while ((u = q->ops->pop(q)) >= 0) {
+			in_tree[u] = 1;
+			total += key[u];
+
+			for (i = g->off[u]; i < g->off[u + 1]; i++) {
+				v = g->adj[i];
+
+				if (in_tree[v] || g->w[i] >= key[v])
+					continue;
+
+				if (key[v] == GRAPH_INF) {
+					key[v] = g->w[i];
+					q->ops->push(q, v);
+				} else {
+					key[v] = g->w[i];
+					q->ops->decrease(q, v);
+				}
+
+				if (pred)
+					pred[v] = u;
+			}
+		}
+	}
+
+	q->ops->destroy(q);
+	free(in_tree);
+	free(key);
+
+	return total;
+}
+
+void graph_destroy(struct graph *g)
+{
+	free(g->off);
+	free(g->adj);
+	free(g->w);
+	free(g);
+}
@@ -1,5 +1,11 @@
 #include "hash.h"
 
+static inline struct list_head *__hash_bucket(struct hash_table *ht,
+					      unsigned int h)
+{
+	return &ht->table[ht->mask ? h & ht->mask : h % ht->sz];
+}
+
 /* --- API --- */
 
 struct hash_table *make_hash_table(int sz, hash_fn fn, hash_cmp cmp)
@@ -14,30 +20,107 @@ struct hash_table *make_hash_table(int sz, hash_fn fn, hash_cmp cmp)
 	for (int i = 0; i < sz; i++)
 		INIT_LIST_HEAD(&ht->table[i]);
 
-	ht->fn  = fn;
-	ht->cmp = cmp;
+	ht->sz     = sz;
+	ht->mask   = sz & (sz - 1) ? 0 : sz - 1;
+	ht->fn     = fn;
+	ht->cmp    = cmp;
+	ht->filter = NULL;
+
+	ht->stats = (struct hash_stats) { 0 };
 
 	return ht;
 }
 
 void hash_insert(struct hash_table *ht, struct list_head *new, const void *key)
 {
-	list_add(new, &ht->table[ht->fn(key)]);
+	unsigned int h = ht->fn(key);
+
+	STATS_INC(ht->stats, inserts);
+
+	/* A key missing from the filter would never be found again. */
+	if (ht->filter && !filter_add(ht->filter, hash_mix64(h)))
+		ht->filter = NULL;
+
+	list_add(new, __hash_bucket(ht, h));
 }
 
 struct list_head *hash_search(struct hash_table *ht, const void *key)
 {
-	int idx = ht->fn(key);
-	struct list_head *runner;
+	unsigned int h = ht->fn(key);
+	struct list_head *bucket, *runner;
+	int probes = 0;
+
+	STATS_INC(ht->stats, searches);
+
+	if (ht->filter && !filter_test(ht->filter, hash_mix64(h))) {
+		STATS_INC(ht->stats, misses);
+		STATS_INC(ht->stats, filtered);
+		return NULL;
+	}
+
+	bucket = __hash_bucket(ht, h);
+
+	list_for_each(runner, bucket) {
+		probes++;
 
-	list_for_each(runner, &ht->table[idx])
 		if (ht->cmp(runner, key))
-			return runner;
+			break;
+	}
 
-	return NULL;
+	STATS_ADD(ht->stats, probes, probes);
+	STATS_MAX(ht->stats, max_probes, probes);
+
+	if (runner == bucket) {
+		STATS_INC(ht->stats, misses);
+		return NULL;
+	}
+
+	return runner;
 }
 
+/* For walking the entries a key may be among, e.g. for counting duplicates. */
+struct list_head *hash_bucket(struct hash_table *ht, const void *key)
+{
+	return __hash_bucket(ht, ht->fn(key));
+}
+
+/* Leaves the key in the filter, if one is attached. */
 void hash_delete(struct list_head *entry)
 {
 	list_del(entry);
 }
+
+/* Same as hash_delete(), but also removes the key from the filter (which only
+ * cuckoo filters support; Bloom filters keep reporting it.) */
+void hash_remove(struct hash_table *ht, struct list_head *entry,
+		 const void *key)
+{
+	if (ht->filter)
+		filter_del(ht->filter, hash_mix64(ht->fn(key)));
+
+	list_del(entry);
+}
+
+/* Entries already in the table aren't added to the filter, so it should be
+ * attached before the first insertion. The filter is still owned (and freed)
+ * by the caller. */
+void hash_attach_filter(struct hash_table *ht, struct filter *f)
+{
+	ht->filter = f;
+}
+
+struct hash_stats hash_stats_dump(struct hash_table *ht, FILE *out)
+{
+	struct hash_stats s = ht->stats;
+
+	if (out) {
+		STATS_PRINT(out, "hash", s, inserts);
+		STATS_PRINT(out, "hash", s, searches);
+		STATS_PRINT(out, "hash", s, misses);
+		STATS_PRINT(out, "hash", s, probes);
+		STATS_PRINT(out, "hash", s, max_probes);
+		STATS_PRINT(out, "hash", s, filtered);
+	}
+
+	return s;
+}
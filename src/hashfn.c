@@ -0,0 +1,313 @@
+#include <string.h>             // For memcpy() and strlen().
+
+#include "hashfn.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>          // For the AVX2 intrinsics.
+#define HASHFN_X86
+#endif
+
+/* The long-key loop reads 64-byte stripes, and scrambles the accumulators once
+ * per block of stripes. */
+#define STRIPE            64
+#define STRIPES_PER_BLOCK 16
+#define BLOCK             (STRIPE * STRIPES_PER_BLOCK)
+#define LANES             (STRIPE / sizeof(uint64_t))
+
+/* wyhash's secret. */
+static const uint64_t wyp[] = {
+	0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+	0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+/* Random odd words. Stripe i of a block is keyed with words i..i + 7, and the
+ * block is then scrambled with the last 8. */
+static const uint64_t secret[STRIPES_PER_BLOCK + LANES - 1] = {
+	0x550caef9618a9261ull, 0xfe1b14343b106981ull, 0xe6e9d6a12a8161e5ull,
+	0x62b8a158e9f0fcf9ull, 0xe57b47b993f3cfc7ull, 0x4890afe0b0ac88b9ull,
+	0x46db76078d954e51ull, 0xda1a4658622ff19bull, 0xc36492adbb4bb95dull,
+	0x026355459390c87dull, 0x3fc31a98c7fd59a1ull, 0xff72b36ba95d5ec7ull,
+	0x04b184cfd6dc3c3bull, 0xf2e4d9af707c2899ull, 0xfc96170a27b1519dull,
+	0xfadf6031265b9717ull, 0x51a264abb921a5c1ull, 0x41ec61502ae1fc89ull,
+	0xb0f2b5d2a7977badull, 0x9573164a9eeb0203ull, 0x1eac708b0f3b5607ull,
+	0x96772783c8c8d277ull, 0x6ebeb44008731893ull
+};
+
+#define SCRAMBLE_PRIME 0x9e3779b1u
+
+/* Unaligned little-endian reads (on big-endian machines, hashes differ, but
+ * are as good.) */
+static inline uint64_t r8(const unsigned char *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static inline uint64_t r4(const unsigned char *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+/* Reads 1 to 3 bytes. */
+static inline uint64_t r3(const unsigned char *p, size_t k)
+{
+	return ((uint64_t) p[0] << 16) | ((uint64_t) p[k >> 1] << 8) | p[k - 1];
+}
+
+/* Multiplies a and b, leaving the low half of the product in a, and the high
+ * half in b. */
+#ifdef __SIZEOF_INT128__
+
+__extension__ typedef unsigned __int128 u128;
+
+static inline void mum(uint64_t *a, uint64_t *b)
+{
+	u128 r = (u128) *a * *b;
+
+	*a = (uint64_t) r;
+	*b = (uint64_t) (r >> 64);
+}
+
+#else
+
+static inline void mum(uint64_t *a, uint64_t *b)
+{
+	uint64_t ha = *a >> 32, hb = *b >> 32;
+	uint64_t la = (uint32_t) *a, lb = (uint32_t) *b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl, lo;
+
+	lo = t + (rm1 << 32);
+	c += lo < t;
+
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+}
+
+#endif
+
+static inline uint64_t mix(uint64_t a, uint64_t b)
+{
+	mum(&a, &b);
+
+	return a ^ b;
+}
+
+/* Accumulates stripes into the lanes: each lane takes the product of the low
+ * and high halves of its (keyed) word, plus the word of its neighbour. */
+static void accumulate_scalar(uint64_t *acc, const unsigned char *p,
+			      size_t nstripes, const uint64_t *key)
+{
+	uint64_t d, dk;
+	size_t s, j;
+
+	for (s = 0; s < nstripes; s++, p += STRIPE, key++) {
+		for (j = 0; j < LANES; j++) {
+			d  = r8(p + 8 * j);
+			dk = d ^ key[j];
+
+			acc[j ^ 1] += d;
+			acc[j]     += (dk & 0xffffffff) * (dk >> 32);
+		}
+	}
+}
+
+#ifdef HASHFN_X86
+
+/* Same as above, 4 lanes to a register. */
+__attribute__ ((target ("avx2")))
+static void accumulate_avx2(uint64_t *acc, const unsigned char *p,
+			    size_t nstripes, const uint64_t *key)
+{
+	__m256i a0 = _mm256_loadu_si256((const __m256i *) acc);
+	__m256i a1 = _mm256_loadu_si256((const __m256i *) (acc + 4));
+	__m256i d0, d1, k0, k1;
+	size_t s;
+
+	for (s = 0; s < nstripes; s++, p += STRIPE, key++) {
+		d0 = _mm256_loadu_si256((const __m256i *) p);
+		d1 = _mm256_loadu_si256((const __m256i *) (p + 32));
+		k0 = _mm256_xor_si256(d0,
+			_mm256_loadu_si256((const __m256i *) key));
+		k1 = _mm256_xor_si256(d1,
+			_mm256_loadu_si256((const __m256i *) (key + 4)));
+
+		/* Swapping the words within each 128-bit half adds in the word
+		 * of the neighbouring lane. */
+		a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(d0, 0x4e));
+		a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(d1, 0x4e));
+		a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(k0,
+			_mm256_srli_epi64(k0, 32)));
+		a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(k1,
+			_mm256_srli_epi64(k1, 32)));
+	}
+
+	_mm256_storeu_si256((__m256i *) acc, a0);
+	_mm256_storeu_si256((__m256i *) (acc + 4), a1);
+}
+
+#endif // HASHFN_X86
+
+/* Picked once, at startup, according to what the CPU supports. */
+static void (*accumulate)(uint64_t *, const unsigned char *, size_t,
+			  const uint64_t *) = accumulate_scalar;
+
+__attribute__ ((constructor))
+static void hashfn_init(void)
+{
+#ifdef HASHFN_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		accumulate = accumulate_avx2;
+#endif
+}
+
+/* Keeps high bits from piling up in the lanes, since products only carry
+ * upwards. */
+static inline void scramble(uint64_t *acc)
+{
+	const uint64_t *key = secret + STRIPES_PER_BLOCK - 1;
+	size_t j;
+
+	for (j = 0; j < LANES; j++) {
+		acc[j] ^= acc[j] >> 47;
+		acc[j] ^= key[j];
+		acc[j] *= SCRAMBLE_PRIME;
+	}
+}
+
+static uint64_t hash_long(const unsigned char *p, size_t len, uint64_t seed)
+{
+	uint64_t acc[LANES] = {
+		0x00000000c2b2ae3dull, 0x9e3779b185ebca87ull,
+		0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull,
+		0x85ebca77c2b2ae63ull, 0x0000000085ebca77ull,
+		0x27d4eb2f165667c5ull, 0x000000009e3779b1ull
+	}, h = len * wyp[0];
+	size_t j, nblocks = (len - 1) / BLOCK;
+
+	for (j = 0; j < LANES; j++)
+		acc[j] ^= seed;
+
+	for (j = 0; j < nblocks; j++, p += BLOCK, len -= BLOCK) {
+		accumulate(acc, p, STRIPES_PER_BLOCK, secret);
+		scramble(acc);
+	}
+
+	/* Whole stripes left, then the last 64 bytes (which may overlap.) */
+	accumulate(acc, p, (len - 1) / STRIPE, secret);
+	accumulate(acc, p + len - STRIPE, 1, secret + LANES - 1);
+
+	for (j = 0; j < LANES; j += 2)
+		h += mix(acc[j] ^ secret[j + 1], acc[j + 1] ^ secret[j + 2]);
+
+	return hash_mix64(h ^ seed);
+}
+
+/* --- API --- */
+
+/* wyhash's final version, with the long-key loop swapped for hash_long(). */
+uint64_t hash_bytes(const void *key, size_t len, uint64_t seed)
+{
+	const unsigned char *p = key;
+	uint64_t a, b, see1, see2;
+	size_t i = len;
+
+	if (len >= HASH_LONG_KEY)
+		return hash_long(p, len, seed);
+
+	seed ^= mix(seed ^ wyp[0], wyp[1]);
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (r4(p) << 32) | r4(p + ((len >> 3) << 2));
+			b = (r4(p + len - 4) << 32) |
+			    r4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = r3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		if (i > 48) {
+			see1 = see2 = seed;
+
+			do {
+				seed = mix(r8(p) ^ wyp[1], r8(p + 8) ^ seed);
+				see1 = mix(r8(p + 16) ^ wyp[2], r8(p + 24) ^ see1);
+				see2 = mix(r8(p + 32) ^ wyp[3], r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		while (i > 16) {
+			seed = mix(r8(p) ^ wyp[1], r8(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+
+		a = r8(p + i - 16);
+		b = r8(p + i - 8);
+	}
+
+	a ^= wyp[1];
+	b ^= seed;
+	mum(&a, &b);
+
+	return mix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+uint64_t hash_string(const char *s)
+{
+	return hash_bytes(s, strlen(s), 0);
+}
+
+/* Returns the name of the variant picked at startup. */
+const char *hash_bytes_isa(void)
+{
+#ifdef HASHFN_X86
+	if (accumulate == accumulate_avx2)
+		return "avx2";
+#endif
+	return "scalar";
+}
+
+/* Wrappers for hash tables fold the upper half of the hash into the lower one,
+ * which is what bucket indices are taken from. */
+unsigned int hash_fn_string(const void *key)
+{
+	uint64_t h = hash_string(key);
+
+	return (unsigned int) (h ^ (h >> 32));
+}
+
+unsigned int hash_fn_u64(const void *key)
+{
+	uint64_t h = hash_mix64(*(const uint64_t *) key);
+
+	return (unsigned int) (h ^ (h >> 32));
+}
+
+unsigned int hash_fn_u32(const void *key)
+{
+	return hash_mix32(*(const uint32_t *) key);
+}
+
+unsigned int hash_fn_ptr(const void *key)
+{
+	uint64_t h = hash_mix64((uintptr_t) key);
+
+	return (unsigned int) (h ^ (h >> 32));
+}
@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200809L // For mmap(), fileno() and fsync().
+
+#include <errno.h>              // For errno.
+#include <fcntl.h>              // For open().
+#include <stdio.h>              // For fopen() and rename().
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For strlen().
+#include <sys/mman.h>           // For mmap().
+#include <sys/stat.h>           // For fstat().
+#include <unistd.h>             // For close().
+
+#include "hashfn.h"
+#include "image.h"
+
+/* Seeded with the magic number, so that images of different kinds (but
+ * otherwise equal bytes) don't check out as each other. */
+static uint64_t checksum(const struct image_hdr *img)
+{
+	return hash_bytes(img + 1, img->size - sizeof(struct image_hdr),
+			  img->magic);
+}
+
+/* --- API --- */
+
+/* Should be called once the image is fully built, as the checksum is taken
+ * over the rest of it. */
+void image_seal(struct image_hdr *img, uint32_t magic, uint32_t version,
+		uint64_t size)
+{
+	img->magic    = magic;
+	img->version  = version;
+	img->bom      = IMAGE_BOM;
+	img->unused   = 0;
+	img->size     = size;
+	img->checksum = checksum(img);
+}
+
+/* Checks that the image is of the given kind and version, and len bytes long.
+ * If verify is set, also checks the checksum. Returns non-zero if it's fine. */
+int image_check(const struct image_hdr *img, size_t len, uint32_t magic,
+		uint32_t version, int verify)
+{
+	if (len < sizeof(struct image_hdr))
+		return 0;
+
+	if (img->magic != magic || img->version != version ||
+	    img->bom != IMAGE_BOM || img->size != len)
+		return 0;
+
+	return !verify || img->checksum == checksum(img);
+}
+
+/* Writes to a temporary file first, which is then renamed, so that readers
+ * never map a half-written image. Returns zero, or -1 with errno set. */
+int image_save(const struct image_hdr *img, const char *path)
+{
+	char *tmp = malloc(strlen(path) + sizeof(".tmp"));
+	FILE *f;
+	int ret = -1, ok, err;
+
+	sprintf(tmp, "%s.tmp", path);
+
+	if ((f = fopen(tmp, "wb"))) {
+		ok = fwrite(img, 1, img->size, f) == img->size && !fflush(f) &&
+		     !fsync(fileno(f));
+		ok = !fclose(f) && ok;
+
+		if (ok && !rename(tmp, path)) {
+			ret = 0;
+		} else {
+			err = errno;
+			remove(tmp);
+			errno = err;
+		}
+	}
+
+	free(tmp);
+
+	return ret;
+}
+
+/* Maps the image read-only, which, not being written to, is shared with
+ * every other process mapping the same file. Returns NULL, with errno set, if
+ * the file can't be mapped, or EINVAL if image_check() or valid (unless NULL)
+ * fails. */
+struct image_hdr *image_load(const char *path, uint32_t magic,
+			     uint32_t version, int verify, image_valid valid)
+{
+	struct image_hdr *img;
+	struct stat st;
+	int fd, err;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return NULL;
+
+	if (fstat(fd, &st)) {
+		img   = MAP_FAILED;
+	} else if (st.st_size < (off_t) sizeof(struct image_hdr)) {
+		img   = MAP_FAILED;
+		errno = EINVAL;
+	} else {
+		img   = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+
+	err = errno;
+	close(fd);  // The mapping stays.
+
+	if (img == MAP_FAILED) {
+		errno = err;
+		return NULL;
+	}
+
+	if (!image_check(img, st.st_size, magic, version, verify) ||
+	    (valid && !valid(img))) {
+		munmap(img, st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return img;
+}
+
+void image_unload(struct image_hdr *img)
+{
+	munmap(img, img->size);
+}
+
+/* Images are either mapped in by image_load(), or built in malloc()ed memory
+ * (e.g. by hash_freeze()); mapped tells which. */
+void image_destroy(struct image_hdr *img, int mapped)
+{
+	if (mapped)
+		image_unload(img);
+	else
+		free(img);
+}
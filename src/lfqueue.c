@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 200809L // For posix_memalign().
+
+#include "lfqueue.h"
+
+#define LOAD(_ptr)        __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+#define STORE(_ptr, _val) __atomic_store_n((_ptr), (_val), __ATOMIC_RELEASE)
+#define XCHG(_ptr, _val)  __atomic_exchange_n((_ptr), (_val), __ATOMIC_ACQ_REL)
+
+static inline int cas(unsigned long *ptr, unsigned long old, unsigned long new)
+{
+	return __atomic_compare_exchange_n(ptr, &old, new, 0, __ATOMIC_RELAXED,
+					   __ATOMIC_RELAXED);
+}
+
+/* Appends the chain first..last, which must already be linked. Between the
+ * exchange and the store, the chain is detached from the rest of the queue,
+ * and the consumer sees the queue as empty. */
+static inline void mpsc_push_chain(struct mpsc_queue *q,
+				   struct mpsc_node *first,
+				   struct mpsc_node *last)
+{
+	struct mpsc_node *prev;
+
+	last->next = NULL;
+	prev = XCHG(&q->head, last);
+	STORE(&prev->next, first);
+}
+
+/* Counts how many slots, starting at _pos_, are ready for the round given by
+ * their sequence number minus _off_ (0 for writing, 1 for reading.) Returns -1
+ * if the first slot is already past it, meaning _pos_ went stale. */
+static inline int mpmc_ready(struct mpmc_queue *q, unsigned long pos,
+			     unsigned long off, int n)
+{
+	long diff;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		diff = LOAD(&q->cells[(pos + i) & q->mask].seq) - (pos + i + off);
+
+		if (diff)
+			return !i && diff > 0 ? -1 : i;
+	}
+
+	return i;
+}
+
+/* --- API --- */
+
+struct mpsc_queue *make_mpsc(void)
+{
+	struct mpsc_queue *q;
+
+	if (posix_memalign((void **) &q, LFQUEUE_CACHE_LINE,
+			   sizeof(struct mpsc_queue)))
+		return NULL;
+
+	q->stub.next = NULL;
+	q->head      = &q->stub;
+	q->tail      = &q->stub;
+
+	return q;
+}
+
+void mpsc_push(struct mpsc_queue *q, struct mpsc_node *x)
+{
+	mpsc_push_chain(q, x, x);
+}
+
+/* The nodes are appended in order, with a single exchange. */
+void mpsc_push_batch(struct mpsc_queue *q, struct mpsc_node **xs, int n)
+{
+	int i;
+
+	if (n <= 0)
+		return;
+
+	for (i = 0; i < n - 1; i++)
+		xs[i]->next = xs[i + 1];
+
+	mpsc_push_chain(q, xs[0], xs[n - 1]);
+}
+
+/* Only one thread may pop at a time. Returns NULL if the queue is empty, or if
+ * a producer is in the middle of appending the next node. */
+struct mpsc_node *mpsc_pop(struct mpsc_queue *q)
+{
+	struct mpsc_node *tail = q->tail, *next = LOAD(&tail->next);
+
+	/* Skip over the stub. */
+	if (tail == &q->stub) {
+		if (!next)
+			return NULL;
+
+		q->tail = next;
+		tail    = next;
+		next    = LOAD(&next->next);
+	}
+
+	if (next) {
+		q->tail = next;
+		return tail;
+	}
+
+	if (tail != LOAD(&q->head))
+		return NULL;
+
+	/* The tail is the last node; put the stub behind it, so that it can be
+	 * detached without leaving the queue empty. */
+	mpsc_push(q, &q->stub);
+
+	if ((next = LOAD(&tail->next))) {
+		q->tail = next;
+		return tail;
+	}
+
+	return NULL;
+}
+
+int mpsc_pop_batch(struct mpsc_queue *q, struct mpsc_node **xs, int n)
+{
+	int i;
+
+	for (i = 0; i < n && (xs[i] = mpsc_pop(q)); i++)
+		;
+
+	return i;
+}
+
+/* Allocs. a queue holding up to _sz_ items, rounded up to a power of 2. */
+struct mpmc_queue *make_mpmc(unsigned long sz)
+{
+	struct mpmc_queue *q;
+	unsigned long i, cap = 2;
+
+	while (cap < sz)
+		cap <<= 1;
+
+	if (posix_memalign((void **) &q, LFQUEUE_CACHE_LINE,
+			   sizeof(struct mpmc_queue)))
+		return NULL;
+
+	q->cells = malloc(cap * sizeof(struct mpmc_cell));
+	q->mask  = cap - 1;
+
+	for (i = 0; i < cap; i++)
+		q->cells[i].seq = i;
+
+	q->enq = 0;
+	q->deq = 0;
+
+	return q;
+}
+
+/* Returns zero if the queue is full. */
+int mpmc_enqueue(struct mpmc_queue *q, void *data)
+{
+	return mpmc_enqueue_batch(q, &data, 1);
+}
+
+/* Claims as many free slots as there are (up to _n_) in a single CAS, then
+ * fills them in. Returns the number of items enqueued. */
+int mpmc_enqueue_batch(struct mpmc_queue *q, void **data, int n)
+{
+	unsigned long pos;
+	int i, k;
+
+	do {
+		pos = __atomic_load_n(&q->enq, __ATOMIC_RELAXED);
+
+		if (!(k = mpmc_ready(q, pos, 0, n)))
+			return 0;
+	} while (k < 0 || !cas(&q->enq, pos, pos + k));
+
+	for (i = 0; i < k; i++) {
+		q->cells[(pos + i) & q->mask].data = data[i];
+		STORE(&q->cells[(pos + i) & q->mask].seq, pos + i + 1);
+	}
+
+	return k;
+}
+
+/* Returns NULL if the queue is empty, so items shouldn't be NULL. */
+void *mpmc_dequeue(struct mpmc_queue *q)
+{
+	void *data;
+
+	return mpmc_dequeue_batch(q, &data, 1) ? data : NULL;
+}
+
+/* Returns the number of items dequeued. Slots are handed back to producers for
+ * the next round around the ring. */
+int mpmc_dequeue_batch(struct mpmc_queue *q, void **data, int n)
+{
+	unsigned long pos;
+	int i, k;
+
+	do {
+		pos = __atomic_load_n(&q->deq, __ATOMIC_RELAXED);
+
+		if (!(k = mpmc_ready(q, pos, 1, n)))
+			return 0;
+	} while (k < 0 || !cas(&q->deq, pos, pos + k));
+
+	for (i = 0; i < k; i++) {
+		data[i] = q->cells[(pos + i) & q->mask].data;
+		STORE(&q->cells[(pos + i) & q->mask].seq, pos + i + q->mask + 1);
+	}
+
+	return k;
+}
+
+void mpmc_destroy(struct mpmc_queue *q)
+{
+	free(q->cells);
+	free(q);
+}
@@ -4,12 +4,19 @@
 
 #include "hash.h"
 #include "rbtree.h"
+#include "art.h"
+#include "extsort.h"
 #include "fibheap.h"
+#include "ohash.h"
+#include "phash.h"
+#include "sarray.h"
+#include "sketch.h"
+#include "sort.h"
 #include "strmatch.h"
 
 #define LEN(x) (sizeof(x) / sizeof(x[0]))
-#define PRIME  101
-#define MASK   0xFF
+#define DICT_SZ 128
+#define MASK    0xFF
 
 void hash_insert_words(struct hash_table *, void *);
 
@@ -103,6 +110,19 @@ static char *strip(const char *src, char *dst)
 	return dst;
 }
 
+/* Visits the words in the buffer, stripped (into tmp), skipping those left
+ * empty. */
+static void for_each_word(void (*visit)(const char *, void *), void *arg)
+{
+	char copy[sizeof(buf)], *w;
+
+	strcpy(copy, buf);
+
+	for (w = strtok(copy, " \n"); w; w = strtok(NULL, " \n"))
+		if (*strip(w, tmp))
+			visit(tmp, arg);
+}
+
 static struct word_count *make_word_count(const char *word)
 {
 	struct word_count *wc = malloc(sizeof(struct word_count));
@@ -233,25 +253,36 @@ static void test_patmatch()
 	printf("\n");
 }
 
-static unsigned int word_count_hash_fn(const void *word)
+/* Counts the same patterns with an index of the buffer, built once, and prints
+ * the longest repeated substring. */
+static void test_sarray()
 {
-	unsigned int c, ret = 1;
-	char *w = (char *) word;
+	const char *pat, *pats[] = { "que", "première", "coiffeur" };
+	struct sarray *s = make_sarray(buf, strlen(buf), SARRAY_LCP | SARRAY_FM);
+	size_t i, len, pos;
+
+	for (i = 0; i < LEN(pats); i++) {
+		pat = pats[i];
+
+		printf("The pattern \"%s\" is indexed %zu time(s).\n", pat,
+		       sarray_search(s, pat, strlen(pat), NULL));
+	}
+
+	len = sarray_longest_repeat(s, &pos);
 
-	while ((c = *w++))
-		ret = (ret * c) % PRIME;
+	printf("The longest repeated substring is \"%.*s\".\n\n", (int) len,
+	       buf + pos);
 
-	return ret;
+	sarray_destroy(s);
 }
 
 void hash_insert_words(struct hash_table *ht, void *entry)
 {
 	struct word_count *wc, *_wc = (struct word_count *) entry;
 	char *stripped = strip(_wc->key, tmp);
-	int idx = ht->fn(stripped);
 
 	/* If the word is already in the dictionary, increase its count. */
-	list_for_each_entry(wc, &ht->table[idx], list) {
+	list_for_each_entry(wc, hash_bucket(ht, stripped), list) {
 		if (!strcmp(stripped, wc->key)) {
 			wc->value++;
 			free(_wc->key);
@@ -279,18 +310,74 @@ static int word_count_hash_cmp(struct list_head *left, const void *right)
 		container_of(left, struct word_count, list), right);
 }
 
+static const void *word_count_key(struct list_head *x)
+{
+	return container_of(x, struct word_count, list)->key;
+}
+
+static uint64_t word_count_hash64(const void *word)
+{
+	return hash_string(word);
+}
+
+/* Records hold the count, followed by the word. */
+static size_t word_count_pack(struct list_head *x, void *rec)
+{
+	struct word_count *wc = container_of(x, struct word_count, list);
+	size_t len = strlen(wc->key) + 1;
+
+	if (rec) {
+		memcpy(rec, &wc->value, sizeof(int));
+		memcpy((char *) rec + sizeof(int), wc->key, len);
+	}
+
+	return sizeof(int) + len;
+}
+
+static int word_count_rec_cmp(const void *rec, const void *word)
+{
+	return !strcmp((const char *) rec + sizeof(int), word);
+}
+
+/* Looks up a few words in a frozen copy of the dictionary. */
+static void test_phash()
+{
+	const char *w, *words[] = { "que", "maman", "coiffeur" };
+	struct phash *f;
+	const int *count;
+	int i, len = LEN(words);
+
+	f = hash_freeze(dict, word_count_key, word_count_hash64,
+			word_count_pack, word_count_rec_cmp);
+
+	for (i = 0; i < len; i++) {
+		w = words[i];
+
+		if ((count = phash_search(f, w)))
+			printf("The word \"%s\" occurs %i time(s) ", w, *count);
+		else
+			printf("The word \"%s\" does not occur ", w);
+
+		printf("in the dictionary.\n");
+	}
+
+	printf("\n");
+
+	phash_destroy(f);
+}
+
 /* Finds the most repeated words in the buffer. */
 static void test_hash()
 {
 	struct word_count *wc, *next;
 	struct fibheap *h = make_fibheap(word_count_fibheap_cmp);
 	struct fibheap_node *hn;
-	int i, n = 10, sz = PRIME;
+	int i, n = 10;
 
 	printf("Here are the %i most repeated words in the paragraph:\n\n", n);
 
 	/* Insert the counts in a heap; higher counts mean higher priority. */
-	for (i = 0; i < sz; i++) {
+	for (i = 0; i < dict->sz; i++) {
 		list_for_each_entry_safe(wc, next, &dict->table[i], list) {
 			fibheap_insert(h, make_fibheap_node(wc));
 			list_del(&wc->list);
@@ -316,15 +403,186 @@ static void test_hash()
 	free(h);
 }
 
+static void topk_add_word(const char *word, void *t)
+{
+	topk_add(t, word, strlen(word));
+}
+
+/* Same as above, in a fixed amount of memory: only k words are counted at a
+ * time, so counts are approximate. */
+static void test_topk()
+{
+	struct topk *t = make_topk(64);
+	struct topk_counter out[64];
+	int i, n;
+
+	for_each_word(topk_add_word, t);
+
+	printf("\nAnd as counted by a summary of %i words:\n\n", t->k);
+
+	n = topk_list(t, out);
+
+	for (i = 0; i < n && i < 5; i++)
+		printf(" Word: \"%.*s\", frequency: %lu to %lu\n",
+		       (int) out[i].len, out[i].key,
+		       (unsigned long) (out[i].count - out[i].error),
+		       (unsigned long) out[i].count);
+
+	topk_destroy(t);
+}
+
+/* Words indexed by an ordered hash table, for counting them and listing them
+ * in order at once. */
+struct word_entry {
+	char              *key;
+	int               value;
+
+	struct ohash_node node;
+};
+
+static int word_entry_cmp(const void *a, const void *b)
+{
+	return strcmp(a, b);
+}
+
+static void ohash_count_word(const char *word, void *oh)
+{
+	struct ohash_node *x;
+	struct word_entry *we;
+
+	if ((x = ohash_search(oh, word))) {
+		ohash_entry(x, struct word_entry, node)->value++;
+		return;
+	}
+
+	we        = malloc(sizeof(struct word_entry));
+	we->key   = malloc(strlen(word) + 1);
+	we->value = 1;
+	strcpy(we->key, word);
+
+	ohash_insert(oh, &we->node, we->key);
+}
+
+/* Counts the words in the buffer, then lists those within a range. */
+static void test_ohash()
+{
+	struct ohash *oh = make_ohash(DICT_SZ, hash_fn_string, word_entry_cmp);
+	struct ohash_node *x, *next;
+	struct word_entry *we;
+	const char *from = "p", *to = "r";
+
+	for_each_word(ohash_count_word, oh);
+
+	printf("\nWords from \"%s\" to \"%s\", in order:\n\n", from, to);
+
+	for (x = ohash_lower_bound(oh, from); x; x = ohash_next(oh, x)) {
+		we = ohash_entry(x, struct word_entry, node);
+
+		if (strcmp(we->key, to) >= 0)
+			break;
+
+		printf(" Word: \"%s\", frequency: %i\n", we->key, we->value);
+	}
+
+	for (x = ohash_first(oh); x; x = next) {
+		next = ohash_next(oh, x);
+		we   = ohash_entry(x, struct word_entry, node);
+
+		ohash_delete(oh, x);
+		free(we->key);
+		free(we);
+	}
+
+	ohash_destroy(oh);
+}
+
+static int word_art_visit(struct art_leaf *l, void *arg)
+{
+	(void) arg;
+	printf(" Word: \"%.*s\"\n", (int) l->len, (const char *) l->key);
+
+	return 0;
+}
+
+static void art_insert_word(const char *word, void *t)
+{
+	art_insert(t, word, strlen(word), NULL);
+}
+
+/* Indexes the words in the buffer by their bytes, then lists those starting
+ * with a prefix. */
+static void test_art()
+{
+	struct art *t = make_art();
+	const char *prefix = "pr";
+
+	for_each_word(art_insert_word, t);
+
+	printf("\nWords starting with \"%s\", out of %zu:\n\n", prefix,
+	       t->n);
+
+	art_prefix_walk(t, prefix, strlen(prefix), word_art_visit, NULL);
+	art_destroy(t);
+}
+
+static uint64_t word_key(const void *w)
+{
+	return ((const struct word *) w)->key;
+}
+
+/* Sorts copies of the first and third sets of words (those in the red-black
+ * tree) by key, with radix sort and pdqsort, which should agree. */
+static void test_sort()
+{
+	struct word all[LEN(words1) + LEN(words3)], copy[LEN(all)];
+	size_t n = LEN(all);
+
+	memcpy(all, words1, sizeof(words1));
+	memcpy(all + LEN(words1), words3, sizeof(words3));
+	memcpy(copy, all, sizeof(all));
+
+	sort_radix(all, n, sizeof(struct word), word_key);
+	sort_pdq(copy, n, sizeof(struct word), word_cmp);
+
+	printf("\nSorted %zu words, from \"%s\" ", n, strip(all[0].str, tmp));
+	printf("to \"%s\", %s.\n", strip(all[n - 1].str, tmp),
+	       memcmp(all, copy, sizeof(all)) ? "with a mismatch" :
+	       "both ways alike");
+}
+
+static int word_extsort_visit(const void *w, void *last)
+{
+	*(struct word *) last = *(const struct word *) w;
+
+	return 0;
+}
+
+/* Sorts the second and fourth sets of words (those in the fibonacci heaps)
+ * with room for 8 of them at a time, so that they're spilled in runs, then
+ * merged. */
+static void test_extsort()
+{
+	struct extsort *x = make_extsort(sizeof(struct word), word_cmp,
+					 8 * sizeof(struct word));
+	struct word last;
+
+	extsort_add(x, words2, LEN(words2));
+	extsort_add(x, words4, LEN(words4));
+	extsort_finish(x, word_extsort_visit, &last);
+
+	printf("The last of the words, sorted 8 at a time, then merged, is ");
+	printf("\"%s\".\n", strip(last.str, tmp));
+
+	extsort_destroy(x);
+}
+
 int main(int argc __attribute__ ((unused)),
 	 const char **argv __attribute__ ((unused)))
 {
 	/* A small test case for the implemented algorithms and data structures.
 	 * A set of words are sorted and printed such that together make sense. */
 
-	int sz = PRIME;
-
-	dict = make_hash_table(sz, word_count_hash_fn, word_count_hash_cmp);
+	dict = make_hash_table(DICT_SZ, hash_fn_string, word_count_hash_cmp);
 
 	printf("For those who like Camus:\n\n");
 
@@ -334,10 +592,22 @@ int main(int argc __attribute__ ((unused)),
 	printf("%s\n", buf);
 
 	test_patmatch();
+	test_sarray();
+	test_phash();
 	test_hash();
+	test_topk();
+	test_ohash();
+	test_art();
+	test_sort();
+	test_extsort();
 
 	printf("\n");
 
+#ifdef ALGS_STATS
+	hash_stats_dump(dict, stdout);
+	strmatch_stats_dump(stdout);
+#endif
+
 	/* Smile, it's good for you. */
 	return 0;
 }
@@ -0,0 +1,206 @@
+#define _POSIX_C_SOURCE 200809L // For posix_memalign().
+
+#include "mqueue.h"
+
+#define PARENT(i) (((i) - 1) / 2)
+#define LEFT(i)   (2 * (i) + 1)
+
+#define LOCK(_heap)                                                             \
+	while (__atomic_test_and_set(&(_heap)->lock, __ATOMIC_ACQUIRE))
+
+#define TRY_LOCK(_heap)                                                         \
+	(!__atomic_test_and_set(&(_heap)->lock, __ATOMIC_ACQUIRE))
+
+#define UNLOCK(_heap)                                                           \
+	__atomic_clear(&(_heap)->lock, __ATOMIC_RELEASE)
+
+#define GET_TOP(_heap)                                                          \
+	__atomic_load_n(&(_heap)->top, __ATOMIC_RELAXED)
+
+#define GET_SIZE(_heap)                                                         \
+	__atomic_load_n(&(_heap)->size, __ATOMIC_RELAXED)
+
+/* Publishes the minimal key and the size of a queue, for reading them without
+ * taking its lock. */
+#define SET_TOP(_heap)                                                          \
+	do {                                                                    \
+		__atomic_store_n(&(_heap)->top, (_heap)->n ?                    \
+				 (_heap)->elems[0].key : MQUEUE_EMPTY,          \
+				 __ATOMIC_RELAXED);                             \
+		__atomic_store_n(&(_heap)->size, (_heap)->n, __ATOMIC_RELAXED); \
+	} while (0)
+
+/* Per-thread state of the xorshift generator used for picking queues. Seeded
+ * lazily, from a counter shared by all threads. */
+static __thread unsigned long long seed;
+
+static unsigned long long seed_counter;
+
+static inline unsigned int rand_queue(int n)
+{
+	if (!seed)
+		seed = (__atomic_add_fetch(&seed_counter, 1, __ATOMIC_RELAXED) *
+			0x9E3779B97F4A7C15ULL) | 1;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return (unsigned int) ((seed >> 32) % n);
+}
+
+static void heap_push(struct mqueue_heap *h, unsigned long key, void *value)
+{
+	int i;
+
+	if (h->n == h->sz) {
+		h->sz    = h->sz ? 2 * h->sz : 64;
+		h->elems = realloc(h->elems, h->sz * sizeof(struct mqueue_elem));
+	}
+
+	for (i = h->n++; i && key < h->elems[PARENT(i)].key; i = PARENT(i))
+		h->elems[i] = h->elems[PARENT(i)];
+
+	h->elems[i].key   = key;
+	h->elems[i].value = value;
+}
+
+static struct mqueue_elem heap_pop(struct mqueue_heap *h)
+{
+	struct mqueue_elem top = h->elems[0], last = h->elems[--h->n];
+	int c, i = 0;
+
+	while ((c = LEFT(i)) < h->n) {
+		if (c + 1 < h->n && h->elems[c + 1].key < h->elems[c].key)
+			c++;
+
+		if (last.key <= h->elems[c].key)
+			break;
+
+		h->elems[i] = h->elems[c];
+		i = c;
+	}
+	h->elems[i] = last;
+
+	return top;
+}
+
+/* --- API --- */
+
+/* Allocs. a MultiQueue made of _n_ sequential queues. */
+struct mqueue *make_mqueue(int n)
+{
+	struct mqueue *q;
+	int i;
+
+	if (n < 1)
+		return NULL;
+
+	q = malloc(sizeof(struct mqueue));
+
+	if (posix_memalign((void **) &q->heaps, MQUEUE_CACHE_LINE,
+			   n * sizeof(struct mqueue_heap))) {
+		free(q);
+		return NULL;
+	}
+
+	q->n = n;
+
+	for (i = 0; i < n; i++) {
+		q->heaps[i].elems = NULL;
+		q->heaps[i].n     = 0;
+		q->heaps[i].sz    = 0;
+		q->heaps[i].top   = MQUEUE_EMPTY;
+		q->heaps[i].size  = 0;
+		q->heaps[i].lock  = 0;
+	}
+
+	return q;
+}
+
+void mqueue_insert(struct mqueue *q, unsigned long key, void *value)
+{
+	struct mqueue_heap *h;
+
+	/* Keep on picking queues until one is free. */
+	for (;;) {
+		h = &q->heaps[rand_queue(q->n)];
+
+		if (q->n == 1)
+			LOCK(h);
+		else if (!TRY_LOCK(h))
+			continue;
+
+		break;
+	}
+
+	heap_push(h, key, value);
+	SET_TOP(h);
+
+	UNLOCK(h);
+}
+
+/* Extracts an element close to the minimum, storing its key and value. Returns
+ * zero if all queues were found empty, and non-zero otherwise. */
+int mqueue_try_extract_min(struct mqueue *q, unsigned long *key, void **value)
+{
+	struct mqueue_heap *h, *other;
+	struct mqueue_elem e;
+	int i;
+
+	for (;;) {
+		h     = &q->heaps[rand_queue(q->n)];
+		other = &q->heaps[rand_queue(q->n)];
+
+		if (GET_TOP(other) < GET_TOP(h))
+			h = other;
+
+		/* Both seem empty; make sure all of them are before giving up.
+		 * Sizes are checked rather than keys, as MQUEUE_EMPTY may well
+		 * be a key in the queue. */
+		if (!GET_SIZE(h)) {
+			for (i = 0; i < q->n; i++)
+				if (GET_SIZE(&q->heaps[i]))
+					break;
+
+			if (i == q->n)
+				return 0;
+
+			h = &q->heaps[i];
+		}
+
+		if (q->n == 1)
+			LOCK(h);
+		else if (!TRY_LOCK(h))
+			continue;
+
+		/* Someone else may have emptied it in the meantime. */
+		if (h->n)
+			break;
+
+		UNLOCK(h);
+	}
+
+	e = heap_pop(h);
+	SET_TOP(h);
+
+	UNLOCK(h);
+
+	*key = e.key;
+
+	if (value)
+		*value = e.value;
+
+	return 1;
+}
+
+void mqueue_destroy(struct mqueue *q)
+{
+	int i;
+
+	for (i = 0; i < q->n; i++)
+		free(q->heaps[i].elems);
+
+	free(q->heaps);
+	free(q);
+}
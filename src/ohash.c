@@ -0,0 +1,193 @@
+#include "ohash.h"
+
+#define NODE(x) container_of(x, struct ohash_node, tree)
+
+/* Maps the sentinel of the tree to NULL. */
+static inline struct ohash_node *to_node(struct ohash *oh,
+					 struct rbtree_node *x)
+{
+	return x == oh->tree->nil ? NULL : NODE(x);
+}
+
+/* Doubles the number of buckets. Nodes are moved by their own hash. */
+static void grow(struct ohash *oh)
+{
+	unsigned int i, mask = 2 * oh->mask + 1;
+	struct ohash_node **table, *x, *next;
+
+	table = calloc((size_t) mask + 1, sizeof(struct ohash_node *));
+
+	for (i = 0; i <= oh->mask; i++) {
+		for (x = oh->table[i]; x; x = next) {
+			next = x->next;
+
+			x->next = table[x->hash & mask];
+			table[x->hash & mask] = x;
+		}
+	}
+
+	free(oh->table);
+
+	oh->table = table;
+	oh->mask  = mask;
+
+	STATS_INC(oh->stats, resizes);
+}
+
+/* --- API --- */
+
+/* Allocs. a table with at least sz buckets. */
+struct ohash *make_ohash(int sz, hash_fn fn, ohash_cmp cmp)
+{
+	struct ohash *oh;
+	unsigned int slots = 1;
+
+	if (!fn || !cmp)
+		return NULL;
+
+	while (slots < (unsigned int) sz)
+		slots <<= 1;
+
+	oh = malloc(sizeof(struct ohash));
+
+	oh->table = calloc(slots, sizeof(struct ohash_node *));
+	oh->mask  = slots - 1;
+	oh->tree  = make_rbtree(cmp);
+	oh->fn    = fn;
+	oh->cmp   = cmp;
+
+	oh->stats = (struct ohash_stats) { 0 };
+
+	return oh;
+}
+
+/* Inserts an entry, whose key should remain valid for as long as it's in the
+ * table. Keys are expected to be unique, so check with ohash_search() first
+ * when they might not be. */
+void ohash_insert(struct ohash *oh, struct ohash_node *x, const void *key)
+{
+	x->tree.value = (void *) key;
+	x->hash       = oh->fn(key);
+
+	if ((unsigned int) oh->tree->n > oh->mask)
+		grow(oh);
+
+	x->next = oh->table[x->hash & oh->mask];
+	oh->table[x->hash & oh->mask] = x;
+
+	rbtree_insert(oh->tree, &x->tree);
+	STATS_INC(oh->stats, inserts);
+}
+
+struct ohash_node *ohash_search(struct ohash *oh, const void *key)
+{
+	unsigned int h = oh->fn(key);
+	struct ohash_node *x;
+
+	STATS_INC(oh->stats, searches);
+
+	for (x = oh->table[h & oh->mask]; x; x = x->next) {
+		if (x->hash != h)
+			continue;
+
+		STATS_INC(oh->stats, probes);
+
+		if (!oh->cmp(key, x->tree.value))
+			return x;
+	}
+
+	STATS_INC(oh->stats, misses);
+
+	return NULL;
+}
+
+/* For range scans: walk on from here with ohash_next() until past the end of
+ * the range. Returns NULL if every key is less than the one given. */
+struct ohash_node *ohash_lower_bound(struct ohash *oh, const void *key)
+{
+	struct rbtree_node *x = oh->tree->root, *y = oh->tree->nil;
+	int cmp;
+
+	while (x != oh->tree->nil) {
+		if ((cmp = oh->cmp(key, x->value)) <= 0) {
+			y = x;
+
+			if (!cmp)
+				break;
+
+			x = x->left;
+		} else {
+			x = x->right;
+		}
+	}
+
+	return to_node(oh, y);
+}
+
+/* The tree can't be asked for the minimum (or maximum) while empty. */
+struct ohash_node *ohash_first(struct ohash *oh)
+{
+	if (!oh->tree->n)
+		return NULL;
+
+	return to_node(oh, rbtree_minimum(oh->tree));
+}
+
+struct ohash_node *ohash_last(struct ohash *oh)
+{
+	if (!oh->tree->n)
+		return NULL;
+
+	return to_node(oh, rbtree_maximum(oh->tree));
+}
+
+struct ohash_node *ohash_next(struct ohash *oh, struct ohash_node *x)
+{
+	return to_node(oh, rbtree_successor(oh->tree, &x->tree));
+}
+
+struct ohash_node *ohash_prev(struct ohash *oh, struct ohash_node *x)
+{
+	return to_node(oh, rbtree_predecessor(oh->tree, &x->tree));
+}
+
+/* The entry is still owned by the caller. */
+void ohash_delete(struct ohash *oh, struct ohash_node *x)
+{
+	struct ohash_node **p = &oh->table[x->hash & oh->mask];
+
+	while (*p != x)
+		p = &(*p)->next;
+
+	*p = x->next;
+
+	rbtree_delete(oh->tree, &x->tree);
+	STATS_INC(oh->stats, deletes);
+}
+
+/* Entries are owned by the caller, so the tree is emptied (without freeing
+ * them) before being destroyed. */
+void ohash_destroy(struct ohash *oh)
+{
+	oh->tree->root = oh->tree->nil;
+
+	rbtree_destroy(oh->tree);
+	free(oh->table);
+	free(oh);
+}
+
+struct ohash_stats ohash_stats_dump(struct ohash *oh, FILE *out)
+{
+	struct ohash_stats s = oh->stats;
+
+	if (out) {
+		STATS_PRINT(out, "ohash", s, inserts);
+		STATS_PRINT(out, "ohash", s, deletes);
+		STATS_PRINT(out, "ohash", s, searches);
+		STATS_PRINT(out, "ohash", s, misses);
+		STATS_PRINT(out, "ohash", s, probes);
+		STATS_PRINT(out, "ohash", s, resizes);
+	}
+
+	return s;
+}
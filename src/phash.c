@@ -0,0 +1,348 @@
+#include <stdint.h>             // For SIZE_MAX.
+#include <stdlib.h>             // For malloc() and qsort().
+#include <string.h>             // For memset().
+
+#include "hashfn.h"
+#include "phash.h"
+
+#define MAX_PILOT   UINT16_MAX
+#define MAX_SEEDS   16          // Attempts before giving up on a set of keys.
+
+/* Keys with hashes below this (60% of them) go to the dense buckets (30% of
+ * them), which get placed first, while the table is mostly empty. */
+#define DENSE_HASH  (UINT64_MAX / 10 * 6)
+#define DENSE_PCT   30
+
+struct key {
+	uint64_t         h;
+	uint32_t         bucket;
+	uint32_t         pos;
+	struct list_head *entry;
+};
+
+static inline uint32_t bucket_of(const struct phash_hdr *hdr, uint64_t h)
+{
+	if (h < DENSE_HASH)
+		return hash_range((uint32_t) h, hdr->ndense);
+
+	return hdr->ndense + hash_range((uint32_t) h,
+					hdr->nbuckets - hdr->ndense);
+}
+
+/* Pilots are spread over the whole word before being mixed with the hash, so
+ * that consecutive ones yield unrelated positions. */
+static inline uint32_t position(const struct phash_hdr *hdr, uint64_t h,
+				uint32_t pilot)
+{
+	uint64_t x = h ^ (hdr->seed + pilot * 0x9e3779b97f4a7c15ull);
+
+	return hash_range((uint32_t) (hash_mix64(x) >> 32), hdr->m);
+}
+
+static int cmp_keys(const void *_a, const void *_b)
+{
+	const struct key *a = _a, *b = _b;
+
+	if (a->bucket != b->bucket)
+		return (a->bucket > b->bucket) - (a->bucket < b->bucket);
+
+	return (a->h > b->h) - (a->h < b->h);
+}
+
+#define TAKEN(bits, p)    ((bits)[(p) >> 6] &  (1ull << ((p) & 63)))
+#define SET_TAKEN(bits, p) (bits)[(p) >> 6] |= (1ull << ((p) & 63))
+
+/* Searches for a pilot placing all the keys of a bucket in free slots. */
+static int place_bucket(struct phash_hdr *hdr, uint16_t *pilots,
+			uint64_t *taken, struct key *k, uint32_t sz)
+{
+	uint32_t pilot, i, j;
+
+	for (pilot = 0; pilot <= MAX_PILOT; pilot++) {
+		for (i = 0; i < sz; i++) {
+			k[i].pos = position(hdr, k[i].h, pilot);
+
+			if (TAKEN(taken, k[i].pos))
+				break;
+
+			for (j = 0; j < i && k[j].pos != k[i].pos; j++)
+				;
+			if (j < i)
+				break;
+		}
+
+		if (i == sz) {
+			for (i = 0; i < sz; i++)
+				SET_TAKEN(taken, k[i].pos);
+
+			pilots[k[0].bucket] = pilot;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Places buckets largest first. Returns zero if some bucket couldn't be. */
+static int place(struct phash_hdr *hdr, uint16_t *pilots, struct key *keys)
+{
+	uint32_t *start, *order, *count, i, b, sz, max = 0;
+	uint64_t *taken;
+	int ret = 1;
+
+	start = calloc(hdr->nbuckets + 1, sizeof(uint32_t));
+	order = malloc(hdr->nbuckets * sizeof(uint32_t));
+	taken = calloc(hdr->m / 64 + 1, sizeof(uint64_t));
+
+	for (i = 0; i < hdr->n; i++)
+		start[keys[i].bucket + 1]++;
+
+	for (b = 0; b < hdr->nbuckets; b++) {
+		max = start[b + 1] > max ? start[b + 1] : max;
+		start[b + 1] += start[b];
+	}
+
+	/* Counting sort of the buckets by decreasing size. */
+	count = calloc(max + 2, sizeof(uint32_t));
+
+	for (b = 0; b < hdr->nbuckets; b++)
+		count[max - (start[b + 1] - start[b]) + 1]++;
+
+	for (sz = 0; sz <= max; sz++)
+		count[sz + 1] += count[sz];
+
+	for (b = 0; b < hdr->nbuckets; b++)
+		order[count[max - (start[b + 1] - start[b])]++] = b;
+
+	for (i = 0; i < hdr->nbuckets && ret; i++) {
+		b  = order[i];
+		sz = start[b + 1] - start[b];
+
+		if (!sz)
+			break;  // The rest are empty too.
+
+		ret = place_bucket(hdr, pilots, taken, keys + start[b], sz);
+	}
+
+	free(start);
+	free(order);
+	free(count);
+	free(taken);
+
+	return ret;
+}
+
+/* See image_valid. Record offsets are only covered by the checksum. */
+static int valid(const struct image_hdr *img)
+{
+	const struct phash_hdr *hdr = (const struct phash_hdr *) img;
+	uint64_t m = hdr->m, n = hdr->n, stride = hdr->stride;
+
+	return hdr->img.size >= sizeof(struct phash_hdr) &&
+	       hdr->pilots >= sizeof(struct phash_hdr) &&
+	       !(hdr->pilots % 8) && !(hdr->remap % 4) && !(hdr->recs % 8) &&
+	       m >= n && (n || !m) && hdr->ndense < hdr->nbuckets &&
+	       hdr->remap >= hdr->pilots + hdr->nbuckets * 2ull &&
+	       hdr->offs == hdr->remap + (m - n) * 4 &&
+	       hdr->recs >= hdr->offs + (stride ? 0 : n * 4) &&
+	       hdr->img.size >= hdr->recs + n * stride;
+}
+
+static struct phash *wrap(struct phash_hdr *hdr, phash_fn fn, phash_cmp cmp,
+			  int mapped)
+{
+	struct phash *f = malloc(sizeof(struct phash));
+	char *base = (char *) hdr;
+
+	f->hdr    = hdr;
+	f->pilots = (const uint16_t *) (base + hdr->pilots);
+	f->remap  = (const uint32_t *) (base + hdr->remap);
+	f->offs   = (const uint32_t *) (base + hdr->offs);
+	f->recs   = base + hdr->recs;
+	f->fn     = fn;
+	f->cmp    = cmp;
+	f->mapped = mapped;
+
+	return f;
+}
+
+/* --- API --- */
+
+/* Returns NULL if two keys hash the same (e.g. duplicates), or if records take
+ * 4 GB or more. The hash table is left as it was. */
+struct phash *hash_freeze(struct hash_table *ht, phash_key key, phash_fn fn,
+			  phash_pack pack, phash_cmp cmp)
+{
+	struct phash_hdr h = { 0 }, *hdr;
+	struct list_head *pos;
+	struct key *keys;
+	uint16_t *pilots;
+	uint32_t *remap, *offs, i, p, hole;
+	size_t n = 0, recs_sz = 0, sz, stride = 0, size;
+	int seeds;
+
+	for (i = 0; i < (uint32_t) ht->sz; i++)
+		list_for_each(pos, &ht->table[i])
+			n++;
+
+	keys = malloc((n + 1) * sizeof(struct key));
+	n    = 0;
+
+	for (i = 0; i < (uint32_t) ht->sz; i++) {
+		list_for_each(pos, &ht->table[i]) {
+			sz = IMAGE_ALIGN(pack(pos, NULL), 8);
+
+			keys[n].entry = pos;
+			keys[n].h     = fn(key(pos));
+			stride        = !n || sz == stride ? sz : SIZE_MAX;
+			recs_sz      += sz;
+			n++;
+		}
+	}
+
+	if (recs_sz > UINT32_MAX)
+		goto fail;
+
+	/* Records of equal sizes are found by position, with no offsets. */
+	h.stride = stride == SIZE_MAX ? 0 : stride;
+
+	h.n        = n;
+	h.m        = n ? (uint32_t) ((n * 100 + PHASH_ALPHA - 1) / PHASH_ALPHA) : 0;
+	h.nbuckets = n / PHASH_LAMBDA + 1;
+	h.ndense   = h.nbuckets * DENSE_PCT / 100 + 1;
+	h.nbuckets = h.nbuckets > h.ndense ? h.nbuckets : h.ndense + 1;
+
+	h.pilots = IMAGE_ALIGN(sizeof(struct phash_hdr), 8);
+	h.remap  = IMAGE_ALIGN(h.pilots + h.nbuckets * sizeof(uint16_t), 4);
+	h.offs   = h.remap + (h.m - h.n) * sizeof(uint32_t);
+	h.recs   = IMAGE_ALIGN(h.offs + (h.stride ? 0 : h.n) * sizeof(uint32_t),
+			       8);
+	size     = h.recs + recs_sz;
+
+	for (i = 0; i < n; i++)
+		keys[i].bucket = bucket_of(&h, keys[i].h);
+
+	qsort(keys, n, sizeof(struct key), cmp_keys);
+
+	for (i = 1; i < n; i++)
+		if (keys[i].h == keys[i - 1].h)
+			goto fail;
+
+	/* Room for the offsets is needed while placing records, regardless. */
+	hdr    = calloc(1, size + h.n * sizeof(uint32_t));
+	pilots = (uint16_t *) ((char *) hdr + h.pilots);
+	remap  = (uint32_t *) ((char *) hdr + h.remap);
+	offs   = h.stride ? (uint32_t *) ((char *) hdr + size) :
+			    (uint32_t *) ((char *) hdr + h.offs);
+
+	for (seeds = 0; seeds < MAX_SEEDS; seeds++) {
+		h.seed = hash_mix64(seeds);
+		memset(pilots, 0, h.nbuckets * sizeof(uint16_t));
+
+		if (place(&h, pilots, keys))
+			break;
+	}
+
+	if (seeds == MAX_SEEDS) {
+		free(hdr);
+		goto fail;
+	}
+
+	*hdr = h;
+
+	/* Positions past n are sent to the holes below n, in order. */
+	for (i = 0; i < n; i++)
+		if (keys[i].pos < n)
+			offs[keys[i].pos] = 1;
+
+	for (i = 0, hole = 0; i < n; i++) {
+		if (keys[i].pos < n)
+			continue;
+
+		while (offs[hole])
+			hole++;
+
+		offs[hole]             = 1;
+		remap[keys[i].pos - n] = hole;
+		keys[i].pos            = hole;
+	}
+
+	/* Records are written in position order, so that neighbouring slots
+	 * have neighbouring records. */
+	for (i = 0; i < n; i++)
+		offs[keys[i].pos] = i;
+
+	for (p = 0, sz = 0; p < n; p++) {
+		i       = offs[p];
+		offs[p] = sz;
+		sz     += IMAGE_ALIGN(pack(keys[i].entry,
+					    (char *) hdr + h.recs + sz), 8);
+	}
+
+	free(keys);
+
+	image_seal(&hdr->img, PHASH_MAGIC, PHASH_VERSION, size);
+
+	return wrap(hdr, fn, cmp, 0);
+
+fail:
+	free(keys);
+
+	return NULL;
+}
+
+/* Returns the record of the key, or NULL if it isn't in the table. */
+const void *phash_search(struct phash *f, const void *key)
+{
+	const struct phash_hdr *hdr = f->hdr;
+	uint64_t h;
+	uint32_t p;
+	const char *rec;
+
+	if (!hdr->n)
+		return NULL;
+
+	h = f->fn(key);
+	p = position(hdr, h, f->pilots[bucket_of(hdr, h)]);
+
+	if (p >= hdr->n)
+		p = f->remap[p - hdr->n];
+
+	if (hdr->stride)
+		rec = f->recs + (size_t) p * hdr->stride;
+	else
+		rec = f->recs + f->offs[p];
+
+	return f->cmp(rec, key) ? rec : NULL;
+}
+
+size_t phash_size(struct phash *f)
+{
+	return f->hdr->img.size;
+}
+
+/* Returns zero, or -1 with errno set. */
+int phash_save(struct phash *f, const char *path)
+{
+	return image_save(&f->hdr->img, path);
+}
+
+/* Maps in a table saved by phash_save(), which must be given the same hash
+ * function it was frozen with (and a matching comparison function.) Takes
+ * constant time, unless verify is set, in which case the checksum is checked.
+ * Returns NULL, with errno set, if the file can't be loaded. */
+struct phash *phash_load(const char *path, phash_fn fn, phash_cmp cmp,
+			 int verify)
+{
+	struct image_hdr *img;
+
+	img = image_load(path, PHASH_MAGIC, PHASH_VERSION, verify, valid);
+
+	return img ? wrap((struct phash_hdr *) img, fn, cmp, 1) : NULL;
+}
+
+void phash_destroy(struct phash *f)
+{
+	image_destroy(&f->hdr->img, f->mapped);
+	free(f);
+}
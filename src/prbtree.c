@@ -0,0 +1,370 @@
+#include "prbtree.h"
+#include "ebr.h"
+
+#define IS_RED(_node) ((_node) && (_node)->color == RED)
+
+#define FLIP(_color)  ((_color) == RED ? BLACK : RED)
+
+/* Defers the deallocation of a node replaced by the write in progress. Nodes
+ * created by the write itself were never published, and are freed at once. */
+static void drop(struct prbtree *t, struct prbtree_node *x)
+{
+	if (x->version == t->version) {
+		free(x);
+		return;
+	}
+
+	if (t->ngarbage == t->szgarbage) {
+		t->szgarbage = t->szgarbage ? 2 * t->szgarbage : 64;
+		t->garbage   = realloc(t->garbage, t->szgarbage *
+				       sizeof(struct prbtree_node *));
+	}
+
+	t->garbage[t->ngarbage++] = x;
+}
+
+/* Returns a node that may be modified by the write in progress: either _x_
+ * itself, if it was created by it, or a copy of it. */
+static struct prbtree_node *cow(struct prbtree *t, struct prbtree_node *x)
+{
+	struct prbtree_node *y;
+
+	if (!x || x->version == t->version)
+		return x;
+
+	y = malloc(sizeof(struct prbtree_node));
+	*y = *x;
+	y->version = t->version;
+
+	drop(t, x);
+
+	return y;
+}
+
+static struct prbtree_node *make_prbtree_node(struct prbtree *t, void *value)
+{
+	struct prbtree_node *node = malloc(sizeof(struct prbtree_node));
+
+	node->left    = NULL;
+	node->right   = NULL;
+	node->value   = value;
+	node->color   = RED;
+	node->version = t->version;
+
+	return node;
+}
+
+/* The helpers below expect _h_ to be modifiable, and return a modifiable node;
+ * they copy whatever other node they modify. */
+
+static struct prbtree_node *rotate_left(struct prbtree *t,
+					struct prbtree_node *h)
+{
+	struct prbtree_node *x = cow(t, h->right);
+
+	h->right = x->left;
+	x->left  = h;
+	x->color = h->color;
+	h->color = RED;
+
+	return x;
+}
+
+static struct prbtree_node *rotate_right(struct prbtree *t,
+					 struct prbtree_node *h)
+{
+	struct prbtree_node *x = cow(t, h->left);
+
+	h->left  = x->right;
+	x->right = h;
+	x->color = h->color;
+	h->color = RED;
+
+	return x;
+}
+
+static void flip_colors(struct prbtree *t, struct prbtree_node *h)
+{
+	h->left  = cow(t, h->left);
+	h->right = cow(t, h->right);
+
+	h->color        = FLIP(h->color);
+	h->left->color  = FLIP(h->left->color);
+	h->right->color = FLIP(h->right->color);
+}
+
+static struct prbtree_node *balance(struct prbtree *t, struct prbtree_node *h)
+{
+	if (IS_RED(h->right) && !IS_RED(h->left))
+		h = rotate_left(t, h);
+
+	if (IS_RED(h->left) && IS_RED(h->left->left))
+		h = rotate_right(t, h);
+
+	if (IS_RED(h->left) && IS_RED(h->right))
+		flip_colors(t, h);
+
+	return h;
+}
+
+static struct prbtree_node *move_red_left(struct prbtree *t,
+					  struct prbtree_node *h)
+{
+	flip_colors(t, h);
+
+	if (IS_RED(h->right->left)) {
+		h->right = rotate_right(t, h->right);
+		h        = rotate_left(t, h);
+		flip_colors(t, h);
+	}
+
+	return h;
+}
+
+static struct prbtree_node *move_red_right(struct prbtree *t,
+					   struct prbtree_node *h)
+{
+	flip_colors(t, h);
+
+	if (IS_RED(h->left->left)) {
+		h = rotate_right(t, h);
+		flip_colors(t, h);
+	}
+
+	return h;
+}
+
+static struct prbtree_node *insert(struct prbtree *t, struct prbtree_node *h,
+				   void *value)
+{
+	if (!h)
+		return make_prbtree_node(t, value);
+
+	h = cow(t, h);
+
+	if (t->cmp(value, h->value) < 0)
+		h->left = insert(t, h->left, value);
+	else
+		h->right = insert(t, h->right, value);
+
+	return balance(t, h);
+}
+
+static struct prbtree_node *delete_min(struct prbtree *t,
+				       struct prbtree_node *h)
+{
+	h = cow(t, h);
+
+	if (!h->left) {
+		drop(t, h);
+		return NULL;
+	}
+
+	if (!IS_RED(h->left) && !IS_RED(h->left->left))
+		h = move_red_left(t, h);
+
+	h->left = delete_min(t, h->left);
+
+	return balance(t, h);
+}
+
+/* The value is known to be in the tree. */
+static struct prbtree_node *delete(struct prbtree *t, struct prbtree_node *h,
+				   const void *value)
+{
+	struct prbtree_node *x;
+
+	h = cow(t, h);
+
+	if (t->cmp(value, h->value) < 0) {
+		if (!IS_RED(h->left) && !IS_RED(h->left->left))
+			h = move_red_left(t, h);
+
+		h->left = delete(t, h->left, value);
+	} else {
+		if (IS_RED(h->left))
+			h = rotate_right(t, h);
+
+		if (!t->cmp(value, h->value) && !h->right) {
+			drop(t, h);
+			return NULL;
+		}
+
+		if (!IS_RED(h->right) && !IS_RED(h->right->left))
+			h = move_red_right(t, h);
+
+		if (!t->cmp(value, h->value)) {
+			/* Take the place of the successor, then delete it. */
+			for (x = h->right; x->left; x = x->left)
+				;
+
+			h->value = x->value;
+			h->right = delete_min(t, h->right);
+		} else {
+			h->right = delete(t, h->right, value);
+		}
+	}
+
+	return balance(t, h);
+}
+
+static void *search(struct prbtree *t, const struct prbtree_node *x,
+		    const void *value)
+{
+	int cmp;
+
+	while (x) {
+		if ((cmp = t->cmp(value, x->value)) < 0)
+			x = x->left;
+		else if (cmp > 0)
+			x = x->right;
+		else
+			return x->value;
+	}
+
+	return NULL;
+}
+
+/* Makes the new root visible to readers, then retires the nodes it replaced,
+ * which readers holding older snapshots may still be traversing. */
+static void publish(struct prbtree *t, struct prbtree_node *root)
+{
+	int i;
+
+	if (root)
+		root->color = BLACK;
+
+	__atomic_store_n(&t->root, root, __ATOMIC_RELEASE);
+
+	ebr_enter();
+
+	for (i = 0; i < t->ngarbage; i++)
+		ebr_retire(t->garbage[i], free);
+
+	ebr_exit();
+
+	t->ngarbage = 0;
+}
+
+static void __prbtree_destroy(struct prbtree_node *x)
+{
+	if (x) {
+		__prbtree_destroy(x->left);
+		__prbtree_destroy(x->right);
+		free(x);
+	}
+}
+
+/* --- API --- */
+
+struct prbtree *make_prbtree(rbtree_cmp cmp)
+{
+	struct prbtree *tree = malloc(sizeof(struct prbtree));
+
+	tree->root = NULL;
+	tree->cmp  = cmp;
+	tree->n    = 0;
+
+	pthread_mutex_init(&tree->lock, NULL);
+	tree->version = 0;
+
+	tree->garbage   = NULL;
+	tree->ngarbage  = 0;
+	tree->szgarbage = 0;
+
+	return tree;
+}
+
+/* Returns the root of the latest version. The snapshot stays valid until the
+ * calling thread releases it, and snapshots may be nested. */
+const struct prbtree_node *prbtree_snapshot(struct prbtree *t)
+{
+	ebr_enter();
+
+	return __atomic_load_n(&t->root, __ATOMIC_ACQUIRE);
+}
+
+void prbtree_release(void)
+{
+	ebr_exit();
+}
+
+void *prbtree_snapshot_search(struct prbtree *t, const struct prbtree_node *s,
+			      const void *value)
+{
+	return search(t, s, value);
+}
+
+void prbtree_snapshot_walk(const struct prbtree_node *s, prbtree_visit visit)
+{
+	if (!s)
+		return;
+
+	prbtree_snapshot_walk(s->left, visit);
+	visit(s->value);
+	prbtree_snapshot_walk(s->right, visit);
+}
+
+/* Returns the value equal to _value_ in the latest version, or NULL. */
+void *prbtree_search(struct prbtree *t, const void *value)
+{
+	void *ret = search(t, prbtree_snapshot(t), value);
+
+	prbtree_release();
+
+	return ret;
+}
+
+/* Returns zero if an equal value was already in. */
+int prbtree_insert(struct prbtree *t, void *value)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&t->lock);
+
+	if (!search(t, t->root, value)) {
+		t->version++;
+		publish(t, insert(t, t->root, value));
+		t->n++;
+		ret = 1;
+	}
+
+	pthread_mutex_unlock(&t->lock);
+
+	return ret;
+}
+
+/* Returns the value deleted, or NULL. */
+void *prbtree_delete(struct prbtree *t, const void *value)
+{
+	struct prbtree_node *root;
+	void *ret;
+
+	pthread_mutex_lock(&t->lock);
+
+	if ((ret = search(t, t->root, value))) {
+		t->version++;
+		root = t->root;
+
+		if (!IS_RED(root->left) && !IS_RED(root->right)) {
+			root = cow(t, root);
+			root->color = RED;
+		}
+
+		publish(t, delete(t, root, value));
+		t->n--;
+	}
+
+	pthread_mutex_unlock(&t->lock);
+
+	return ret;
+}
+
+/* Must not run concurrently with any other op. */
+void prbtree_destroy(struct prbtree *t)
+{
+	__prbtree_destroy(t->root);
+	pthread_mutex_destroy(&t->lock);
+	free(t->garbage);
+	free(t);
+}
@@ -0,0 +1,128 @@
+#include "radixheap.h"
+
+#define INSERT_INTO_BUCKET(_heap, _node)                                        \
+	list_add(&(_node)->list, &(_heap)->bucket[(_node)->bucket])
+
+#define REMOVE_FROM_BUCKET(_node)                                               \
+	list_del(&(_node)->list)
+
+/* Index of the bucket for _key_: 0 if it equals _last_, else one plus the most
+ * significant bit in which they differ. */
+static inline int bucket_of(radixheap_key key, radixheap_key last)
+{
+	radixheap_key diff = key ^ last;
+
+	return diff ? (int) (sizeof(radixheap_key) * 8) -
+		__builtin_clzll(diff) : 0;
+}
+
+/* Refills bucket 0, by taking the minimal key of the first non-empty bucket
+ * as the last one extracted, and moving the nodes in it to lower buckets. */
+static inline void redistribute(struct radixheap *h)
+{
+	struct radixheap_node *x, *next;
+	radixheap_key min;
+	int i;
+
+	for (i = 1; list_empty(&h->bucket[i]); i++)
+		;
+
+	min = list_first_entry(&h->bucket[i], struct radixheap_node, list)->key;
+
+	list_for_each_entry(x, &h->bucket[i], list)
+		if (x->key < min)
+			min = x->key;
+
+	h->last = min;
+
+	list_for_each_entry_safe(x, next, &h->bucket[i], list) {
+		REMOVE_FROM_BUCKET(x);
+		x->bucket = bucket_of(x->key, min);
+		INSERT_INTO_BUCKET(h, x);
+	}
+}
+
+/* --- API --- */
+
+struct radixheap *make_radixheap(void)
+{
+	struct radixheap *heap = malloc(sizeof(struct radixheap));
+	unsigned int i;
+
+	for (i = 0; i < RADIXHEAP_BUCKETS; i++)
+		INIT_LIST_HEAD(&heap->bucket[i]);
+
+	heap->last = 0;
+	heap->n    = 0;
+
+	return heap;
+}
+
+struct radixheap_node *make_radixheap_node(radixheap_key key, void *value)
+{
+	struct radixheap_node *node = malloc(sizeof(struct radixheap_node));
+
+	INIT_LIST_HEAD(&node->list);
+
+	node->key    = key;
+	node->bucket = 0;
+	node->value  = value;
+
+	return node;
+}
+
+int radixheap_is_empty(struct radixheap *h)
+{
+	return !h->n;
+}
+
+/* The key of _x_ must not be smaller than the last one extracted. */
+void radixheap_insert(struct radixheap *h, struct radixheap_node *x)
+{
+	x->bucket = bucket_of(x->key, h->last);
+	INSERT_INTO_BUCKET(h, x);
+
+	h->n++;
+}
+
+struct radixheap_node *radixheap_minimum(struct radixheap *h)
+{
+	if (radixheap_is_empty(h))
+		return NULL;
+
+	if (list_empty(&h->bucket[0]))
+		redistribute(h);
+
+	return list_first_entry(&h->bucket[0], struct radixheap_node, list);
+}
+
+struct radixheap_node *radixheap_extract_min(struct radixheap *h)
+{
+	struct radixheap_node *z = radixheap_minimum(h);
+
+	if (z) {
+		REMOVE_FROM_BUCKET(z);
+		h->n--;
+	}
+
+	return z;
+}
+
+/* Unlike fibheap_decrease(), the new key is given, as the heap has to know it
+ * for picking the new bucket. It must not be smaller than the last key
+ * extracted. */
+void radixheap_decrease(struct radixheap *h, struct radixheap_node *x,
+			radixheap_key key)
+{
+	x->key = key;
+
+	REMOVE_FROM_BUCKET(x);
+	x->bucket = bucket_of(key, h->last);
+	INSERT_INTO_BUCKET(h, x);
+}
+
+void radixheap_delete(struct radixheap *h, struct radixheap_node *x)
+{
+	REMOVE_FROM_BUCKET(x);
+	h->n--;
+}
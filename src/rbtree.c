@@ -1,5 +1,9 @@
 #include "rbtree.h"
 
+/* Compares two values, counting the comparison. */
+#define CMP(_tree, a, b)                                                        \
+	(STATS_INC((_tree)->stats, comparisons), (_tree)->cmp((a), (b)))
+
 #define ROTATE(_tree, x, dir, opp)                                              \
                                                                                 \
 	do {                                                                    \
@@ -120,11 +124,13 @@ static inline struct rbtree_node *make_rbtree_sentinel()
 
 static inline void rotate_left(struct rbtree *t, struct rbtree_node *x)
 {
+	STATS_INC(t->stats, rotations);
 	ROTATE_LEFT(t, x);
 }
 
 static inline void rotate_right(struct rbtree *t, struct rbtree_node *x)
 {
+	STATS_INC(t->stats, rotations);
 	ROTATE_RIGHT(t, x);
 }
 
@@ -132,11 +138,14 @@ static inline void insert_fixup(struct rbtree *t, struct rbtree_node *z)
 {
 	struct rbtree_node *y;
 
-	while (z->parent->color == RED)
+	while (z->parent->color == RED) {
+		STATS_INC(t->stats, insert_fixups);
+
 		if (z->parent == z->parent->parent->left)
 			INSERT_FIXUP(t, y, z, right, left);
 		else
 			INSERT_FIXUP(t, y, z, left, right);
+	}
 
 	t->root->color = BLACK;
 }
@@ -145,11 +154,14 @@ static inline void delete_fixup(struct rbtree *t, struct rbtree_node *x)
 {
 	struct rbtree_node *w;
 
-	while (x != t->root && x->color == BLACK)
+	while (x != t->root && x->color == BLACK) {
+		STATS_INC(t->stats, delete_fixups);
+
 		if (x == x->parent->left)
 			DELETE_FIXUP(t, w, x, left, right);
 		else
 			DELETE_FIXUP(t, w, x, right, left);
+	}
 
 	x->color = BLACK;
 }
@@ -178,7 +190,7 @@ static inline struct rbtree_node *__rbtree_search(
 	int cmp;
 
 	while (x != t->nil) {
-		if ((cmp = t->cmp(x->value, value)) < 0)
+		if ((cmp = CMP(t, value, x->value)) < 0)
 			x = x->left;
 		else if (cmp > 0)
 			x = x->right;
@@ -256,10 +268,14 @@ struct rbtree *make_rbtree(rbtree_cmp cmp)
 {
 	struct rbtree *tree = malloc(sizeof(struct rbtree));
 
-	tree->nil  = make_rbtree_sentinel();
-	tree->root = tree->nil;
-	tree->cmp  = cmp;
-	tree->n    = 0;
+	tree->nil    = make_rbtree_sentinel();
+	tree->root   = tree->nil;
+	tree->cmp    = cmp;
+	tree->n      = 0;
+	tree->filter = NULL;
+	tree->hash   = NULL;
+
+	tree->stats = (struct rbtree_stats) { 0 };
 
 	return tree;
 }
@@ -283,6 +299,13 @@ struct rbtree_node *make_rbtree_node(void *value)
  * this should be enough for now. */
 struct rbtree_node *rbtree_search(struct rbtree *t, void *value)
 {
+	STATS_INC(t->stats, searches);
+
+	if (t->filter && !filter_test(t->filter, t->hash(value))) {
+		STATS_INC(t->stats, filtered);
+		return t->nil;
+	}
+
 	return __rbtree_search(t, t->root, value);
 }
 
@@ -334,7 +357,7 @@ void rbtree_insert(struct rbtree *t, struct rbtree_node *z)
 	while (x != t->nil) {
 		y = x;
 
-		if (t->cmp(z->value, x->value) < 0)
+		if (CMP(t, z->value, x->value) < 0)
 			x = x->left;
 		else
 			x = x->right;
@@ -344,7 +367,7 @@ void rbtree_insert(struct rbtree *t, struct rbtree_node *z)
 
 	if (y == t->nil)
 		t->root = z;
-	else if (t->cmp(z->value, y->value) < 0)
+	else if (CMP(t, z->value, y->value) < 0)
 		y->left = z;
 	else
 		y->right = z;
@@ -355,7 +378,12 @@ void rbtree_insert(struct rbtree *t, struct rbtree_node *z)
 
 	insert_fixup(t, z);
 
+	/* A value missing from the filter would never be found again. */
+	if (t->filter && !filter_add(t->filter, t->hash(z->value)))
+		t->filter = NULL;
+
 	t->n++;
+	STATS_INC(t->stats, inserts);
 }
 
 void rbtree_delete(struct rbtree *t, struct rbtree_node *z)
@@ -393,7 +421,20 @@ void rbtree_delete(struct rbtree *t, struct rbtree_node *z)
 	if (y_color == BLACK)
 		delete_fixup(t, x);
 
+	if (t->filter)
+		filter_del(t->filter, t->hash(z->value));
+
 	t->n--;
+	STATS_INC(t->stats, deletes);
+}
+
+/* Values already in the tree aren't added to the filter, so it should be
+ * attached before the first insertion. Only cuckoo filters forget the values
+ * of deleted nodes. The filter is still owned (and freed) by the caller. */
+void rbtree_attach_filter(struct rbtree *t, struct filter *f, filter_hash hash)
+{
+	t->filter = f;
+	t->hash   = hash;
 }
 
 /* Recursive destruction. */
@@ -403,3 +444,21 @@ void rbtree_destroy(struct rbtree *t)
 	free(t->nil);
 	free(t);
 }
+
+struct rbtree_stats rbtree_stats_dump(struct rbtree *t, FILE *out)
+{
+	struct rbtree_stats s = t->stats;
+
+	if (out) {
+		STATS_PRINT(out, "rbtree", s, inserts);
+		STATS_PRINT(out, "rbtree", s, deletes);
+		STATS_PRINT(out, "rbtree", s, searches);
+		STATS_PRINT(out, "rbtree", s, comparisons);
+		STATS_PRINT(out, "rbtree", s, rotations);
+		STATS_PRINT(out, "rbtree", s, insert_fixups);
+		STATS_PRINT(out, "rbtree", s, delete_fixups);
+		STATS_PRINT(out, "rbtree", s, filtered);
+	}
+
+	return s;
+}
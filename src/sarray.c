@@ -0,0 +1,556 @@
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For memcmp() and memcpy().
+
+#include "sarray.h"
+
+/* Rows of the Burrows-Wheeler matrix between two counts of the FM-index. */
+#define OCC_RATE    256
+#define NO_COL      0xffff
+
+#define EMPTY       (-1)
+
+/* Types of suffixes, in a bit array (zeroed to begin with): S-suffixes are
+ * less than the next one, L-suffixes greater. */
+#define IS_S(t, i)   (((t)[(i) >> 3] >> ((i) & 7)) & 1)
+#define SET_S(t, i)  ((t)[(i) >> 3] |= 1 << ((i) & 7))
+#define IS_LMS(t, i) ((i) > 0 && IS_S(t, i) && !IS_S(t, (i) - 1))
+
+/* A string being sorted: either the text, followed by a sentinel that's less
+ * than any byte (which is why bytes are shifted up by one), or the shorter
+ * string of an inner level, which ends with its own sentinel. */
+struct str {
+	const void *s;
+	int32_t    n;
+	int        text;
+};
+
+static inline int32_t chr(const struct str *s, int32_t i)
+{
+	if (!s->text)
+		return ((const int32_t *) s->s)[i];
+
+	return i == s->n - 1 ? 0 : ((const unsigned char *) s->s)[i] + 1;
+}
+
+/* Finds the start (or the end) of the bucket of each char, up to k. */
+static void buckets(const struct str *s, int32_t *bkt, int32_t k, int end)
+{
+	int32_t i, c, sum = 0;
+
+	memset(bkt, 0, (k + 1) * sizeof(int32_t));
+
+	for (i = 0; i < s->n; i++)
+		bkt[chr(s, i)]++;
+
+	for (i = 0; i <= k; i++) {
+		c      = bkt[i];
+		sum   += c;
+		bkt[i] = end ? sum : sum - c;
+	}
+}
+
+/* Sorts the L-suffixes from the sorted LMS-suffixes, left to right, then the
+ * S-suffixes from the L-suffixes, right to left. */
+static void induce(const struct str *s, const unsigned char *t, int32_t *sa,
+		   int32_t *bkt, int32_t k)
+{
+	int32_t i, j;
+
+	buckets(s, bkt, k, 0);
+
+	for (i = 0; i < s->n; i++)
+		if ((j = sa[i] - 1) >= 0 && !IS_S(t, j))
+			sa[bkt[chr(s, j)]++] = j;
+
+	buckets(s, bkt, k, 1);
+
+	for (i = s->n - 1; i >= 0; i--)
+		if ((j = sa[i] - 1) >= 0 && IS_S(t, j))
+			sa[--bkt[chr(s, j)]] = j;
+}
+
+/* Tells whether the LMS-substrings (from an LMS position up to the next one)
+ * at a and b differ. */
+static int lms_differ(const struct str *s, const unsigned char *t, int32_t a,
+		      int32_t b)
+{
+	int32_t d;
+
+	for (d = 0; d < s->n; d++) {
+		if (chr(s, a + d) != chr(s, b + d) ||
+		    IS_S(t, a + d) != IS_S(t, b + d))
+			return 1;
+
+		if (d && (IS_LMS(t, a + d) || IS_LMS(t, b + d)))
+			return 0;
+	}
+
+	return 0;
+}
+
+/* SA-IS, on a string of at least 2 chars., the sentinel included, going up to
+ * k. The reduced string is kept in the upper half of the array, which
+ * is where the names of the LMS-substrings are put. */
+static void sais(const struct str *s, int32_t *sa, int32_t k)
+{
+	int32_t i, j, n = s->n, n1 = 0, name = 0, prev = EMPTY, *bkt, *s1;
+	unsigned char *t = calloc(n / 8 + 1, 1);
+	struct str r;
+
+	SET_S(t, n - 1);
+
+	for (i = n - 3; i >= 0; i--)
+		if (chr(s, i) < chr(s, i + 1) ||
+		    (chr(s, i) == chr(s, i + 1) && IS_S(t, i + 1)))
+			SET_S(t, i);
+
+	/* Sorts the LMS-substrings. */
+	bkt = malloc((k + 1) * sizeof(int32_t));
+	buckets(s, bkt, k, 1);
+
+	for (i = 0; i < n; i++)
+		sa[i] = EMPTY;
+
+	for (i = 1; i < n; i++)
+		if (IS_LMS(t, i))
+			sa[--bkt[chr(s, i)]] = i;
+
+	induce(s, t, sa, bkt, k);
+
+	/* Names them by rank, equal substrings getting the same name. There's at
+	 * most one LMS position every 2 chars., so the names fit in the upper
+	 * half, by position / 2. */
+	for (i = 0; i < n; i++)
+		if (IS_LMS(t, sa[i]))
+			sa[n1++] = sa[i];
+
+	for (i = n1; i < n; i++)
+		sa[i] = EMPTY;
+
+	for (i = 0; i < n1; i++) {
+		if (prev == EMPTY || lms_differ(s, t, sa[i], prev)) {
+			name++;
+			prev = sa[i];
+		}
+
+		sa[n1 + sa[i] / 2] = name - 1;
+	}
+
+	for (i = j = n - 1; i >= n1; i--)
+		if (sa[i] >= 0)
+			sa[j--] = sa[i];
+
+	/* Sorts the suffixes of the reduced string, recursing unless the names
+	 * are all different already. */
+	s1 = sa + n - n1;
+
+	if (name < n1) {
+		r = (struct str) { s1, n1, 0 };
+		sais(&r, sa, name - 1);
+	} else {
+		for (i = 0; i < n1; i++)
+			sa[s1[i]] = i;
+	}
+
+	/* Puts the LMS-suffixes in their buckets in that order, then induces the
+	 * order of the rest. */
+	for (i = 1, j = 0; i < n; i++)
+		if (IS_LMS(t, i))
+			s1[j++] = i;
+
+	for (i = 0; i < n1; i++)
+		sa[i] = s1[sa[i]];
+
+	for (i = n1; i < n; i++)
+		sa[i] = EMPTY;
+
+	buckets(s, bkt, k, 1);
+
+	for (i = n1 - 1; i >= 0; i--) {
+		j     = sa[i];
+		sa[i] = EMPTY;
+		sa[--bkt[chr(s, j)]] = j;
+	}
+
+	induce(s, t, sa, bkt, k);
+
+	free(bkt);
+	free(t);
+}
+
+/* Kasai et al.'s bound, in the order of the text: the LCP of the suffix at i +
+ * 1 is at least that of the one at i, minus one. Phi gives the suffix preceding
+ * each one in the array, and is overwritten by the permuted LCP. */
+static void build_lcp(const unsigned char *text, const uint32_t *sa,
+		      uint32_t *lcp, size_t n)
+{
+	size_t i, j, l = 0;
+	uint32_t *phi;
+
+	if (!n)
+		return;
+
+	phi = malloc(n * sizeof(uint32_t));
+	phi[sa[0]] = n;
+
+	for (i = 1; i < n; i++)
+		phi[sa[i]] = sa[i - 1];
+
+	for (i = 0; i < n; i++) {
+		if ((j = phi[i]) == n) {
+			phi[i] = l = 0;
+			continue;
+		}
+
+		while (i + l < n && j + l < n && text[i + l] == text[j + l])
+			l++;
+
+		phi[i] = l;
+		l     -= !!l;
+	}
+
+	for (i = 0; i < n; i++)
+		lcp[i] = phi[sa[i]];
+
+	free(phi);
+}
+
+/* Rows go from 0 to n, the first being the empty suffix. Counts are taken of
+ * the rows before every OCC_RATE-th one. */
+static void build_fm(struct sarray_hdr *hdr)
+{
+	char *base = (char *) hdr;
+	struct sarray_fm *fm = (struct sarray_fm *) (base + hdr->fm);
+	const uint32_t *sa = (const uint32_t *) (base + hdr->sa);
+	const unsigned char *text = (const unsigned char *) base + hdr->text;
+	uint32_t *occ = (uint32_t *) (base + fm->occ), run[256] = { 0 };
+	unsigned char *bwt = (unsigned char *) base + fm->bwt;
+	size_t i, n = hdr->n;
+
+	for (i = 0; i <= n; i++) {
+		if (sa[i])
+			bwt[i] = text[sa[i] - 1];
+		else
+			fm->primary = i;
+	}
+
+	for (i = 0; i <= n; i++) {
+		if (!(i % OCC_RATE))
+			memcpy(occ + i / OCC_RATE * fm->sigma, run,
+			       fm->sigma * sizeof(uint32_t));
+
+		if (i != fm->primary)
+			run[fm->col[bwt[i]]]++;
+	}
+
+	if (!((n + 1) % OCC_RATE))
+		memcpy(occ + (n + 1) / OCC_RATE * fm->sigma, run,
+		       fm->sigma * sizeof(uint32_t));
+}
+
+/* Occurrences of c in the BWT before row i, counted from the nearest count.
+ * The primary row holds a zero byte, which isn't one. */
+static size_t occ(const struct sarray *s, unsigned char c, size_t i)
+{
+	const struct sarray_fm *fm = s->fm;
+	size_t b = i / OCC_RATE, from = b * OCC_RATE, to = i, k, cnt = 0;
+	int up = i % OCC_RATE > OCC_RATE / 2 &&
+		 b < (s->hdr->n + 1) / OCC_RATE;
+
+	if (up) {
+		from = i;
+		to   = ++b * OCC_RATE;
+	}
+
+	for (k = from; k < to; k++)
+		cnt += s->bwt[k] == c;
+
+	if (!c && fm->primary >= from && fm->primary < to)
+		cnt--;
+
+	k = s->occ[b * fm->sigma + fm->col[c]];
+
+	return up ? k - cnt : k + cnt;
+}
+
+/* Backward search: the rows starting with the pattern's suffix of length j are
+ * a range, which the (j + 1)-th last byte narrows down. */
+static size_t fm_search(struct sarray *s, const unsigned char *p, size_t m,
+			size_t *first)
+{
+	const struct sarray_fm *fm = s->fm;
+	size_t lo = 0, hi = s->hdr->n + 1, i = m;
+
+	while (i--) {
+		if (fm->col[p[i]] == NO_COL)
+			return 0;
+
+		lo = fm->c[p[i]] + occ(s, p[i], lo);
+		hi = fm->c[p[i]] + occ(s, p[i], hi);
+
+		if (lo >= hi)
+			return 0;
+	}
+
+	*first = lo - 1;  // Row 0 is the empty suffix.
+
+	return hi - lo;
+}
+
+/* Compares the first m bytes of the suffix of some rank with the pattern. */
+static int suffix_cmp(const struct sarray *s, size_t rank,
+		      const unsigned char *p, size_t m)
+{
+	size_t pos = s->sa[rank], len = s->hdr->n - pos;
+	int r = memcmp(s->text + pos, p, len < m ? len : m);
+
+	return r ? r : -(len < m);
+}
+
+/* Gets the first rank whose suffix compares greater than or equal to the
+ * pattern (or greater, if upper is 1), without branching on the comparison,
+ * as in smap.c. */
+static size_t bound(const struct sarray *s, const unsigned char *p, size_t m,
+		    int upper)
+{
+	size_t base = 0, half, len = s->hdr->n;
+
+	if (!len)
+		return 0;
+
+	while (len > 1) {
+		half  = len / 2;
+		base += suffix_cmp(s, base + half, p, m) < upper ? half : 0;
+		len  -= half;
+	}
+
+	return base + (suffix_cmp(s, base, p, m) < upper);
+}
+
+/* Tells whether len bytes at off are within an image of some size. */
+static int within(uint64_t size, uint64_t off, uint64_t len)
+{
+	return !(off % 8) && off <= size && len <= size - off;
+}
+
+/* See image_valid. The contents of the sections are only covered by the
+ * checksum. */
+static int valid(const struct image_hdr *img)
+{
+	const struct sarray_hdr *hdr = (const struct sarray_hdr *) img;
+	uint64_t size = img->size, n = hdr->n;
+	const struct sarray_fm *fm;
+	int c;
+
+	if (size < sizeof(struct sarray_hdr) || n > SARRAY_MAX_LEN ||
+	    hdr->text < sizeof(struct sarray_hdr))
+		return 0;
+
+	if (!within(size, hdr->text, n) ||
+	    !within(size, hdr->sa, (n + 1) * sizeof(uint32_t)) ||
+	    (hdr->lcp && !within(size, hdr->lcp, n * sizeof(uint32_t))))
+		return 0;
+
+	if (!hdr->fm)
+		return 1;
+
+	if (!within(size, hdr->fm, sizeof(struct sarray_fm)))
+		return 0;
+
+	fm = (const struct sarray_fm *) ((const char *) hdr + hdr->fm);
+
+	if (fm->sigma > 256 || fm->primary > n || fm->c[0] != 1 ||
+	    fm->c[256] != n + 1)
+		return 0;
+
+	for (c = 0; c < 256; c++)
+		if ((fm->col[c] != NO_COL && fm->col[c] >= fm->sigma) ||
+		    fm->c[c + 1] < fm->c[c])
+			return 0;
+
+	return within(size, fm->occ, ((n + 1) / OCC_RATE + 1) * fm->sigma *
+		      sizeof(uint32_t)) && within(size, fm->bwt, n + 1);
+}
+
+static struct sarray *wrap(struct sarray_hdr *hdr, int mapped)
+{
+	struct sarray *s = malloc(sizeof(struct sarray));
+	char *base = (char *) hdr;
+
+	s->hdr    = hdr;
+	s->text   = (const unsigned char *) base + hdr->text;
+	s->sa     = (const uint32_t *) (base + hdr->sa) + 1;
+	s->lcp    = hdr->lcp ? (const uint32_t *) (base + hdr->lcp) : NULL;
+	s->fm     = hdr->fm ? (const void *) (base + hdr->fm) : NULL;
+	s->occ    = s->fm ? (const uint32_t *) (base + s->fm->occ) : NULL;
+	s->bwt    = s->fm ? (const unsigned char *) base + s->fm->bwt : NULL;
+	s->mapped = mapped;
+
+	return s;
+}
+
+/* --- API --- */
+
+/* Builds the suffix array of a text of n bytes, which is copied, along with
+ * the sections given by flags (SARRAY_LCP, SARRAY_FM.) Returns NULL if the
+ * text is too long, or there's not enough memory. */
+struct sarray *make_sarray(const void *text, size_t n, int flags)
+{
+	struct sarray_hdr h = { 0 }, *hdr;
+	struct sarray_fm fm;
+	uint64_t counts[256] = { 0 };
+	size_t i, size;
+	struct str s;
+	int c;
+
+	if (n > SARRAY_MAX_LEN)
+		return NULL;
+
+	h.n     = n;
+	h.flags = flags;
+	h.text  = IMAGE_ALIGN(sizeof(struct sarray_hdr), 8);
+	h.sa    = IMAGE_ALIGN(h.text + n, 8);
+	size    = h.sa + (n + 1) * sizeof(uint32_t);
+
+	if (flags & SARRAY_LCP) {
+		h.lcp = IMAGE_ALIGN(size, 8);
+		size  = h.lcp + n * sizeof(uint32_t);
+	}
+
+	/* Bytes are given columns of counts in order, the sentinel coming
+	 * first. */
+	if (flags & SARRAY_FM) {
+		memset(&fm, 0, sizeof(struct sarray_fm));
+
+		for (i = 0; i < n; i++)
+			counts[((const unsigned char *) text)[i]]++;
+
+		fm.c[0] = 1;
+
+		for (c = 0; c < 256; c++) {
+			fm.c[c + 1] = fm.c[c] + counts[c];
+			fm.col[c]   = counts[c] ? fm.sigma++ : NO_COL;
+		}
+
+		h.fm   = IMAGE_ALIGN(size, 8);
+		fm.occ = h.fm + sizeof(struct sarray_fm);
+		fm.bwt = IMAGE_ALIGN(fm.occ + ((n + 1) / OCC_RATE + 1) * fm.sigma *
+				     sizeof(uint32_t), 8);
+		size   = fm.bwt + n + 1;
+	}
+
+	if (!(hdr = calloc(1, size)))
+		return NULL;
+
+	*hdr = h;
+	memcpy((char *) hdr + h.text, text, n);
+
+	if (h.fm)
+		memcpy((char *) hdr + h.fm, &fm, sizeof(struct sarray_fm));
+
+	/* The sentinel makes for the first suffix. */
+	s = (struct str) { (char *) hdr + h.text, n + 1, 1 };
+
+	if (n)
+		sais(&s, (int32_t *) ((char *) hdr + h.sa), 256);
+	else
+		*(uint32_t *) ((char *) hdr + h.sa) = 0;
+
+	if (h.lcp)
+		build_lcp((unsigned char *) hdr + h.text,
+			  (uint32_t *) ((char *) hdr + h.sa) + 1,
+			  (uint32_t *) ((char *) hdr + h.lcp), n);
+
+	if (h.fm)
+		build_fm(hdr);
+
+	image_seal(&hdr->img, SARRAY_MAGIC, SARRAY_VERSION, size);
+
+	return wrap(hdr, 0);
+}
+
+/* Returns the number of occurrences of a pattern of m bytes, and sets first
+ * (unless it's NULL) to the rank of the first suffix starting with it. Runs in
+ * O(m) time with an FM-index, O(m log n) otherwise. */
+size_t sarray_search(struct sarray *s, const void *pat, size_t m,
+		     size_t *first)
+{
+	size_t lo, hi, tmp;
+
+	first = first ? first : &tmp;
+	*first = 0;
+
+	if (!m)
+		return s->hdr->n;
+
+	if (s->fm)
+		return fm_search(s, pat, m, first);
+
+	lo = bound(s, pat, m, 0);
+	hi = bound(s, pat, m, 1);
+
+	*first = lo;
+
+	return hi - lo;
+}
+
+/* Ranks go from 0 to n - 1, the offset of the occurrences of a pattern being
+ * those of the ranks given by sarray_search(). */
+size_t sarray_pos(struct sarray *s, size_t rank)
+{
+	return s->sa[rank];
+}
+
+/* The LCP of the suffix of some rank and the one before (zero for the first.)
+ * Needs the LCP array. */
+size_t sarray_lcp(struct sarray *s, size_t rank)
+{
+	return s->lcp[rank];
+}
+
+/* Returns the length of the longest substring occurring at least twice, and
+ * sets pos to the offset of one of its occurrences. Needs the LCP array. */
+size_t sarray_longest_repeat(struct sarray *s, size_t *pos)
+{
+	size_t i, best = 0;
+
+	*pos = 0;
+
+	for (i = 1; i < s->hdr->n; i++) {
+		if (s->lcp[i] > best) {
+			best = s->lcp[i];
+			*pos = s->sa[i];
+		}
+	}
+
+	return best;
+}
+
+size_t sarray_size(struct sarray *s)
+{
+	return s->hdr->img.size;
+}
+
+/* Returns zero, or -1 with errno set. */
+int sarray_save(struct sarray *s, const char *path)
+{
+	return image_save(&s->hdr->img, path);
+}
+
+/* Maps in a suffix array saved by sarray_save(). Takes constant time, unless
+ * verify is set, in which case the checksum is checked. Returns NULL, with
+ * errno set, if the file can't be loaded. */
+struct sarray *sarray_load(const char *path, int verify)
+{
+	struct image_hdr *img;
+
+	img = image_load(path, SARRAY_MAGIC, SARRAY_VERSION, verify, valid);
+
+	return img ? wrap((struct sarray_hdr *) img, 1) : NULL;
+}
+
+void sarray_destroy(struct sarray *s)
+{
+	image_destroy(&s->hdr->img, s->mapped);
+	free(s);
+}
@@ -0,0 +1,319 @@
+#include <math.h>               // For ceil() and log().
+#include <stdlib.h>             // For malloc() and qsort().
+#include <string.h>             // For memcmp() and memcpy().
+
+#include "hashfn.h"
+#include "sketch.h"
+
+#define NONE -1
+
+/* Returns the bucket for count right after bucket b (or first, if b is NONE),
+ * making it if there's none. */
+static int bucket_after(struct topk *t, int b, uint64_t count)
+{
+	int next = b == NONE ? t->min : t->buckets[b].next, nb;
+
+	if (next != NONE && t->buckets[next].count == count)
+		return next;
+
+	nb      = t->free;
+	t->free = t->buckets[nb].next;
+
+	t->buckets[nb].count = count;
+	t->buckets[nb].first = NONE;
+	t->buckets[nb].prev  = b;
+	t->buckets[nb].next  = next;
+
+	if (next != NONE)
+		t->buckets[next].prev = nb;
+	if (b != NONE)
+		t->buckets[b].next = nb;
+	else
+		t->min = nb;
+
+	return nb;
+}
+
+/* Takes counter i out of its bucket, freeing the bucket if it's left empty. */
+static void detach(struct topk *t, int i)
+{
+	struct topk_counter *c = &t->counters[i];
+	struct topk_bucket *b = &t->buckets[c->bucket];
+
+	if (c->prev != NONE)
+		t->counters[c->prev].next = c->next;
+	else
+		b->first = c->next;
+
+	if (c->next != NONE)
+		t->counters[c->next].prev = c->prev;
+
+	if (b->first != NONE)
+		return;
+
+	if (b->prev != NONE)
+		t->buckets[b->prev].next = b->next;
+	else
+		t->min = b->next;
+
+	if (b->next != NONE)
+		t->buckets[b->next].prev = b->prev;
+
+	b->next = t->free;
+	t->free = c->bucket;
+}
+
+static void attach(struct topk *t, int i, int b)
+{
+	struct topk_counter *c = &t->counters[i];
+	int first = t->buckets[b].first;
+
+	c->bucket = b;
+	c->prev   = NONE;
+	c->next   = first;
+
+	if (first != NONE)
+		t->counters[first].prev = i;
+
+	t->buckets[b].first = i;
+}
+
+/* Moves counter i to the bucket for its count + 1. A counter alone in its
+ * bucket takes the bucket along when there's no bucket for that count yet. */
+static void bump(struct topk *t, int i)
+{
+	struct topk_counter *c = &t->counters[i];
+	struct topk_bucket *b = &t->buckets[c->bucket];
+	int nb;
+
+	c->count++;
+
+	if (c->prev == NONE && c->next == NONE &&
+	    (b->next == NONE || t->buckets[b->next].count != c->count)) {
+		b->count++;
+		return;
+	}
+
+	nb = bucket_after(t, c->bucket, c->count);
+	detach(t, i);
+	attach(t, i, nb);
+}
+
+/* Returns the slot of the item in the index, or the empty slot where it would
+ * go. */
+static size_t index_find(struct topk *t, uint64_t h, const void *key,
+			 size_t len)
+{
+	struct topk_counter *c;
+	size_t i;
+
+	for (i = h & t->mask; t->index[i]; i = (i + 1) & t->mask) {
+		c = &t->counters[t->index[i] - 1];
+
+		if (c->hash == h && c->len == len && !memcmp(c->key, key, len))
+			break;
+	}
+
+	return i;
+}
+
+/* Empties slot i, then moves back the entries that follow, so that none is
+ * separated from its home slot by an empty one. */
+static void index_del(struct topk *t, size_t i)
+{
+	size_t j = i, home;
+
+	for (;;) {
+		j = (j + 1) & t->mask;
+
+		if (!t->index[j])
+			break;
+
+		home = t->counters[t->index[j] - 1].hash & t->mask;
+
+		/* Entries whose home is cyclically in (i, j] stay where they
+		 * are. */
+		if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+			t->index[i] = t->index[j];
+			i = j;
+		}
+	}
+
+	t->index[i] = 0;
+}
+
+static int cmp_counters(const void *_a, const void *_b)
+{
+	const struct topk_counter *a = _a, *b = _b;
+	size_t len = a->len < b->len ? a->len : b->len;
+	int r;
+
+	if (a->count != b->count)
+		return (a->count < b->count) - (a->count > b->count);
+
+	if (a->error != b->error)
+		return (a->error > b->error) - (a->error < b->error);
+
+	r = memcmp(a->key, b->key, len);
+
+	return r ? r : (a->len > b->len) - (a->len < b->len);
+}
+
+/* --- API --- */
+
+struct topk *make_topk(int k)
+{
+	struct topk *t = malloc(sizeof(struct topk));
+	size_t slots = 1;
+	int i;
+
+	while (slots < 2 * (size_t) k)
+		slots <<= 1;
+
+	t->counters = calloc(k, sizeof(struct topk_counter));
+	t->buckets  = malloc(k * sizeof(struct topk_bucket));
+	t->index    = calloc(slots, sizeof(int));
+	t->min      = NONE;
+	t->free     = 0;
+	t->mask     = slots - 1;
+	t->n        = 0;
+	t->k        = k;
+	t->total    = 0;
+
+	/* There are never more distinct counts than counters. */
+	for (i = 0; i < k; i++)
+		t->buckets[i].next = i + 1 < k ? i + 1 : NONE;
+
+	return t;
+}
+
+/* Counts an item of len bytes. */
+void topk_add(struct topk *t, const void *key, size_t len)
+{
+	uint64_t h = hash_bytes(key, len, 0);
+	size_t slot = index_find(t, h, key, len);
+	struct topk_counter *c;
+	int i;
+
+	t->total++;
+
+	if (t->index[slot]) {
+		bump(t, t->index[slot] - 1);
+		return;
+	}
+
+	if (t->n < t->k) {
+		i        = t->n++;
+		c        = &t->counters[i];
+		c->count = 1;
+		c->error = 0;
+
+		attach(t, i, bucket_after(t, NONE, 1));
+	} else {
+		/* Take over the smallest counter. Deleting it from the index may
+		 * move the slot the new item was to take. */
+		i = t->buckets[t->min].first;
+		c = &t->counters[i];
+
+		index_del(t, index_find(t, c->hash, c->key, c->len));
+		slot = index_find(t, h, key, len);
+
+		c->error = c->count;
+		bump(t, i);
+	}
+
+	if (len > c->cap || !c->key) {
+		c->cap = len > 2 * c->cap ? len : 2 * c->cap;
+		c->key = realloc(c->key, c->cap ? c->cap : 1);
+	}
+
+	c->hash = h;
+	c->len  = len;
+	memcpy(c->key, key, len);
+
+	t->index[slot] = i + 1;
+}
+
+/* Copies the counters to out (which must have room for k of them), most
+ * frequent items first, and returns how many there are. Keys are still owned
+ * by the summary, and valid until the next item is added. */
+int topk_list(struct topk *t, struct topk_counter *out)
+{
+	memcpy(out, t->counters, t->n * sizeof(struct topk_counter));
+	qsort(out, t->n, sizeof(struct topk_counter), cmp_counters);
+
+	return t->n;
+}
+
+void topk_destroy(struct topk *t)
+{
+	int i;
+
+	for (i = 0; i < t->n; i++)
+		free(t->counters[i].key);
+
+	free(t->counters);
+	free(t->buckets);
+	free(t->index);
+	free(t);
+}
+
+/* Allocs. a sketch whose estimates exceed true counts by more than epsilon
+ * times the number of items counted with a probability of at most delta, e.g.
+ * make_cms(0.001, 0.01). */
+struct cms *make_cms(double epsilon, double delta)
+{
+	struct cms *s = malloc(sizeof(struct cms));
+	double w = ceil(exp(1) / epsilon);
+
+	for (s->width = 1; s->width < w; s->width <<= 1)
+		;
+
+	s->depth    = (uint32_t) ceil(log(1 / delta));
+	s->depth    = s->depth ? s->depth : 1;
+	s->counters = calloc((size_t) s->width * s->depth, sizeof(uint32_t));
+	s->total    = 0;
+
+	return s;
+}
+
+/* Counters of each row are picked by double hashing, so a single hash does for
+ * all rows. */
+#define ROW_COUNTER(s, h, i)                                                    \
+	(&(s)->counters[(size_t) (i) * (s)->width +                             \
+		(((uint32_t) (h) + (i) * (uint32_t) ((h) >> 32 | 1)) &          \
+		 ((s)->width - 1))])
+
+/* Counts an item n times. Counts saturate rather than wrap around. */
+uint32_t cms_add(struct cms *s, uint64_t h, uint32_t n)
+{
+	uint32_t est = cms_estimate(s, h), i, *c;
+
+	est       = est + n < est ? UINT32_MAX : est + n;
+	s->total += n;
+
+	for (i = 0; i < s->depth; i++) {
+		c  = ROW_COUNTER(s, h, i);
+		*c = *c < est ? est : *c;
+	}
+
+	return est;
+}
+
+uint32_t cms_estimate(struct cms *s, uint64_t h)
+{
+	uint32_t est = UINT32_MAX, i, c;
+
+	for (i = 0; i < s->depth; i++) {
+		c   = *ROW_COUNTER(s, h, i);
+		est = c < est ? c : est;
+	}
+
+	return est;
+}
+
+void cms_destroy(struct cms *s)
+{
+	free(s->counters);
+	free(s);
+}
@@ -0,0 +1,299 @@
+#include "skiplist.h"
+#include "ebr.h"
+
+#define MARK ((uintptr_t) 1)
+
+#define PTR(_next)       ((struct skiplist_node *) ((_next) & ~MARK))
+#define IS_MARKED(_next) ((_next) & MARK)
+
+#define LOAD(_ptr) __atomic_load_n((_ptr), __ATOMIC_ACQUIRE)
+
+/* Per-thread state of the xorshift generator used for picking node levels. */
+static __thread unsigned long long seed;
+
+static unsigned long long seed_counter;
+
+static inline int cas(uintptr_t *ptr, uintptr_t old, uintptr_t new)
+{
+	return __atomic_compare_exchange_n(ptr, &old, new, 0, __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+}
+
+/* Picks a level between 1 and SKIPLIST_MAX_LEVEL, each one being half as
+ * likely as the one below it. */
+static inline int random_level(void)
+{
+	if (!seed)
+		seed = (__atomic_add_fetch(&seed_counter, 1, __ATOMIC_RELAXED) *
+			0x9E3779B97F4A7C15ULL) | 1;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return 1 + __builtin_ctzll((seed >> 32) | 1ULL << (SKIPLIST_MAX_LEVEL - 1));
+}
+
+static struct skiplist_node *make_skiplist_node(void *value, int level)
+{
+	struct skiplist_node *node = malloc(sizeof(struct skiplist_node) +
+					    level * sizeof(uintptr_t));
+	int i;
+
+	node->value = value;
+	node->level = level;
+	node->refs  = 2;
+
+	for (i = 0; i < level; i++)
+		node->next[i] = 0;
+
+	return node;
+}
+
+/* Drops a reference to _x_, retiring it once both the thread that inserted it
+ * and the one that deleted it are done with it. */
+static inline void release(struct skiplist_node *x)
+{
+	if (!__atomic_sub_fetch(&x->refs, 1, __ATOMIC_ACQ_REL))
+		ebr_retire(x, free);
+}
+
+/* Finds, at every level, the last node whose value is smaller than _value_
+ * (preds) and the node following it (succs). Marked nodes found on the way are
+ * unlinked. Returns non-zero if succs[0] holds a value equal to _value_. */
+static int find(struct skiplist *l, const void *value,
+		struct skiplist_node **preds, struct skiplist_node **succs)
+{
+	struct skiplist_node *pred, *curr;
+	uintptr_t next;
+	int lvl;
+
+retry:
+	pred = l->head;
+
+	for (lvl = SKIPLIST_MAX_LEVEL - 1; lvl >= 0; lvl--) {
+		curr = PTR(LOAD(&pred->next[lvl]));
+
+		while (curr) {
+			next = LOAD(&curr->next[lvl]);
+
+			if (IS_MARKED(next)) {
+				if (!cas(&pred->next[lvl], (uintptr_t) curr,
+					 next & ~MARK))
+					goto retry;
+
+				curr = PTR(next);
+				continue;
+			}
+
+			if (l->cmp(curr->value, value) >= 0)
+				break;
+
+			pred = curr;
+			curr = PTR(next);
+		}
+
+		preds[lvl] = pred;
+		succs[lvl] = curr;
+	}
+
+	return succs[0] && !l->cmp(succs[0]->value, value);
+}
+
+/* --- API --- */
+
+struct skiplist *make_skiplist(skiplist_cmp cmp)
+{
+	struct skiplist *list = malloc(sizeof(struct skiplist));
+
+	list->head = make_skiplist_node(NULL, SKIPLIST_MAX_LEVEL);
+	list->cmp  = cmp;
+
+	return list;
+}
+
+/* Returns the value equal to _value_, or NULL. */
+void *skiplist_search(struct skiplist *l, const void *value)
+{
+	struct skiplist_node *preds[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *succs[SKIPLIST_MAX_LEVEL];
+	void *ret = NULL;
+
+	ebr_enter();
+
+	if (find(l, value, preds, succs))
+		ret = succs[0]->value;
+
+	ebr_exit();
+
+	return ret;
+}
+
+void *skiplist_minimum(struct skiplist *l)
+{
+	struct skiplist_node *x;
+	uintptr_t next;
+	void *ret = NULL;
+
+	ebr_enter();
+
+	for (x = PTR(LOAD(&l->head->next[0])); x; x = PTR(next)) {
+		next = LOAD(&x->next[0]);
+
+		if (!IS_MARKED(next)) {
+			ret = x->value;
+			break;
+		}
+	}
+
+	ebr_exit();
+
+	return ret;
+}
+
+/* Links the node at the bottom level first, which makes it visible, then at
+ * every level above it. Returns zero if an equal value was already in. */
+int skiplist_insert(struct skiplist *l, void *value)
+{
+	struct skiplist_node *preds[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *succs[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *x = make_skiplist_node(value, random_level());
+	uintptr_t next;
+	int i;
+
+	ebr_enter();
+
+	for (;;) {
+		if (find(l, value, preds, succs)) {
+			ebr_exit();
+			free(x);
+			return 0;
+		}
+
+		for (i = 0; i < x->level; i++)
+			x->next[i] = (uintptr_t) succs[i];
+
+		if (cas(&preds[0]->next[0], (uintptr_t) succs[0],
+			(uintptr_t) x))
+			break;
+	}
+
+	for (i = 1; i < x->level; i++) {
+		for (;;) {
+			next = LOAD(&x->next[i]);
+
+			/* Stop linking as soon as the node is being deleted. */
+			if (IS_MARKED(next))
+				goto done;
+
+			if (PTR(next) != succs[i] &&
+			    !cas(&x->next[i], next, (uintptr_t) succs[i]))
+				goto done;
+
+			if (cas(&preds[i]->next[i], (uintptr_t) succs[i],
+				(uintptr_t) x))
+				break;
+
+			if (!find(l, value, preds, succs) || succs[0] != x)
+				goto done;
+		}
+	}
+
+done:
+	/* If the node got deleted while being linked, the deleting thread may
+	 * have missed the levels linked afterwards. */
+	if (IS_MARKED(LOAD(&x->next[0])))
+		find(l, value, preds, succs);
+
+	release(x);
+
+	ebr_exit();
+
+	return 1;
+}
+
+/* Marks the node from the top level down; the thread marking its bottom level
+ * is the one deleting it. Returns the value deleted, or NULL. */
+void *skiplist_delete(struct skiplist *l, const void *value)
+{
+	struct skiplist_node *preds[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *succs[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *x;
+	uintptr_t next;
+	void *ret = NULL;
+	int i;
+
+	ebr_enter();
+
+	if (!find(l, value, preds, succs))
+		goto out;
+
+	x = succs[0];
+
+	for (i = x->level - 1; i > 0; i--)
+		do {
+			next = LOAD(&x->next[i]);
+		} while (!IS_MARKED(next) && !cas(&x->next[i], next, next | MARK));
+
+	for (;;) {
+		next = LOAD(&x->next[0]);
+
+		if (IS_MARKED(next))
+			goto out;  // Someone else beat us to it.
+
+		if (cas(&x->next[0], next, next | MARK))
+			break;
+	}
+
+	ret = x->value;
+
+	/* Unlink the node from every level. */
+	find(l, value, preds, succs);
+	release(x);
+
+out:
+	ebr_exit();
+
+	return ret;
+}
+
+/* Visits, in order, every value v such that lo <= v <= hi. Values inserted or
+ * deleted concurrently may or may not be visited. */
+void skiplist_range(struct skiplist *l, const void *lo, const void *hi,
+		    skiplist_visit visit, void *arg)
+{
+	struct skiplist_node *preds[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *succs[SKIPLIST_MAX_LEVEL];
+	struct skiplist_node *x;
+	uintptr_t next;
+
+	ebr_enter();
+
+	find(l, lo, preds, succs);
+
+	for (x = succs[0]; x; x = PTR(next)) {
+		next = LOAD(&x->next[0]);
+
+		if (IS_MARKED(next))
+			continue;
+
+		if (l->cmp(x->value, hi) > 0 || visit(x->value, arg))
+			break;
+	}
+
+	ebr_exit();
+}
+
+/* Must not run concurrently with any other op. Nodes already unlinked are
+ * left to ebr.h. */
+void skiplist_destroy(struct skiplist *l)
+{
+	struct skiplist_node *x, *next;
+
+	for (x = l->head; x; x = next) {
+		next = PTR(x->next[0]);
+		free(x);
+	}
+
+	free(l);
+}
@@ -0,0 +1,161 @@
+#include <stdint.h>             // For SIZE_MAX.
+#include <stdlib.h>             // For malloc().
+
+#include "smap.h"
+
+static inline const char *rec_at(const struct smap *m, size_t i)
+{
+	if (m->hdr->stride)
+		return m->recs + i * m->hdr->stride;
+
+	return m->recs + m->offs[i];
+}
+
+/* See image_valid. Record offsets are only covered by the checksum. */
+static int valid(const struct image_hdr *img)
+{
+	const struct smap_hdr *hdr = (const struct smap_hdr *) img;
+	uint64_t size = img->size, n = hdr->n, stride = hdr->stride;
+
+	if (size < sizeof(struct smap_hdr) || n > size / 8 ||
+	    hdr->offs < sizeof(struct smap_hdr) || hdr->offs % 8 ||
+	    hdr->recs % 8 || hdr->recs > size)
+		return 0;
+
+	if (stride)
+		return hdr->recs >= hdr->offs && n <= (size - hdr->recs) / stride;
+
+	return hdr->recs >= hdr->offs + n * sizeof(uint64_t);
+}
+
+static struct smap *wrap(struct smap_hdr *hdr, smap_cmp cmp, int mapped)
+{
+	struct smap *m = malloc(sizeof(struct smap));
+	char *base = (char *) hdr;
+
+	m->hdr    = hdr;
+	m->offs   = (const uint64_t *) (base + hdr->offs);
+	m->recs   = base + hdr->recs;
+	m->cmp    = cmp;
+	m->mapped = mapped;
+
+	return m;
+}
+
+/* --- API --- */
+
+/* Packs the values of the tree in order, so duplicate keys are kept, in the
+ * order the tree has them. The tree is left as it was. */
+struct smap *rbtree_freeze(struct rbtree *t, smap_pack pack, smap_cmp cmp)
+{
+	struct smap_hdr h = { 0 }, *hdr;
+	struct rbtree_node *x, *first;
+	uint64_t *offs;
+	size_t i, n = t->n, recs_sz = 0, sz, stride = 0, size;
+
+	first = n ? rbtree_minimum(t) : t->nil;
+
+	for (x = first, i = 0; x != t->nil; x = rbtree_successor(t, x), i++) {
+		sz       = IMAGE_ALIGN(pack(x->value, NULL), 8);
+		stride   = !i || sz == stride ? sz : SIZE_MAX;
+		recs_sz += sz;
+	}
+
+	/* Records of equal sizes are found by rank, with no offsets. */
+	h.n      = n;
+	h.stride = stride == SIZE_MAX ? 0 : stride;
+	h.offs   = IMAGE_ALIGN(sizeof(struct smap_hdr), 8);
+	h.recs   = h.offs + (h.stride ? 0 : n) * sizeof(uint64_t);
+	size     = h.recs + recs_sz;
+
+	hdr  = calloc(1, size);
+	offs = (uint64_t *) ((char *) hdr + h.offs);
+	*hdr = h;
+
+	for (x = first, i = 0, sz = 0; x != t->nil;
+	     x = rbtree_successor(t, x), i++) {
+		if (!h.stride)
+			offs[i] = sz;
+
+		sz += IMAGE_ALIGN(pack(x->value, (char *) hdr + h.recs + sz), 8);
+	}
+
+	image_seal(&hdr->img, SMAP_MAGIC, SMAP_VERSION, size);
+
+	return wrap(hdr, cmp, 0);
+}
+
+/* Returns the record of the key (the first one, if there are duplicates), or
+ * NULL if it isn't in the map. */
+const void *smap_search(struct smap *m, const void *key)
+{
+	size_t i = smap_lower_bound(m, key);
+	const char *rec;
+
+	if (i == m->hdr->n)
+		return NULL;
+
+	rec = rec_at(m, i);
+
+	return m->cmp(rec, key) ? NULL : rec;
+}
+
+/* Returns n if all the records are less than the key. The search halves the
+ * range without branching on the comparison, which compiles to a conditional
+ * move, so mispredictions don't pile up on random keys. */
+size_t smap_lower_bound(struct smap *m, const void *key)
+{
+	size_t base = 0, half, len = m->hdr->n;
+
+	if (!len)
+		return 0;
+
+	while (len > 1) {
+		half  = len / 2;
+		base += m->cmp(rec_at(m, base + half), key) < 0 ? half : 0;
+		len  -= half;
+	}
+
+	return base + (m->cmp(rec_at(m, base), key) < 0);
+}
+
+/* Ranks go from 0 to smap_count() - 1. */
+const void *smap_at(struct smap *m, size_t i)
+{
+	return rec_at(m, i);
+}
+
+size_t smap_count(struct smap *m)
+{
+	return m->hdr->n;
+}
+
+size_t smap_size(struct smap *m)
+{
+	return m->hdr->img.size;
+}
+
+/* Returns zero, or -1 with errno set. */
+int smap_save(struct smap *m, const char *path)
+{
+	return image_save(&m->hdr->img, path);
+}
+
+/* Maps in a map saved by smap_save(), given a comparison function matching the
+ * one it was built with. Takes constant time, unless verify is set, in which
+ * case the checksum is checked. Returns NULL, with errno set, if the file can't
+ * be loaded. */
+struct smap *smap_load(const char *path, smap_cmp cmp, int verify)
+{
+	struct image_hdr *img;
+
+	img = image_load(path, SMAP_MAGIC, SMAP_VERSION, verify, valid);
+
+	return img ? wrap((struct smap_hdr *) img, cmp, 1) : NULL;
+}
+
+void smap_destroy(struct smap *m)
+{
+	image_destroy(&m->hdr->img, m->mapped);
+	free(m);
+}
@@ -0,0 +1,678 @@
+#define _POSIX_C_SOURCE 200809L // For pthreads.
+
+#include <pthread.h>            // For pthread_create() and pthread_join().
+#include <stdlib.h>             // For malloc().
+#include <string.h>             // For memcpy().
+
+#include "sort.h"
+
+/* Runs shorter than this are sorted by insertion sort. */
+#define INSERTION_MAX  24
+
+/* Runs longer than this get their pivot as the median of 3 medians of 3. */
+#define NINTHER_MIN    128
+
+/* Elements insertion sort may move before giving up on a partition. */
+#define PARTIAL_MAX    8
+
+#define RADIX_BITS     8
+#define RADIX          (1 << RADIX_BITS)
+#define RADIX_PASSES   (64 / RADIX_BITS)
+
+/* Element i of an array, i being negative to go backwards. */
+#define AT(s, p, i)    ((p) + (ptrdiff_t) (i) * (ptrdiff_t) (s)->size)
+
+#define LESS(s, a, b)  ((s)->cmp((a), (b)) < 0)
+
+#ifdef ALGS_STATS
+static struct sort_stats stats;
+#endif
+
+/* Key of the elements being radix sorted, for comparing them should the sort
+ * fall back to pdqsort. Per thread, as sorts may run concurrently. */
+static __thread sort_key radix_key;
+
+/* The element size and comparison function of the array being sorted, along
+ * with room for holding an element aside. */
+struct sorter {
+	size_t   size;
+	sort_cmp cmp;
+	char     *tmp;
+};
+
+/* Most elements are words, or a few of them. */
+static inline void copy(void *dst, const void *src, size_t size)
+{
+	switch (size) {
+	case 4:
+		memcpy(dst, src, 4);
+		break;
+	case 8:
+		memcpy(dst, src, 8);
+		break;
+	case 16:
+		memcpy(dst, src, 16);
+		break;
+	default:
+		memcpy(dst, src, size);
+	}
+}
+
+static inline void swap(char *a, char *b, size_t size)
+{
+	unsigned char t[8];
+	size_t len;
+
+	for (; size; size -= len, a += len, b += len) {
+		len = size < 8 ? size : 8;
+		memcpy(t, a, len);
+		memcpy(a, b, len);
+		memcpy(b, t, len);
+	}
+}
+
+/* Sorts [begin, end) by insertion sort. Unless guarded, the element before
+ * begin must be no greater than any of them, which saves a bound check. */
+static void insertion_sort(struct sorter *s, char *begin, char *end,
+			   int guarded)
+{
+	char *cur, *sift;
+
+	if (begin == end)
+		return;
+
+	for (cur = AT(s, begin, 1); cur < end; cur = AT(s, cur, 1)) {
+		if (!LESS(s, cur, AT(s, cur, -1)))
+			continue;
+
+		copy(s->tmp, cur, s->size);
+		sift = cur;
+
+		do {
+			copy(sift, AT(s, sift, -1), s->size);
+			sift = AT(s, sift, -1);
+		} while ((!guarded || sift != begin) &&
+			 LESS(s, s->tmp, AT(s, sift, -1)));
+
+		copy(sift, s->tmp, s->size);
+	}
+}
+
+/* Insertion sort that gives up, returning zero, once it has moved more than
+ * PARTIAL_MAX elements. */
+static int partial_insertion_sort(struct sorter *s, char *begin, char *end)
+{
+	size_t moved = 0;
+	char *cur, *sift;
+
+	if (begin == end)
+		return 1;
+
+	for (cur = AT(s, begin, 1); cur < end; cur = AT(s, cur, 1)) {
+		if (!LESS(s, cur, AT(s, cur, -1)))
+			continue;
+
+		copy(s->tmp, cur, s->size);
+		sift = cur;
+
+		do {
+			copy(sift, AT(s, sift, -1), s->size);
+			sift = AT(s, sift, -1);
+		} while (sift != begin && LESS(s, s->tmp, AT(s, sift, -1)));
+
+		copy(sift, s->tmp, s->size);
+		moved += (cur - sift) / s->size;
+
+		if (moved > PARTIAL_MAX)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void sort2(struct sorter *s, char *a, char *b)
+{
+	if (LESS(s, b, a))
+		swap(a, b, s->size);
+}
+
+/* Leaves the median of a, b and c in b. */
+static void sort3(struct sorter *s, char *a, char *b, char *c)
+{
+	sort2(s, a, b);
+	sort2(s, b, c);
+	sort2(s, a, b);
+}
+
+static void sift_down(struct sorter *s, char *base, size_t i, size_t n)
+{
+	size_t child;
+
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n &&
+		    LESS(s, AT(s, base, child), AT(s, base, child + 1)))
+			child++;
+
+		if (!LESS(s, AT(s, base, i), AT(s, base, child)))
+			return;
+
+		swap(AT(s, base, i), AT(s, base, child), s->size);
+		i = child;
+	}
+}
+
+static void heapsort(struct sorter *s, char *begin, char *end)
+{
+	size_t i, n = (end - begin) / s->size;
+
+	for (i = n / 2; i--; )
+		sift_down(s, begin, i, n);
+
+	for (i = n; i-- > 1; ) {
+		swap(begin, AT(s, begin, i), s->size);
+		sift_down(s, begin, 0, i);
+	}
+}
+
+/* Partitions [begin, end) around the pivot at begin, the elements equal to it
+ * going to the right. Returns where the pivot ends up, and sets partitioned if
+ * no element had to be swapped. The pivot being a median of 3, some element
+ * to its right is no less than it, and some one to its left no greater, which
+ * bounds the first scans. */
+static char *partition_right(struct sorter *s, char *begin, char *end,
+			     int *partitioned)
+{
+	char *first = begin, *last = end, *pivot = s->tmp + s->size;
+
+	copy(pivot, begin, s->size);
+
+	do
+		first = AT(s, first, 1);
+	while (LESS(s, first, pivot));
+
+	if (AT(s, first, -1) == begin) {
+		while (first < last) {
+			last = AT(s, last, -1);
+
+			if (LESS(s, last, pivot))
+				break;
+		}
+	} else {
+		do
+			last = AT(s, last, -1);
+		while (!LESS(s, last, pivot));
+	}
+
+	*partitioned = first >= last;
+
+	while (first < last) {
+		swap(first, last, s->size);
+
+		do
+			first = AT(s, first, 1);
+		while (LESS(s, first, pivot));
+
+		do
+			last = AT(s, last, -1);
+		while (!LESS(s, last, pivot));
+	}
+
+	first = AT(s, first, -1);
+	copy(begin, first, s->size);
+	copy(first, pivot, s->size);
+
+	return first;
+}
+
+/* Partitions [begin, end) around the pivot at begin, the elements equal to it
+ * going to the left. It's only used when the element before begin is equal to
+ * the pivot, in which case everything to the left is done with. */
+static char *partition_left(struct sorter *s, char *begin, char *end)
+{
+	char *first = begin, *last = end, *pivot = s->tmp + s->size;
+
+	copy(pivot, begin, s->size);
+
+	do
+		last = AT(s, last, -1);
+	while (LESS(s, pivot, last));
+
+	if (AT(s, last, 1) == end) {
+		while (first < last) {
+			first = AT(s, first, 1);
+
+			if (LESS(s, pivot, first))
+				break;
+		}
+	} else {
+		do
+			first = AT(s, first, 1);
+		while (!LESS(s, pivot, first));
+	}
+
+	while (first < last) {
+		swap(first, last, s->size);
+
+		do
+			last = AT(s, last, -1);
+		while (LESS(s, pivot, last));
+
+		do
+			first = AT(s, first, 1);
+		while (!LESS(s, pivot, first));
+	}
+
+	copy(begin, last, s->size);
+	copy(last, pivot, s->size);
+
+	return last;
+}
+
+/* Swaps a few elements of an unbalanced partition of n elements with others a
+ * quarter of the way in, from both ends, to break the pattern. */
+static void shuffle(struct sorter *s, char *begin, char *end, size_t n)
+{
+	size_t q = n / 4, size = s->size;
+
+	swap(begin, AT(s, begin, q), size);
+	swap(AT(s, end, -1), AT(s, end, -(ptrdiff_t) q), size);
+
+	if (n > NINTHER_MIN) {
+		swap(AT(s, begin, 1), AT(s, begin, q + 1), size);
+		swap(AT(s, begin, 2), AT(s, begin, q + 2), size);
+		swap(AT(s, end, -2), AT(s, end, -(ptrdiff_t) q - 1), size);
+		swap(AT(s, end, -3), AT(s, end, -(ptrdiff_t) q - 2), size);
+	}
+}
+
+/* Sorts [begin, end), recursing on the left partition and looping on the
+ * right one. Leftmost tells whether there's nothing before begin, and bad how
+ * many more unbalanced partitions are allowed before giving up on quicksort. */
+static void pdqsort(struct sorter *s, char *begin, char *end, int bad,
+		    int leftmost)
+{
+	size_t n, half, l, r;
+	int partitioned;
+	char *pivot;
+
+	while ((n = (end - begin) / s->size) >= INSERTION_MAX) {
+		half = n / 2;
+
+		if (n > NINTHER_MIN) {
+			sort3(s, begin, AT(s, begin, half), AT(s, end, -1));
+			sort3(s, AT(s, begin, 1), AT(s, begin, half - 1),
+			      AT(s, end, -2));
+			sort3(s, AT(s, begin, 2), AT(s, begin, half + 1),
+			      AT(s, end, -3));
+			sort3(s, AT(s, begin, half - 1), AT(s, begin, half),
+			      AT(s, begin, half + 1));
+			swap(begin, AT(s, begin, half), s->size);
+		} else {
+			sort3(s, AT(s, begin, half), begin, AT(s, end, -1));
+		}
+
+		/* A pivot equal to the element before it is the least of the
+		 * partition, so the ones equal to it need no further sorting. */
+		if (!leftmost && !LESS(s, AT(s, begin, -1), begin)) {
+			begin = AT(s, partition_left(s, begin, end), 1);
+			continue;
+		}
+
+		pivot = partition_right(s, begin, end, &partitioned);
+		l     = (pivot - begin) / s->size;
+		r     = n - l - 1;
+
+		if (l < n / 8 || r < n / 8) {
+			if (!--bad) {
+				STATS_ATOMIC_INC(stats, pdq_fallbacks);
+				heapsort(s, begin, end);
+				return;
+			}
+
+			if (l >= INSERTION_MAX)
+				shuffle(s, begin, pivot, l);
+
+			if (r >= INSERTION_MAX)
+				shuffle(s, AT(s, pivot, 1), end, r);
+		} else if (partitioned &&
+			   partial_insertion_sort(s, begin, pivot) &&
+			   partial_insertion_sort(s, AT(s, pivot, 1), end)) {
+			STATS_ATOMIC_INC(stats, pdq_shortcuts);
+			return;
+		}
+
+		pdqsort(s, begin, pivot, bad, leftmost);
+
+		begin    = AT(s, pivot, 1);
+		leftmost = 0;
+	}
+
+	insertion_sort(s, begin, end, leftmost);
+}
+
+/* Stable merge of two sorted runs into out. */
+static void merge(struct sorter *s, const char *a, size_t na, const char *b,
+		  size_t nb, char *out)
+{
+	const char *end_a = AT(s, a, na), *end_b = AT(s, b, nb);
+
+	while (a < end_a && b < end_b) {
+		if (LESS(s, b, a)) {
+			copy(out, b, s->size);
+			b = AT(s, b, 1);
+		} else {
+			copy(out, a, s->size);
+			a = AT(s, a, 1);
+		}
+
+		out = AT(s, out, 1);
+	}
+
+	memcpy(out, a, end_a - a);
+	memcpy(AT(s, out, (end_a - a) / s->size), b, end_b - b);
+}
+
+/* Gets how many of the first k elements of the merge of a and b come from a,
+ * ties going to a. */
+static size_t split(struct sorter *s, const char *a, size_t na, const char *b,
+		    size_t nb, size_t k)
+{
+	size_t lo = k > nb ? k - nb : 0, hi = k < na ? k : na, i;
+
+	while (lo < hi) {
+		i = lo + (hi - lo) / 2;
+
+		if (!LESS(s, AT(s, b, k - i - 1), AT(s, a, i)))
+			lo = i + 1;
+		else
+			hi = i;
+	}
+
+	return lo;
+}
+
+/* The work of a thread of sort_parallel(): either sorting a chunk in place, or
+ * producing a piece of a merge, [k, k + len) of the output. */
+struct sort_job {
+	struct sorter s;
+
+	const char    *a;
+	size_t        na;
+	const char    *b;
+	size_t        nb;
+	char          *out;
+	size_t        k;
+	size_t        len;
+};
+
+static void *sort_run(void *arg)
+{
+	struct sort_job *j = (struct sort_job *) arg;
+	struct sorter *s = &j->s;
+	size_t i, n;
+
+	if (!j->out) {
+		n = j->na;
+
+		if (n > 1)
+			pdqsort(s, (char *) j->a, AT(s, (char *) j->a, n),
+				64 - __builtin_clzll(n), 1);
+
+		return NULL;
+	}
+
+	i = split(s, j->a, j->na, j->b, j->nb, j->k);
+	n = split(s, j->a, j->na, j->b, j->nb, j->k + j->len);
+
+	merge(s, AT(s, j->a, i), n - i, AT(s, j->b, j->k - i),
+	      j->k + j->len - n - (j->k - i), AT(s, j->out, j->k));
+
+	return NULL;
+}
+
+/* Runs the jobs, each in its own thread. Jobs whose thread can't be started
+ * (or all of them, if there's no memory for the threads) are run here. */
+static void run_jobs(struct sort_job *jobs, int njobs)
+{
+	pthread_t *threads = malloc(njobs * sizeof(pthread_t));
+	char *started = calloc(njobs, 1);
+	int i;
+
+	for (i = 0; i < njobs; i++) {
+		if (threads && started)
+			started[i] = !pthread_create(&threads[i], NULL,
+						     sort_run, &jobs[i]);
+
+		if (!started || !started[i])
+			sort_run(&jobs[i]);
+	}
+
+	for (i = 0; started && i < njobs; i++)
+		if (started[i])
+			pthread_join(threads[i], NULL);
+
+	free(started);
+	free(threads);
+}
+
+/* Orders elements by radix_key. */
+static int key_cmp(const void *a, const void *b)
+{
+	uint64_t x = radix_key(a), y = radix_key(b);
+
+	return (x > y) - (x < y);
+}
+
+/* --- API --- */
+
+/* Sorts n elements of some size, as qsort() does. */
+void sort_pdq(void *base, size_t n, size_t size, sort_cmp cmp)
+{
+	struct sorter s = { size, cmp, malloc(2 * size) };
+
+	if (n > 1)
+		pdqsort(&s, base, AT(&s, (char *) base, n),
+			64 - __builtin_clzll(n), 1);
+
+	free(s.tmp);
+}
+
+/* Sorts n elements of some size by their key, keeping equal ones in the order
+ * they were in. Should there be no memory for the buffer, falls back to
+ * sort_pdq(), which sorts them by key all the same, but isn't stable. */
+void sort_radix(void *base, size_t n, size_t size, sort_key key)
+{
+	size_t (*counts)[RADIX], *bkt, i, sum, c;
+	char *src = base, *dst, *p, *tmp;
+	uint64_t k, first;
+	int d, shift;
+
+	if (n < 2)
+		return;
+
+	counts = calloc(RADIX_PASSES, sizeof(*counts));
+	dst    = malloc(n * size);
+
+	if (!counts || !dst) {
+		free(counts);
+		free(dst);
+
+		radix_key = key;
+		sort_pdq(base, n, size, key_cmp);
+		return;
+	}
+
+	for (p = src, i = 0; i < n; i++, p += size)
+		for (k = key(p), d = 0; d < RADIX_PASSES; d++)
+			counts[d][(k >> d * RADIX_BITS) & (RADIX - 1)]++;
+
+	first = key(src);
+
+	for (d = 0; d < RADIX_PASSES; d++) {
+		shift = d * RADIX_BITS;
+		bkt   = counts[d];
+
+		if (bkt[(first >> shift) & (RADIX - 1)] == n) {
+			STATS_ATOMIC_INC(stats, radix_skipped);
+			continue;
+		}
+
+		STATS_ATOMIC_INC(stats, radix_passes);
+
+		for (i = sum = 0; i < RADIX; i++) {
+			c      = bkt[i];
+			bkt[i] = sum;
+			sum   += c;
+		}
+
+		for (p = src, i = 0; i < n; i++, p += size) {
+			c = bkt[(key(p) >> shift) & (RADIX - 1)]++;
+			copy(dst + c * size, p, size);
+		}
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	/* An odd number of passes leaves the array in the buffer. */
+	if (src != base) {
+		memcpy(base, src, n * size);
+		dst = src;
+	}
+
+	free(dst);
+	free(counts);
+}
+
+/* Sorts n elements of some size over (at most) nthreads threads, so that each
+ * sorts at least SORT_MIN_CHUNK of them. Unlike merge sort, it isn't stable,
+ * as chunks are sorted by pdqsort. */
+void sort_parallel(void *base, size_t n, size_t size, sort_cmp cmp,
+		   int nthreads)
+{
+	int i, j, nruns, pairs, pieces, njobs;
+	char *src = base, *dst, *tmp;
+	struct sort_job *jobs, *job;
+	size_t *runs, len;
+
+	/* No more threads than asked for, nor than there are chunks of at
+	 * least SORT_MIN_CHUNK elements. */
+	if (nthreads < 1)
+		nthreads = 1;
+
+	if ((size_t) nthreads > n / SORT_MIN_CHUNK)
+		nthreads = n / SORT_MIN_CHUNK ? n / SORT_MIN_CHUNK : 1;
+
+	if (nthreads == 1) {
+		sort_pdq(base, n, size, cmp);
+		return;
+	}
+
+	/* There's one job per thread, plus one for an odd run out. Short of
+	 * memory for any of it, the array is sorted in this thread. */
+	jobs = calloc(nthreads + 1, sizeof(struct sort_job));
+	runs = malloc((nthreads + 1) * sizeof(size_t));
+	dst  = malloc(n * size);
+
+	for (i = 0; jobs && i <= nthreads; i++) {
+		jobs[i].s = (struct sorter) { size, cmp, malloc(2 * size) };
+		runs[i]   = i < nthreads ? n / nthreads * i : n;
+
+		if (!jobs[i].s.tmp)
+			break;
+	}
+
+	if (!jobs || !runs || !dst || i <= nthreads) {
+		for (j = 0; jobs && j <= nthreads; j++)
+			free(jobs[j].s.tmp);
+
+		free(jobs);
+		free(runs);
+		free(dst);
+
+		sort_pdq(base, n, size, cmp);
+		return;
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		jobs[i].a   = src + runs[i] * size;
+		jobs[i].na  = runs[i + 1] - runs[i];
+		jobs[i].out = NULL;
+	}
+
+	run_jobs(jobs, nthreads);
+
+	/* Merges pairs of runs, the threads being split evenly among them. The
+	 * odd run out is merged with nothing, i.e. copied. */
+	for (nruns = nthreads; nruns > 1; nruns = (nruns + 1) / 2) {
+		pairs = nruns / 2;
+		njobs = 0;
+
+		for (i = 0; i < nruns; i += 2) {
+			pieces = i + 1 < nruns ? nthreads / pairs : 1;
+			len    = runs[i + 2 < nruns ? i + 2 : nruns] - runs[i];
+
+			for (j = 0; j < pieces; j++) {
+				job      = &jobs[njobs++];
+				job->a   = src + runs[i] * size;
+				job->na  = (i + 1 < nruns ? runs[i + 1] :
+					    runs[nruns]) - runs[i];
+				job->b   = job->a + job->na * size;
+				job->nb  = len - job->na;
+				job->out = dst + runs[i] * size;
+				job->k   = len / pieces * j;
+				job->len = j + 1 < pieces ? len / pieces :
+					   len - job->k;
+			}
+		}
+
+		run_jobs(jobs, njobs);
+
+		for (i = 0; 2 * i < nruns; i++)
+			runs[i] = runs[2 * i];
+
+		runs[i] = runs[nruns];
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != base) {
+		memcpy(base, src, n * size);
+		dst = src;
+	}
+
+	for (i = 0; i <= nthreads; i++)
+		free(jobs[i].s.tmp);
+
+	free(dst);
+	free(runs);
+	free(jobs);
+}
+
+struct sort_stats sort_stats_dump(FILE *out)
+{
+	struct sort_stats s = { 0 };
+
+#ifdef ALGS_STATS
+	s.pdq_fallbacks = __atomic_load_n(&stats.pdq_fallbacks,
+					  __ATOMIC_RELAXED);
+	s.pdq_shortcuts = __atomic_load_n(&stats.pdq_shortcuts,
+					  __ATOMIC_RELAXED);
+	s.radix_passes  = __atomic_load_n(&stats.radix_passes,
+					  __ATOMIC_RELAXED);
+	s.radix_skipped = __atomic_load_n(&stats.radix_skipped,
+					  __ATOMIC_RELAXED);
+#endif
+
+	if (out) {
+		STATS_PRINT(out, "sort", s, pdq_fallbacks);
+		STATS_PRINT(out, "sort", s, pdq_shortcuts);
+		STATS_PRINT(out, "sort", s, radix_passes);
+		STATS_PRINT(out, "sort", s, radix_skipped);
+	}
+
+	return s;
+}
@@ -1,10 +1,43 @@
+#define _POSIX_C_SOURCE 200809L // For pthreads.
+
+#include <limits.h>             // For UCHAR_MAX.
+#include <pthread.h>            // For pthread_create() and pthread_join().
+
 #include <strmatch.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>          // For the SSE2 and AVX2 intrinsics.
+#define STRMATCH_X86
+#endif
+
 #define ALPH_SZ     2048  // Account for all one- and two-byte utf-8 chars.
 #define LARGE_PRIME 497   // So that d * q fits within one computer word.
 
+/* Reports a match at offset i, bailing out if the visitor asks to stop. */
+#define REPORT_MATCH(visit, arg, matches, i)                                    \
+                                                                                \
+	do {                                                                    \
+		(matches)++;                                                    \
+                                                                                \
+		if ((visit) && (visit)((i), (arg)))                             \
+			return (matches);                                       \
+	} while (0)
+
+/* Verifies a hit of the SIMD filter at offset i, counting it. */
+#define SIMD_VERIFY(txt, pat, m, i)                                             \
+	(STATS_ATOMIC_INC(stats, simd_hits),                                    \
+	 memcmp((txt) + (i) + 1, (pat) + 1, INNER_LEN(m)) ?                     \
+	 (STATS_ATOMIC_INC(stats, simd_false_positives), 0) : 1)
+
+#ifdef ALGS_STATS
+static struct strmatch_stats stats;
+#endif
+
+/* Number of chars. compared by memcmp() once the first and last ones match. */
+#define INNER_LEN(m) ((m) > 2 ? (m) - 2 : 0)
+
 /* Performs modular exponentiation: (base ^ exp) % mod. */
-static inline int mod_exp(int base, int exp, int mod)
+static inline int mod_exp(int base, size_t exp, int mod)
 {
 	int ret = 1;
 
@@ -23,15 +56,19 @@ static inline int mod_exp(int base, int exp, int mod)
 	return ret;
 }
 
-/* Counts the numbers of times _pat_ is found in _txt_. */
-static inline int __strmatch_rk(char *txt, const char *pat, int d, int q)
+/* Reports every occurrence of _pat_ in _txt_. Chars. are hashed as unsigned
+ * values, so that multi-byte utf-8 chars. don't yield negative hashes. */
+static inline size_t __strmatch_rk(const unsigned char *txt, size_t n,
+				   const unsigned char *pat, size_t m, int d,
+				   int q, strmatch_visit visit, void *arg)
 {
-	int n = strlen(txt);           // Length of the text.
-	int m = strlen(pat);           // Length of the pattern.
 	int h = mod_exp(d, m - 1, q);  // Value of the higher order char.
 	int p = 0;                     // Hash of pattern.
 	int t = 0;                     // Hash of each m-char substring of the text.
-	int i, j, matches = 0;
+	size_t i, matches = 0;
+
+	if (!m || m > n)
+		return 0;
 
 	for (i = 0; i < m; i++) {
 		p = (d * p + pat[i]) % q;
@@ -40,12 +77,12 @@ static inline int __strmatch_rk(char *txt, const char *pat, int d, int q)
 
 	for (i = 0; i <= n - m; i++) {
 		if (p == t) {
-			for (j = 0; j < m; j++)
-				if (txt[i + j] != pat[j])
-					break;
+			STATS_ATOMIC_INC(stats, rk_hits);
 
-			if (j == m)
-				matches++;
+			if (!memcmp(txt + i, pat, m))
+				REPORT_MATCH(visit, arg, matches, i);
+			else
+				STATS_ATOMIC_INC(stats, rk_false_positives);
 		}
 
 		if (i < n - m) {
@@ -59,12 +96,722 @@ static inline int __strmatch_rk(char *txt, const char *pat, int d, int q)
 	return matches;
 }
 
+/* The SIMD matchers below implement the "generic SIMD" filter described in [1]:
+ * the first and last chars. of the pattern are broadcast to a vector register,
+ * and compared against the text at offsets i and i + m - 1 for a whole block of
+ * positions at once. Only those positions where both chars. match are verified
+ * with memcmp(). Positions that don't fill a whole block are matched by the
+ * scalar path.
+ *
+ * [1] http://0x80.pl/articles/simd-strfind.html. */
+
+/* Scalar variant of the filter. Also used for the tail of the vector ones. */
+static size_t __strmatch_scalar(const char *txt, size_t from, size_t n,
+				const char *pat, size_t m, strmatch_visit visit,
+				void *arg, size_t matches)
+{
+	const char first = pat[0], last = pat[m - 1];
+	size_t i;
+
+	for (i = from; i <= n - m; i++)
+		if (txt[i] == first && txt[i + m - 1] == last &&
+		    SIMD_VERIFY(txt, pat, m, i))
+			REPORT_MATCH(visit, arg, matches, i);
+
+	return matches;
+}
+
+static size_t strmatch_scalar(const char *txt, size_t n, const char *pat,
+			      size_t m, strmatch_visit visit, void *arg)
+{
+	return __strmatch_scalar(txt, 0, n, pat, m, visit, arg, 0);
+}
+
+#ifdef STRMATCH_X86
+
+static size_t strmatch_sse2(const char *txt, size_t n, const char *pat,
+			    size_t m, strmatch_visit visit, void *arg)
+{
+	const __m128i first = _mm_set1_epi8(pat[0]);
+	const __m128i last  = _mm_set1_epi8(pat[m - 1]);
+	__m128i block_first, block_last;
+	unsigned int mask;
+	size_t i, bit, matches = 0;
+
+	for (i = 0; i + 16 + m - 1 <= n; i += 16) {
+		block_first = _mm_loadu_si128((const __m128i *) (txt + i));
+		block_last  = _mm_loadu_si128((const __m128i *) (txt + i + m - 1));
+
+		mask = _mm_movemask_epi8(
+			_mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+				      _mm_cmpeq_epi8(last, block_last)));
+
+		for (; mask; mask &= mask - 1) {
+			bit = __builtin_ctz(mask);
+
+			if (SIMD_VERIFY(txt, pat, m, i + bit))
+				REPORT_MATCH(visit, arg, matches, i + bit);
+		}
+	}
+
+	return __strmatch_scalar(txt, i, n, pat, m, visit, arg, matches);
+}
+
+__attribute__ ((target ("avx2")))
+static size_t strmatch_avx2(const char *txt, size_t n, const char *pat,
+			    size_t m, strmatch_visit visit, void *arg)
+{
+	const __m256i first = _mm256_set1_epi8(pat[0]);
+	const __m256i last  = _mm256_set1_epi8(pat[m - 1]);
+	__m256i block_first, block_last;
+	unsigned int mask;
+	size_t i, bit, matches = 0;
+
+	for (i = 0; i + 32 + m - 1 <= n; i += 32) {
+		block_first = _mm256_loadu_si256((const __m256i *) (txt + i));
+		block_last  = _mm256_loadu_si256(
+			(const __m256i *) (txt + i + m - 1));
+
+		mask = _mm256_movemask_epi8(
+			_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+					 _mm256_cmpeq_epi8(last, block_last)));
+
+		for (; mask; mask &= mask - 1) {
+			bit = __builtin_ctz(mask);
+
+			if (SIMD_VERIFY(txt, pat, m, i + bit))
+				REPORT_MATCH(visit, arg, matches, i + bit);
+		}
+	}
+
+	return __strmatch_scalar(txt, i, n, pat, m, visit, arg, matches);
+}
+
+#endif // STRMATCH_X86
+
+/* Picked once, at startup, according to what the CPU supports. */
+static strmatch_algo simd_fn = strmatch_scalar;
+
+__attribute__ ((constructor))
+static void strmatch_simd_init(void)
+{
+#ifdef STRMATCH_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		simd_fn = strmatch_avx2;
+	else if (__builtin_cpu_supports("sse2"))
+		simd_fn = strmatch_sse2;
+#endif
+}
+
+/* Horspool's simplification of Boyer-Moore [2]: the text is scanned from the
+ * last char. of each window, and the window is shifted according to where that
+ * char. last occurs in the pattern (excluding its very last position.)
+ *
+ * [2] "Practical fast searching in strings", by R. N. Horspool. */
+static size_t __strmatch_bmh(const unsigned char *txt, size_t n,
+			     const unsigned char *pat, size_t m,
+			     strmatch_visit visit, void *arg)
+{
+	size_t shift[UCHAR_MAX + 1], i, matches = 0;
+	unsigned char c;
+
+	for (i = 0; i <= UCHAR_MAX; i++)
+		shift[i] = m;
+
+	for (i = 0; i < m - 1; i++)
+		shift[pat[i]] = m - 1 - i;
+
+	for (i = 0; i <= n - m; i += shift[c]) {
+		c = txt[i + m - 1];
+
+		if (c == pat[m - 1] && !memcmp(txt + i, pat, m - 1))
+			REPORT_MATCH(visit, arg, matches, i);
+	}
+
+	return matches;
+}
+
+/* Knuth-Morris-Pratt [1]: _pi_ holds the prefix function of the pattern, i.e.
+ * the length of the longest proper prefix of pat[0..q] that's also a suffix of
+ * it. The text is never backed up. */
+static size_t __strmatch_kmp(const unsigned char *txt, size_t n,
+			     const unsigned char *pat, size_t m,
+			     strmatch_visit visit, void *arg)
+{
+	size_t *pi = malloc(m * sizeof(size_t));
+	size_t i, q, matches = 0;
+
+	/* Without room for the table, the scalar filter (which needs none) finds
+	 * the same matches. */
+	if (!pi)
+		return strmatch_scalar((const char *) txt, n,
+				       (const char *) pat, m, visit, arg);
+
+	pi[0] = 0;
+
+	for (i = 1, q = 0; i < m; i++) {
+		while (q && pat[q] != pat[i])
+			q = pi[q - 1];
+
+		if (pat[q] == pat[i])
+			q++;
+
+		pi[i] = q;
+	}
+
+	for (i = 0, q = 0; i < n; i++) {
+		while (q && pat[q] != txt[i])
+			q = pi[q - 1];
+
+		if (pat[q] == txt[i])
+			q++;
+
+		if (q == m) {
+			q = pi[q - 1];
+			matches++;
+
+			if (visit && visit(i + 1 - m, arg))
+				break;
+		}
+	}
+
+	free(pi);
+
+	return matches;
+}
+
+/* Computes the maximal suffix of _pat_ for the (reversed, if _rev_) ordering of
+ * the alphabet, along with its period. Returns the position preceding it. */
+static ptrdiff_t max_suffix(const unsigned char *pat, ptrdiff_t m, int rev,
+			    ptrdiff_t *per)
+{
+	ptrdiff_t ms = -1, j = 0, k = 1;
+	unsigned char a, b;
+
+	*per = 1;
+
+	while (j + k < m) {
+		a = pat[j + k];
+		b = pat[ms + k];
+
+		if (a == b) {
+			if (k == *per) {
+				j += *per;
+				k  = 1;
+			} else {
+				k++;
+			}
+		} else if ((a < b) != rev) {
+			j   += k;
+			k    = 1;
+			*per = j - ms;
+		} else {
+			ms   = j;
+			j    = ms + 1;
+			k    = 1;
+			*per = 1;
+		}
+	}
+
+	return ms;
+}
+
+/* Two-Way string matching, due to Crochemore and Perrin [3]. The pattern is
+ * split at a critical factorization (ell); the right half is matched left to
+ * right, and then the left half right to left. Runs in linear time in the
+ * worst case, using constant extra space. When the pattern is periodic, the
+ * length of the prefix known to match after a shift is remembered in _mem_.
+ *
+ * [3] "Two-way string-matching", by M. Crochemore and D. Perrin. */
+static size_t __strmatch_tw(const unsigned char *txt, size_t n,
+			    const unsigned char *pat, size_t _m,
+			    strmatch_visit visit, void *arg)
+{
+	ptrdiff_t m = _m, last = n - _m;
+	ptrdiff_t i, j, ell, mem, per, per_rev, ms, ms_rev;
+	size_t matches = 0;
+
+	ms     = max_suffix(pat, m, 0, &per);
+	ms_rev = max_suffix(pat, m, 1, &per_rev);
+
+	if (ms > ms_rev) {
+		ell = ms;
+	} else {
+		ell = ms_rev;
+		per = per_rev;
+	}
+
+	if (!memcmp(pat, pat + per, ell + 1)) {
+		for (j = 0, mem = -1; j <= last;) {
+			i = (ell > mem ? ell : mem) + 1;
+
+			while (i < m && pat[i] == txt[i + j])
+				i++;
+
+			if (i < m) {
+				j  += i - ell;
+				mem = -1;
+				continue;
+			}
+
+			for (i = ell; i > mem && pat[i] == txt[i + j]; i--)
+				;
+
+			if (i <= mem)
+				REPORT_MATCH(visit, arg, matches, (size_t) j);
+
+			j  += per;
+			mem = m - per - 1;
+		}
+	} else {
+		per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+
+		for (j = 0; j <= last;) {
+			i = ell + 1;
+
+			while (i < m && pat[i] == txt[i + j])
+				i++;
+
+			if (i < m) {
+				j += i - ell;
+				continue;
+			}
+
+			for (i = ell; i >= 0 && pat[i] == txt[i + j]; i--)
+				;
+
+			if (i < 0)
+				REPORT_MATCH(visit, arg, matches, (size_t) j);
+
+			j += per;
+		}
+	}
+
+	return matches;
+}
+
+/* Counts the number of distinct chars. in _pat_. */
+static int alphabet_size(const unsigned char *pat, size_t m)
+{
+	unsigned char seen[UCHAR_MAX + 1] = { 0 };
+	size_t i;
+	int sz = 0;
+
+	for (i = 0; i < m; i++)
+		if (!seen[pat[i]]++)
+			sz++;
+
+	return sz;
+}
+
+/* Output array filled in by strmatch_offsets(). */
+struct offsets {
+	size_t *offs;
+	size_t sz;
+	size_t n;
+};
+
+static int record_offset(size_t off, void *arg)
+{
+	struct offsets *o = (struct offsets *) arg;
+
+	o->offs[o->n++] = off;
+
+	return o->n == o->sz;
+}
+
+/* Output array filled in by strmatch_simd(), which keeps on counting once the
+ * array is full. */
+struct int_offsets {
+	int *offs;
+	int sz;
+	int n;
+};
+
+static int record_int_offset(size_t off, void *arg)
+{
+	struct int_offsets *o = (struct int_offsets *) arg;
+
+	if (o->n < o->sz)
+		o->offs[o->n] = (int) off;
+
+	o->n++;
+
+	return 0;
+}
+
+/* Translates offsets within the text being matched into stream offsets. */
+static int stream_visit(size_t off, void *arg)
+{
+	struct strmatch_stream *s = (struct strmatch_stream *) arg;
+
+	s->matches++;
+
+	if (s->visit && s->visit(s->base + off, s->arg))
+		s->stopped = 1;
+
+	return s->stopped;
+}
+
+/* A chunk of text matched by one of the threads of strmatch_parallel(). Chunks
+ * own the matches _starting_ within [start, start + len), yet they extend m - 1
+ * chars. past it, so that no match is lost at the boundaries and none is found
+ * twice. Offsets are only collected when there's a visitor to report them to. */
+struct strmatch_chunk {
+	const char    *txt;
+	size_t        start;
+	size_t        len;
+
+	const char    *pat;
+	size_t        m;
+	strmatch_algo algo;
+
+	size_t        *offs;
+	size_t        n;
+	size_t        sz;
+	int           collect;
+	size_t        matches;
+	int           threaded;
+};
+
+static int chunk_visit(size_t off, void *arg)
+{
+	struct strmatch_chunk *c = (struct strmatch_chunk *) arg;
+
+	if (c->n == c->sz) {
+		c->sz   = c->sz ? 2 * c->sz : 64;
+		c->offs = realloc(c->offs, c->sz * sizeof(size_t));
+	}
+
+	c->offs[c->n++] = c->start + off;
+
+	return 0;
+}
+
+static void *chunk_run(void *arg)
+{
+	struct strmatch_chunk *c = (struct strmatch_chunk *) arg;
+
+	c->matches = c->algo(c->txt + c->start, c->len + c->m - 1, c->pat,
+			     c->m, c->collect ? chunk_visit : NULL, c);
+
+	return NULL;
+}
+
 /* --- API --- */
 
 int strmatch_rk(char *txt, const char *pat)
 {
-	int d = ALPH_SZ;
-	int p = LARGE_PRIME;
+	return strmatch_rk_buf(txt, strlen(txt), pat, strlen(pat), NULL, NULL);
+}
+
+/* Counts the number of times _pat_ is found in _txt_, and stores the offsets of
+ * the first _sz_ matches in _offs_ (which may be NULL.) */
+int strmatch_simd(const char *txt, const char *pat, int *offs, int sz)
+{
+	struct int_offsets o = { offs, offs ? sz : 0, 0 };
+
+	strmatch_simd_buf(txt, strlen(txt), pat, strlen(pat),
+			  record_int_offset, &o);
+
+	return o.n;
+}
+
+/* Returns the name of the variant picked at startup. */
+const char *strmatch_simd_isa(void)
+{
+#ifdef STRMATCH_X86
+	if (simd_fn == strmatch_avx2)
+		return "avx2";
+	if (simd_fn == strmatch_sse2)
+		return "sse2";
+#endif
+	return "scalar";
+}
+
+size_t strmatch_rk_buf(const char *txt, size_t n, const char *pat, size_t m,
+		       strmatch_visit visit, void *arg)
+{
+	return __strmatch_rk((const unsigned char *) txt, n,
+			     (const unsigned char *) pat, m, ALPH_SZ,
+			     LARGE_PRIME, visit, arg);
+}
+
+size_t strmatch_simd_buf(const char *txt, size_t n, const char *pat, size_t m,
+			 strmatch_visit visit, void *arg)
+{
+	if (!m || m > n)
+		return 0;
+
+	return simd_fn(txt, n, pat, m, visit, arg);
+}
+
+/* Stores the offsets of (at most) the first _sz_ matches found by _algo_ in
+ * _offs_, stopping early once it's full. Returns the number of offsets stored. */
+size_t strmatch_offsets(strmatch_algo algo, const char *txt, size_t n,
+			const char *pat, size_t m, size_t *offs, size_t sz)
+{
+	struct offsets o = { offs, sz, 0 };
+
+	if (!sz)
+		return 0;
+
+	algo(txt, n, pat, m, record_offset, &o);
+
+	return o.n;
+}
+
+struct strmatch_stats strmatch_stats_dump(FILE *out)
+{
+	struct strmatch_stats s = { 0 };
+
+#ifdef ALGS_STATS
+	s.rk_hits = __atomic_load_n(&stats.rk_hits, __ATOMIC_RELAXED);
+	s.rk_false_positives =
+		__atomic_load_n(&stats.rk_false_positives, __ATOMIC_RELAXED);
+	s.simd_hits = __atomic_load_n(&stats.simd_hits, __ATOMIC_RELAXED);
+	s.simd_false_positives =
+		__atomic_load_n(&stats.simd_false_positives, __ATOMIC_RELAXED);
+#endif
+
+	if (out) {
+		STATS_PRINT(out, "strmatch", s, rk_hits);
+		STATS_PRINT(out, "strmatch", s, rk_false_positives);
+		STATS_PRINT(out, "strmatch", s, simd_hits);
+		STATS_PRINT(out, "strmatch", s, simd_false_positives);
+	}
+
+	return s;
+}
+
+struct strmatch_stream *strmatch_stream_init(const char *pat, size_t m,
+					     strmatch_visit visit, void *arg)
+{
+	struct strmatch_stream *s;
+
+	if (!m)
+		return NULL;
+
+	s = malloc(sizeof(struct strmatch_stream));
+
+	s->pat = malloc(m);
+	memcpy(s->pat, pat, m);
+	s->m = m;
+
+	s->win  = malloc(2 * (m - 1) + 1);
+	s->tail = 0;
+
+	s->base    = 0;
+	s->matches = 0;
+	s->stopped = 0;
+
+	s->visit = visit;
+	s->arg   = arg;
+
+	return s;
+}
+
+/* Returns the number of matches found in the chunk, including those starting
+ * in the tail carried over from previous chunks. */
+size_t strmatch_stream_feed(struct strmatch_stream *s, const char *txt,
+			    size_t n)
+{
+	size_t m = s->m, head = n < m - 1 ? n : m - 1, before = s->matches;
+
+	if (s->stopped || !n)
+		return 0;
+
+	/* First, the matches straddling the boundary. Since the window is
+	 * shorter than 2m - 1 chars., all of them start in the tail. */
+	memcpy(s->win + s->tail, txt, head);
+	s->base -= s->tail;
+
+	if (s->tail)
+		strmatch_simd_buf(s->win, s->tail + head, s->pat, m,
+				  stream_visit, s);
+
+	s->base += s->tail;
+
+	/* Then, the ones lying within the chunk. */
+	if (!s->stopped)
+		strmatch_simd_buf(txt, n, s->pat, m, stream_visit, s);
 
-	return __strmatch_rk(txt, pat, d, p);
+	/* Finally, carry the last m - 1 chars. over to the next chunk. */
+	if (n >= m - 1) {
+		memcpy(s->win, txt + n - (m - 1), m - 1);
+		s->tail = m - 1;
+	} else {
+		s->tail += head;
+
+		if (s->tail > m - 1) {
+			memmove(s->win, s->win + s->tail - (m - 1), m - 1);
+			s->tail = m - 1;
+		}
+	}
+
+	s->base += n;
+
+	return s->matches - before;
+}
+
+/* Deallocs. the matcher. Returns the total number of matches found. */
+size_t strmatch_stream_finish(struct strmatch_stream *s)
+{
+	size_t matches = s->matches;
+
+	free(s->pat);
+	free(s->win);
+	free(s);
+
+	return matches;
+}
+
+size_t strmatch_bmh_buf(const char *txt, size_t n, const char *pat, size_t m,
+			strmatch_visit visit, void *arg)
+{
+	if (!m || m > n)
+		return 0;
+
+	return __strmatch_bmh((const unsigned char *) txt, n,
+			      (const unsigned char *) pat, m, visit, arg);
+}
+
+size_t strmatch_kmp_buf(const char *txt, size_t n, const char *pat, size_t m,
+			strmatch_visit visit, void *arg)
+{
+	if (!m || m > n)
+		return 0;
+
+	return __strmatch_kmp((const unsigned char *) txt, n,
+			      (const unsigned char *) pat, m, visit, arg);
+}
+
+size_t strmatch_tw_buf(const char *txt, size_t n, const char *pat, size_t m,
+		       strmatch_visit visit, void *arg)
+{
+	if (!m || m > n)
+		return 0;
+
+	return __strmatch_tw((const unsigned char *) txt, n,
+			     (const unsigned char *) pat, m, visit, arg);
+}
+
+/* Picks a matcher according to what the CPU supports, the lengths of the text
+ * and the pattern, and the number of distinct chars. in the pattern:
+ *
+ *  - Wherever a vector variant of the SIMD filter runs, it's used: it checks
+ *    16 or 32 positions per step, which outruns Horspool's skips at every
+ *    pattern length, even over small alphabets (see bench_strmatch.c.)
+ *  - Otherwise, short patterns or texts are matched with the scalar filter,
+ *    whose cost per position is lowest as long as the first/last chars. are
+ *    selective enough.
+ *  - Long patterns drawn from a large alphabet are matched with Horspool, as
+ *    shifts tend to be close to m chars.
+ *  - Long patterns drawn from a small alphabet (e.g. DNA, binary) make for
+ *    short Horspool shifts and frequent false positives of the filter, so
+ *    Two-Way is used for its linear worst case. */
+strmatch_algo strmatch_select(size_t n, const char *pat, size_t m)
+{
+	if (simd_fn != strmatch_scalar)
+		return strmatch_simd_buf;
+
+	if (m < STRMATCH_LONG_PAT || n < STRMATCH_SHORT_TXT)
+		return strmatch_simd_buf;
+
+	if (alphabet_size((const unsigned char *) pat, m) < STRMATCH_SMALL_ALPH)
+		return strmatch_tw_buf;
+
+	return strmatch_bmh_buf;
+}
+
+size_t strmatch(const char *txt, size_t n, const char *pat, size_t m,
+		strmatch_visit visit, void *arg)
+{
+	if (!m || m > n)
+		return 0;
+
+	return strmatch_select(n, pat, m)(txt, n, pat, m, visit, arg);
+}
+
+/* Splits _txt_ into (at most) _nthreads_ chunks and matches each of them in its
+ * own thread, with the matcher picked by strmatch_select(). Matches are then
+ * reported in order, once all threads are done. */
+size_t strmatch_parallel(const char *txt, size_t n, const char *pat, size_t m,
+			 int nthreads, strmatch_visit visit, void *arg)
+{
+	struct strmatch_chunk *chunks;
+	pthread_t *threads;
+	size_t k, len, matches = 0;
+	int t, stop = 0;
+
+	if (!m || m > n)
+		return 0;
+
+	/* Positions where a match may start, split evenly among threads. */
+	len = n - m + 1;
+
+	/* No more threads than asked for, nor than there are chunks of at
+	 * least STRMATCH_MIN_CHUNK positions. */
+	if (nthreads < 1)
+		nthreads = 1;
+
+	if ((size_t) nthreads > len / STRMATCH_MIN_CHUNK)
+		nthreads = len / STRMATCH_MIN_CHUNK ? len / STRMATCH_MIN_CHUNK : 1;
+
+	if (nthreads == 1)
+		return strmatch(txt, n, pat, m, visit, arg);
+
+	chunks  = malloc(nthreads * sizeof(struct strmatch_chunk));
+	threads = malloc(nthreads * sizeof(pthread_t));
+
+	if (!chunks || !threads) {
+		free(chunks);
+		free(threads);
+		return strmatch(txt, n, pat, m, visit, arg);
+	}
+
+	for (t = 0; t < nthreads; t++) {
+		chunks[t].txt   = txt;
+		chunks[t].start = len / nthreads * t;
+		chunks[t].len   = t < nthreads - 1 ? len / nthreads :
+			len - chunks[t].start;
+
+		chunks[t].pat  = pat;
+		chunks[t].m    = m;
+		chunks[t].algo = strmatch_select(n, pat, m);
+
+		chunks[t].offs    = NULL;
+		chunks[t].n       = 0;
+		chunks[t].sz      = 0;
+		chunks[t].collect = visit != NULL;
+
+		/* A chunk whose thread can't be started is matched here. */
+		chunks[t].threaded = !pthread_create(&threads[t], NULL,
+						     chunk_run, &chunks[t]);
+
+		if (!chunks[t].threaded)
+			chunk_run(&chunks[t]);
+	}
+
+	for (t = 0; t < nthreads; t++) {
+		if (chunks[t].threaded)
+			pthread_join(threads[t], NULL);
+
+		if (!visit)
+			matches += chunks[t].matches;
+
+		for (k = 0; !stop && k < chunks[t].n; k++) {
+			matches++;
+			stop = visit(chunks[t].offs[k], arg);
+		}
+
+		free(chunks[t].offs);
+	}
+
+	free(threads);
+	free(chunks);
+
+	return matches;
 }
@@ -0,0 +1,121 @@
+#include <string.h>             // For memmove().
+
+#include "ulist.h"
+
+#define FIRST_CHUNK(_list)                                                      \
+	list_first_entry(&(_list)->chunks, struct ulist_chunk, list)
+
+#define LAST_CHUNK(_list)                                                       \
+	list_entry((_list)->chunks.prev, struct ulist_chunk, list)
+
+/* Allocs. an empty chunk whose elements start at _at_. */
+static inline struct ulist_chunk *make_ulist_chunk(int at)
+{
+	struct ulist_chunk *chunk = malloc(sizeof(struct ulist_chunk));
+
+	INIT_LIST_HEAD(&chunk->list);
+
+	chunk->start = at;
+	chunk->end   = at;
+
+	return chunk;
+}
+
+/* --- API --- */
+
+struct ulist *make_ulist(void)
+{
+	struct ulist *list = malloc(sizeof(struct ulist));
+
+	INIT_LIST_HEAD(&list->chunks);
+	list->n = 0;
+
+	return list;
+}
+
+/* A new chunk at the head is filled from its end, so that further insertions
+ * at the head land in it. */
+void ulist_add(void *elem, struct ulist *l)
+{
+	struct ulist_chunk *c;
+
+	if (ulist_empty(l) || !(c = FIRST_CHUNK(l))->start) {
+		c = make_ulist_chunk(ULIST_CHUNK_SZ);
+		list_add(&c->list, &l->chunks);
+	}
+
+	c->elems[--c->start] = elem;
+	l->n++;
+}
+
+/* Likewise, a new chunk at the tail is filled from its start. */
+void ulist_add_tail(void *elem, struct ulist *l)
+{
+	struct ulist_chunk *c;
+
+	if (ulist_empty(l) || (c = LAST_CHUNK(l))->end == (int) ULIST_CHUNK_SZ) {
+		c = make_ulist_chunk(0);
+		list_add_tail(&c->list, &l->chunks);
+	}
+
+	c->elems[c->end++] = elem;
+	l->n++;
+}
+
+/* Removes the element at index _i_ of chunk _c_, moving the shorter side of the
+ * chunk over it. Chunks left empty are freed. When deleting while iterating,
+ * the iteration must be abandoned. */
+void ulist_del(struct ulist *l, struct ulist_chunk *c, int i)
+{
+	if (i - c->start < c->end - 1 - i) {
+		memmove(&c->elems[c->start + 1], &c->elems[c->start],
+			(i - c->start) * sizeof(void *));
+		c->start++;
+	} else {
+		memmove(&c->elems[i], &c->elems[i + 1],
+			(c->end - 1 - i) * sizeof(void *));
+		c->end--;
+	}
+
+	if (c->start == c->end) {
+		list_del(&c->list);
+		free(c);
+	}
+
+	l->n--;
+}
+
+int ulist_empty(struct ulist *l)
+{
+	return list_empty(&l->chunks);
+}
+
+/* Moves the chunks of _list_ to the head of _head_, leaving _list_ empty. */
+void ulist_splice(struct ulist *list, struct ulist *head)
+{
+	list_splice(&list->chunks, &head->chunks);
+	head->n += list->n;
+
+	INIT_LIST_HEAD(&list->chunks);
+	list->n = 0;
+}
+
+void ulist_splice_tail(struct ulist *list, struct ulist *head)
+{
+	list_splice_tail(&list->chunks, &head->chunks);
+	head->n += list->n;
+
+	INIT_LIST_HEAD(&list->chunks);
+	list->n = 0;
+}
+
+/* Deallocs. the chunks, but not the elements they point to. */
+void ulist_destroy(struct ulist *l)
+{
+	struct ulist_chunk *c, *next;
+
+	list_for_each_entry_safe(c, next, &l->chunks, list)
+		free(c);
+
+	free(l);
+}